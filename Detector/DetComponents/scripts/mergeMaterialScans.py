@@ -0,0 +1,107 @@
+#!/usr/bin/env python
+"""Merge the shards of a material scan (MaterialScan_2D_genericAngle with nShards > 1)
+into the output a single job scanning all bins would produce.
+
+The shards are ordered by their index stored in the tree 'shardInfo' and checked to be
+complete and contiguous before the 'materials' trees are concatenated.
+Optionally the merged scan is compared entry by entry with a reference scan.
+"""
+import argparse
+import sys
+
+import ROOT
+
+
+def read_shard_info(file_name):
+    root_file = ROOT.TFile.Open(file_name)
+    if not root_file or root_file.IsZombie():
+        sys.exit("Unable to open " + file_name)
+    info_tree = root_file.Get("shardInfo")
+    materials = root_file.Get("materials")
+    if not info_tree or not materials or info_tree.GetEntry(0) <= 0:
+        sys.exit(file_name + " is not a material scan shard")
+    info = {"file": file_name,
+            "shard": info_tree.shard,
+            "nShards": info_tree.nShards,
+            "firstEntry": info_tree.firstEntry,
+            "endEntry": info_tree.endEntry,
+            "nEntries": materials.GetEntries()}
+    root_file.Close()
+    return info
+
+
+def check_shards(shards):
+    n_shards = shards[0]["nShards"]
+    if [s["shard"] for s in shards] != list(range(n_shards)) or any(s["nShards"] != n_shards for s in shards):
+        sys.exit("Expected shards 0 to {} of one scan, found {}".format(n_shards - 1, [s["shard"] for s in shards]))
+    next_entry = 0
+    for s in shards:
+        if s["firstEntry"] != next_entry:
+            sys.exit("{} starts at entry {}, expected {}".format(s["file"], s["firstEntry"], next_entry))
+        if s["nEntries"] != s["endEntry"] - s["firstEntry"]:
+            sys.exit("{} is incomplete: {} of {} entries, resume the job".format(
+                s["file"], s["nEntries"], s["endEntry"] - s["firstEntry"]))
+        next_entry = s["endEntry"]
+    return next_entry
+
+
+def merge(output_name, shards, n_entries):
+    chain = ROOT.TChain("materials")
+    for s in shards:
+        chain.Add(s["file"])
+    output = ROOT.TFile.Open(output_name, "RECREATE")
+    merged = chain.CloneTree(-1, "fast")
+    merged.Write()
+    # the merged scan is a single shard covering all entries
+    info_tree = ROOT.TTree("shardInfo", "")
+    values = {"shard": (ROOT.std.vector("unsigned int")(1, 0), "i"),
+              "nShards": (ROOT.std.vector("unsigned int")(1, 1), "i"),
+              "firstEntry": (ROOT.std.vector("unsigned long long")(1, 0), "l"),
+              "endEntry": (ROOT.std.vector("unsigned long long")(1, n_entries), "l")}
+    for name, (value, leaf_type) in values.items():
+        info_tree.Branch(name, value.data(), "{}/{}".format(name, leaf_type))
+    info_tree.Fill()
+    info_tree.Write()
+    output.Close()
+
+
+def compare(output_name, reference_name):
+    trees = []
+    files = []
+    for name in (output_name, reference_name):
+        root_file = ROOT.TFile.Open(name)
+        files.append(root_file)
+        trees.append(root_file.Get("materials"))
+    merged, reference = trees
+    if merged.GetEntries() != reference.GetEntries():
+        return "{} entries merged, {} in the reference".format(merged.GetEntries(), reference.GetEntries())
+    branches = [b.GetName() for b in reference.GetListOfBranches()]
+    for entry in range(reference.GetEntries()):
+        merged.GetEntry(entry)
+        reference.GetEntry(entry)
+        for branch in branches:
+            value = getattr(merged, branch)
+            expected = getattr(reference, branch)
+            if hasattr(expected, "size"):
+                value, expected = list(value), list(expected)
+            if value != expected:
+                return "entry {} differs in {}".format(entry, branch)
+    return None
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("output", help="merged output file")
+    parser.add_argument("shards", nargs="+", help="output files of the shards, in any order")
+    parser.add_argument("--reference", help="scan of all bins to compare the merged scan with")
+    args = parser.parse_args()
+
+    shards = sorted((read_shard_info(name) for name in args.shards), key=lambda s: s["shard"])
+    n_entries = check_shards(shards)
+    merge(args.output, shards, n_entries)
+    print("Merged {} entries of {} shards into {}".format(n_entries, len(shards), args.output))
+    if args.reference:
+        difference = compare(args.output, args.reference)
+        if difference:
+            sys.exit("Merged scan differs from the reference {}: {}".format(args.reference, difference))
+        print("Merged scan is identical to the reference " + args.reference)
@@ -0,0 +1,140 @@
+#ifndef DETCOMPONENTS_CALOHITACCUMULATOR_H
+#define DETCOMPONENTS_CALOHITACCUMULATOR_H
+
+// DD4hep
+#include "DDSegmentation/BitFieldCoder.h"
+
+// datamodel
+#include "edm4hep/CalorimeterHitCollection.h"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace det {
+/** @class det::CaloHitAccumulator Detector/DetComponents/src/CaloHitAccumulator.h CaloHitAccumulator.h
+ *
+ *  Combines calorimeter hits with the same cellID into one hit per cell.
+ *  The energy is summed, the energy errors are added in quadrature, position and time are
+ *  averaged with the energy as weight (plain average if the sum of energies is not positive).
+ *  The type is taken from the first hit of the cell. The cells are written in the order of
+ *  their first hit, so the output does not depend on the hash map.
+ *  The cells are found with a flat open-addressing hash table (linear probing, at most half
+ *  full) holding the positions of the cells, so a lookup touches one contiguous array and the
+ *  cell itself, without the node allocations of std::unordered_map.
+ */
+class CaloHitAccumulator {
+public:
+  using CellID = dd4hep::DDSegmentation::CellID;
+
+  /// Prepare for the number of hits
+  void reserve(size_t aNumHits) {
+    m_cells.reserve(aNumHits);
+    if (2 * aNumHits > m_slots.size()) {
+      rehash(2 * aNumHits);
+    }
+  }
+
+  /// Add the hit to the cell
+  void add(CellID aCellId, const edm4hep::CalorimeterHit& aHit) {
+    if (2 * (m_cells.size() + 1) > m_slots.size()) {
+      rehash(2 * (m_cells.size() + 1));
+    }
+    uint32_t* slot = find(aCellId);
+    if (*slot == 0) {
+      m_cells.emplace_back();
+      m_cells.back().cellId = aCellId;
+      m_cells.back().type = aHit.getType();
+      *slot = m_cells.size();
+    }
+    Cell& cell = m_cells[*slot - 1];
+    const double energy = aHit.getEnergy();
+    const auto& position = aHit.getPosition();
+    cell.energy += energy;
+    cell.energyError2 += double(aHit.getEnergyError()) * aHit.getEnergyError();
+    cell.weighted[0] += energy * position.x;
+    cell.weighted[1] += energy * position.y;
+    cell.weighted[2] += energy * position.z;
+    cell.weighted[3] += energy * aHit.getTime();
+    cell.plain[0] += position.x;
+    cell.plain[1] += position.y;
+    cell.plain[2] += position.z;
+    cell.plain[3] += aHit.getTime();
+    cell.numHits++;
+  }
+
+  /// Number of cells
+  size_t size() const { return m_cells.size(); }
+
+  /// Create one hit per cell in the collection
+  void fill(edm4hep::CalorimeterHitCollection& aHits) const {
+    for (const auto& cell : m_cells) {
+      const bool weighted = cell.energy > 0;
+      const double* sums = weighted ? cell.weighted : cell.plain;
+      const double norm = weighted ? cell.energy : cell.numHits;
+      auto hit = aHits.create();
+      hit.setCellID(cell.cellId);
+      hit.setEnergy(cell.energy);
+      hit.setEnergyError(std::sqrt(cell.energyError2));
+      hit.setPosition(edm4hep::Vector3f(sums[0] / norm, sums[1] / norm, sums[2] / norm));
+      hit.setTime(sums[3] / norm);
+      hit.setType(cell.type);
+    }
+  }
+
+  /// Remove all cells
+  void clear() {
+    std::fill(m_slots.begin(), m_slots.end(), 0);
+    m_cells.clear();
+  }
+
+private:
+  struct Cell {
+    CellID cellId = 0;
+    double energy = 0;
+    double energyError2 = 0;
+    /// Sums of x, y, z and time weighted by energy
+    double weighted[4] = {0, 0, 0, 0};
+    /// Plain sums of x, y, z and time
+    double plain[4] = {0, 0, 0, 0};
+    unsigned numHits = 0;
+    int type = 0;
+  };
+  /// Mix all bits of the cellID, neighbouring cells differ only in a few bits
+  static size_t hash(CellID aCellId) {
+    aCellId ^= aCellId >> 33;
+    aCellId *= 0xff51afd7ed558ccdULL;
+    aCellId ^= aCellId >> 33;
+    return aCellId;
+  }
+  /// Slot of the cell, or the empty slot where it belongs
+  uint32_t* find(CellID aCellId) {
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = hash(aCellId) & mask;; i = (i + 1) & mask) {
+      if (m_slots[i] == 0 || m_cells[m_slots[i] - 1].cellId == aCellId) {
+        return &m_slots[i];
+      }
+    }
+  }
+  /// Resize the table to a power of two of at least the given size and insert the cells again
+  void rehash(size_t aMinSize) {
+    size_t size = 16;
+    while (size < aMinSize) {
+      size *= 2;
+    }
+    m_slots.assign(size, 0);
+    for (size_t iCell = 0; iCell < m_cells.size(); iCell++) {
+      *find(m_cells[iCell].cellId) = iCell + 1;
+    }
+  }
+
+  /// Hash table of the positions of the cells in m_cells plus one, 0 for an empty slot
+  std::vector<uint32_t> m_slots;
+  /// Cells in the order of their first hit
+  std::vector<Cell> m_cells;
+};
+}
+
+#endif /* DETCOMPONENTS_CALOHITACCUMULATOR_H */
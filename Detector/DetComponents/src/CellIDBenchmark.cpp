@@ -0,0 +1,239 @@
+#include "CellIDBenchmark.h"
+#include "CellIDFields.h"
+#include "Resegmentation.h"
+
+// datamodel
+#include "edm4hep/CalorimeterHitCollection.h"
+
+// DD4hep
+#include "DD4hep/Detector.h"
+
+// STD
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+DECLARE_COMPONENT(CellIDBenchmark)
+
+namespace {
+using dd4hep::DDSegmentation::CellID;
+
+/// Time per hit of the transformation applied to all hits, in ns
+template <typename Transform>
+double timePerHit(const edm4hep::CalorimeterHitCollection& aHits, std::vector<CellID>& aOutput,
+                  Transform&& aTransform) {
+  aOutput.resize(aHits.size());
+  const auto start = std::chrono::steady_clock::now();
+  size_t iHit = 0;
+  for (const auto& hit : aHits) {
+    aOutput[iHit++] = aTransform(hit.getCellID());
+  }
+  const std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+  return duration.count() / std::max<size_t>(aHits.size(), 1);
+}
+
+/// Time per hit of the remap of the cellIDs of all hits, copied into a contiguous array first, in ns
+double timePerHitBatch(const edm4hep::CalorimeterHitCollection& aHits, std::vector<CellID>& aOutput,
+                       const det::CellIDRemap& aRemap) {
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<CellID> cellIds;
+  cellIds.reserve(aHits.size());
+  for (const auto& hit : aHits) {
+    cellIds.push_back(hit.getCellID());
+  }
+  aOutput.resize(cellIds.size());
+  aRemap.apply(cellIds.data(), aOutput.data(), cellIds.size());
+  const std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+  return duration.count() / std::max<size_t>(aHits.size(), 1);
+}
+
+/// Time per hit of the transformation applied to all hits split among concurrent threads, in ns
+/// The first exception thrown by the transformation in any of the threads is rethrown
+template <typename Transform>
+double timePerHitConcurrent(const edm4hep::CalorimeterHitCollection& aHits, std::vector<CellID>& aOutput,
+                            unsigned aNumThreads, const Transform& aTransform) {
+  std::vector<CellID> cellIds;
+  cellIds.reserve(aHits.size());
+  for (const auto& hit : aHits) {
+    cellIds.push_back(hit.getCellID());
+  }
+  aOutput.assign(cellIds.size(), 0);
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  std::vector<std::exception_ptr> exceptions(aNumThreads);
+  const size_t chunk = (cellIds.size() + aNumThreads - 1) / aNumThreads;
+  for (size_t first = 0; first < cellIds.size(); first += chunk) {
+    const size_t last = std::min(first + chunk, cellIds.size());
+    threads.emplace_back([&, first, last, iThread = threads.size()]() {
+      try {
+        for (size_t iHit = first; iHit < last; iHit++) {
+          aOutput[iHit] = aTransform(cellIds[iHit]);
+        }
+      } catch (...) {
+        exceptions[iThread] = std::current_exception();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& exception : exceptions) {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+  const std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+  return duration.count() / std::max<size_t>(aHits.size(), 1);
+}
+}
+
+CellIDBenchmark::CellIDBenchmark(const std::string& name, ISvcLocator* svcLoc)
+    : Service(name, svcLoc), m_geoSvc("GeoSvc", name) {}
+
+StatusCode CellIDBenchmark::initialize() {
+  if (Service::initialize().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  if (!m_geoSvc) {
+    error() << "Unable to find Geometry Service." << endmsg;
+    return StatusCode::FAILURE;
+  }
+  auto detector = m_geoSvc->getDetector();
+  for (const auto& readoutName : {m_oldReadoutName.value(), m_newReadoutName.value()}) {
+    if (detector->readouts().find(readoutName) == detector->readouts().end()) {
+      error() << "Readout <<" << readoutName << ">> does not exist." << endmsg;
+      return StatusCode::FAILURE;
+    }
+  }
+  const auto* oldDecoder = detector->readout(m_oldReadoutName).idSpec().decoder();
+  const auto* newDecoder = detector->readout(m_newReadoutName).idSpec().decoder();
+
+  // detector fields (= all old fields - removed ones) and the bits of all old fields
+  std::vector<std::string> detectorIdentifiers;
+  CellID fieldsMask = 0;
+  for (size_t itField = 0; itField < oldDecoder->size(); itField++) {
+    const auto& field = (*oldDecoder)[itField];
+    fieldsMask |= field.mask();
+    if (std::find(m_removeIds.begin(), m_removeIds.end(), field.name()) == m_removeIds.end()) {
+      detectorIdentifiers.push_back(field.name());
+    }
+  }
+
+  // hits with random values of all fields, any bit pattern is a valid value of the field,
+  // the fields in cellIDRanges are drawn uniformly from the given range
+  std::vector<std::pair<det::CellIDField, std::uniform_int_distribution<det::CellIDField::long64>>> rangedFields;
+  for (const auto& range : m_cellIDRanges) {
+    if (range.second.size() != 2 || range.second[0] > range.second[1]) {
+      error() << "Range of the field <<" << range.first << ">> has to be given as [min, max]" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    try {
+      rangedFields.emplace_back(det::CellIDField(*oldDecoder, range.first),
+                                std::uniform_int_distribution<det::CellIDField::long64>(range.second[0],
+                                                                                        range.second[1]));
+    } catch (const std::runtime_error& e) {
+      error() << e.what() << endmsg;
+      return StatusCode::FAILURE;
+    }
+  }
+  edm4hep::CalorimeterHitCollection hits;
+  std::mt19937_64 generator(m_seed);
+  try {
+    for (unsigned iHit = 0; iHit < m_nHits; ++iHit) {
+      CellID cellId = generator() & fieldsMask;
+      for (auto& field : rangedFields) {
+        field.first.set(cellId, field.second(generator));
+      }
+      auto hit = hits.create();
+      hit.setCellID(cellId);
+      hit.setEnergy(1.);
+    }
+  } catch (const std::runtime_error& e) {
+    error() << "Range of the field does not fit into the bitfield: " << e.what() << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  std::vector<CellID> byName;
+  std::vector<CellID> precompiled;
+  try {
+    std::vector<det::CellIDFieldCopy> detectorFields =
+        det::resolveFieldCopies(*oldDecoder, *newDecoder, detectorIdentifiers);
+    CellID removedMask = 0;
+    for (const auto& identifier : m_removeIds) {
+      removedMask |= det::CellIDField(*oldDecoder, identifier).mask();
+    }
+
+    // RewriteBitfield
+    const double rewriteByName = timePerHit(hits, byName, [&](CellID cellId) {
+      CellID newId = 0;
+      for (const auto& identifier : detectorIdentifiers) {
+        newDecoder->set(newId, identifier, oldDecoder->get(cellId, identifier));
+      }
+      return newId;
+    });
+    const double rewritePrecompiled = timePerHit(hits, precompiled, [&](CellID cellId) {
+      CellID newId = 0;
+      det::copyFields(detectorFields, cellId, newId);
+      return newId;
+    });
+    if (byName != precompiled) {
+      error() << "Precompiled rewrite of the bitfield differs from the rewrite by name" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    const det::CellIDRemap remap(detectorFields);
+    const double rewriteBatch = timePerHitBatch(hits, precompiled, remap);
+    if (byName != precompiled) {
+      error() << "Batched remap of the bitfield differs from the rewrite by name" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    info() << "Rewrite of " << hits.size() << " cellIDs: " << rewriteByName << " ns/hit by name, "
+           << rewritePrecompiled << " ns/hit precompiled, " << rewriteBatch << " ns/hit batched remap with "
+           << remap.numMoves() << " moves and " << remap.numConversions() << " conversions" << endmsg;
+
+    // volume ID of RedoSegmentation
+    const double volumeIdByName = timePerHit(hits, byName, [&](CellID cellId) {
+      for (const auto& identifier : m_removeIds) {
+        oldDecoder->set(cellId, identifier, 0);
+      }
+      return cellId;
+    });
+    const double volumeIdPrecompiled =
+        timePerHit(hits, precompiled, [&](CellID cellId) { return cellId & ~removedMask; });
+    if (byName != precompiled) {
+      error() << "Precompiled volume ID differs from the volume ID by name" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    info() << "Volume ID of " << hits.size() << " cellIDs: " << volumeIdByName << " ns/hit by name, "
+           << volumeIdPrecompiled << " ns/hit precompiled" << endmsg;
+
+    // RedoSegmentation, with the centres of the old cells as positions
+    // the cellIDs have to be valid cells of the old segmentation, any failure is an error
+    if (m_nThreads > 0) {
+      const auto* oldSegmentation = detector->readout(m_oldReadoutName).segmentation().segmentation();
+      const auto* newSegmentation = detector->readout(m_newReadoutName).segmentation().segmentation();
+      const det::Resegmentation resegmentation(*oldSegmentation, *newSegmentation, m_removeIds);
+      auto resegment = [&](CellID cellId) -> CellID {
+        return resegmentation.newCellID(cellId, oldSegmentation->position(cellId));
+      };
+      const double resegmentSerial = timePerHit(hits, byName, resegment);
+      const double resegmentConcurrent = timePerHitConcurrent(hits, precompiled, m_nThreads, resegment);
+      if (byName != precompiled) {
+        error() << "Concurrent resegmentation differs from the serial one" << endmsg;
+        return StatusCode::FAILURE;
+      }
+      info() << "Resegmentation of " << hits.size() << " cellIDs from " << oldSegmentation->type() << " to "
+             << newSegmentation->type() << ": " << resegmentSerial << " ns/hit serially, " << resegmentConcurrent
+             << " ns/hit in " << m_nThreads << " threads" << endmsg;
+    }
+  } catch (const std::runtime_error& e) {
+    error() << "Unable to transform the cellIDs: " << e.what() << endmsg;
+    return StatusCode::FAILURE;
+  }
+  info() << "CellID benchmark finished with identical results" << endmsg;
+  return StatusCode::SUCCESS;
+}
+
+StatusCode CellIDBenchmark::finalize() { return Service::finalize(); }
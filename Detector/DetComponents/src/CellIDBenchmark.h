@@ -0,0 +1,64 @@
+#ifndef DETCOMPONENTS_CELLIDBENCHMARK_H
+#define DETCOMPONENTS_CELLIDBENCHMARK_H
+
+// Gaudi
+#include "GaudiKernel/Service.h"
+
+// k4FWCore
+#include "k4Interface/IGeoSvc.h"
+
+// STD
+#include <map>
+#include <string>
+#include <vector>
+
+/** @class CellIDBenchmark Detector/DetComponents/src/CellIDBenchmark.h CellIDBenchmark.h
+ *
+ *  Service measuring the throughput of the cellID transformations of RewriteBitfield and
+ *  RedoSegmentation on initialize.
+ *  A collection of \b'nHits' calorimeter hits with random cellIDs of the old readout
+ *  (\b'oldReadoutName') is created. The fields listed in \b'cellIDRanges' take random values
+ *  within the given [min, max], the others any value of the field. The fields of the cellIDs are then rewritten into the new
+ *  readout (\b'newReadoutName') without the fields \b'removeIds', and the volume ID is obtained
+ *  by zeroing the fields \b'removeIds'. Both are done once with the field names looked up in
+ *  the decoders for every hit and once with the fields resolved beforehand (det::CellIDField).
+ *  The rewrite is also timed with the compiled remap (det::CellIDRemap) applied to all cellIDs
+ *  at once, as in RewriteBitfield. The results have to be identical.
+ *  Finally the cellIDs are resegmented into the new readout as in RedoSegmentation (det::Resegmentation, with the
+ *  fields \b'removeIds' as the old segmentation and the cell centres as positions), once serially and once split
+ *  among \b'nThreads' concurrent threads, which checks that the resegmentation is thread-safe. The cellIDs then
+ *  have to be valid cells of the old segmentation (see \b'cellIDRanges'), an exception fails the benchmark.
+ *
+ *  For an example see Detector/DetComponents/tests/options/cellIDBenchmark.py
+ */
+
+class CellIDBenchmark : public Service {
+public:
+  explicit CellIDBenchmark(const std::string& name, ISvcLocator* svcLoc);
+
+  virtual StatusCode initialize();
+  virtual StatusCode finalize();
+  virtual ~CellIDBenchmark(){};
+
+private:
+  /// Handle to the geometry service from which the readouts are retrieved
+  ServiceHandle<IGeoSvc> m_geoSvc;
+  /// Name of the detector readout used in simulation
+  Gaudi::Property<std::string> m_oldReadoutName{this, "oldReadoutName", "",
+                                                "Name of the detector readout used in simulation"};
+  /// Name of the new detector readout
+  Gaudi::Property<std::string> m_newReadoutName{this, "newReadoutName", "", "Name of the new detector readout"};
+  /// Segmentation fields that are removed from the readout
+  Gaudi::Property<std::vector<std::string>> m_removeIds{this, "removeIds", {}, "Segmentation fields that are removed"};
+  /// Ranges of the random values of the fields, as [min, max]
+  Gaudi::Property<std::map<std::string, std::vector<int>>> m_cellIDRanges{
+      this, "cellIDRanges", {}, "Ranges [min, max] of the random values of the fields, other fields take any value"};
+  /// Number of hits in the collection
+  Gaudi::Property<unsigned> m_nHits{this, "nHits", 1000000, "Number of hits in the collection"};
+  /// Number of threads of the concurrent resegmentation
+  Gaudi::Property<unsigned> m_nThreads{this, "nThreads", 4,
+                                       "Number of threads of the concurrent resegmentation, 0 to skip it"};
+  /// Seed of the random cellIDs
+  Gaudi::Property<unsigned> m_seed{this, "seed", 1, "Seed of the random cellIDs"};
+};
+#endif /* DETCOMPONENTS_CELLIDBENCHMARK_H */
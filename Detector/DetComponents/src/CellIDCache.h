@@ -0,0 +1,90 @@
+#ifndef DETCOMPONENTS_CELLIDCACHE_H
+#define DETCOMPONENTS_CELLIDCACHE_H
+
+// DD4hep
+#include "DDSegmentation/BitFieldCoder.h"
+
+// STL
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace det {
+/** @class det::CellIDCache Detector/DetComponents/src/CellIDCache.h CellIDCache.h
+ *
+ *  Least recently used cache of the cellIDs computed from other cellIDs.
+ *  At most capacity() cellIDs are kept, the one that was not looked up for the longest time is
+ *  removed first. A capacity of 0 disables the cache. The numbers of found and missed lookups
+ *  are counted for the statistics.
+ *  The cache is not thread-safe.
+ */
+class CellIDCache {
+public:
+  using CellID = dd4hep::DDSegmentation::CellID;
+
+  explicit CellIDCache(size_t aCapacity = 0) : m_capacity(aCapacity) { m_index.reserve(aCapacity); }
+
+  /// Maximum number of cellIDs in the cache
+  size_t capacity() const { return m_capacity; }
+  /// Number of cellIDs in the cache
+  size_t size() const { return m_index.size(); }
+  /// Number of lookups that found the cellID
+  uint64_t hits() const { return m_hits; }
+  /// Number of lookups that did not find the cellID
+  uint64_t misses() const { return m_misses; }
+
+  /**  Look up the cellID, marking it as the most recently used.
+   *   @param[in] aKey cellID from which the value was computed.
+   *   @param[out] aValue cached value, unchanged if not found.
+   *   @return true if the cellID was found.
+   */
+  bool find(CellID aKey, CellID& aValue) {
+    auto it = m_index.find(aKey);
+    if (it == m_index.end()) {
+      m_misses++;
+      return false;
+    }
+    m_hits++;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    aValue = it->second->second;
+    return true;
+  }
+
+  /// Add the value computed from the cellID, removing the least recently used one if the cache is full
+  void insert(CellID aKey, CellID aValue) {
+    if (m_capacity == 0 || m_index.count(aKey)) {
+      return;
+    }
+    if (m_index.size() == m_capacity) {
+      m_index.erase(m_entries.back().first);
+      // reuse the node of the removed entry
+      m_entries.splice(m_entries.begin(), m_entries, std::prev(m_entries.end()));
+      m_entries.front() = {aKey, aValue};
+    } else {
+      m_entries.emplace_front(aKey, aValue);
+    }
+    m_index.emplace(aKey, m_entries.begin());
+  }
+
+  /// Remove all cellIDs and reset the statistics
+  void clear() {
+    m_entries.clear();
+    m_index.clear();
+    m_hits = 0;
+    m_misses = 0;
+  }
+
+private:
+  /// Maximum number of cellIDs
+  size_t m_capacity;
+  /// Cached cellIDs and values, the most recently used first
+  std::list<std::pair<CellID, CellID>> m_entries;
+  /// Position of the cellID in m_entries
+  std::unordered_map<CellID, std::list<std::pair<CellID, CellID>>::iterator> m_index;
+  uint64_t m_hits = 0;
+  uint64_t m_misses = 0;
+};
+}
+
+#endif /* DETCOMPONENTS_CELLIDCACHE_H */
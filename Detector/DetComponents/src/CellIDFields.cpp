@@ -0,0 +1,121 @@
+#include "CellIDFields.h"
+
+// STL
+#include <algorithm>
+#include <stdexcept>
+
+namespace det {
+CellIDField::CellIDField(const dd4hep::DDSegmentation::BitFieldElement& aElement)
+    : m_name(aElement.name()), m_offset(aElement.offset()), m_width(aElement.width()),
+      m_isSigned(aElement.isSigned()), m_mask(aElement.mask()), m_signBit(m_width > 0 ? 1LL << (m_width - 1) : 0),
+      m_minValue(aElement.minValue()), m_maxValue(aElement.maxValue()) {}
+
+CellIDField::CellIDField(const dd4hep::DDSegmentation::BitFieldCoder& aDecoder, const std::string& aName)
+    : CellIDField(aDecoder[aDecoder.index(aName)]) {}
+
+void CellIDField::throwOutOfRange(long64 aValue) const {
+  throw std::runtime_error("Value " + std::to_string(aValue) + " out of range for field " + m_name + " [" +
+                           std::to_string(m_minValue) + ", " + std::to_string(m_maxValue) + "]");
+}
+
+std::vector<CellIDFieldCopy> resolveFieldCopies(const dd4hep::DDSegmentation::BitFieldCoder& aOldDecoder,
+                                                const dd4hep::DDSegmentation::BitFieldCoder& aNewDecoder,
+                                                const std::vector<std::string>& aNames) {
+  std::vector<CellIDFieldCopy> copies;
+  copies.reserve(aNames.size());
+  for (const auto& name : aNames) {
+    copies.emplace_back(CellIDField(aOldDecoder, name), CellIDField(aNewDecoder, name));
+  }
+  return copies;
+}
+
+namespace {
+dd4hep::DDSegmentation::CellID widthMask(unsigned aWidth) {
+  return aWidth >= 64 ? ~dd4hep::DDSegmentation::CellID(0) : (dd4hep::DDSegmentation::CellID(1) << aWidth) - 1;
+}
+}
+
+CellIDRemap::CellIDRemap(const std::vector<CellIDFieldCopy>& aCopies) : m_copies(aCopies) {
+  std::vector<CellIDFieldCopy> moves;
+  for (const auto& copy : aCopies) {
+    const CellIDField& oldField = copy.first;
+    const CellIDField& newField = copy.second;
+    if (oldField.width() == newField.width() && oldField.isSigned() == newField.isSigned()) {
+      moves.push_back(copy);
+    } else {
+      m_conversions.push_back({oldField.offset(), widthMask(oldField.width()), newField.offset(),
+                               widthMask(newField.width()),
+                               oldField.isSigned() ? CellID(1) << (oldField.width() - 1) : 0, newField.minValue(),
+                               newField.maxValue()});
+    }
+  }
+  // fields adjacent in both bitfields are moved together
+  std::sort(moves.begin(), moves.end(),
+            [](const CellIDFieldCopy& a, const CellIDFieldCopy& b) { return a.first.offset() < b.first.offset(); });
+  unsigned width = 0;
+  for (size_t i = 0; i < moves.size(); ++i) {
+    if (width == 0) {
+      m_moves.push_back({moves[i].first.offset(), 0, moves[i].second.offset(), 0, 0, 0, 0});
+    }
+    width += moves[i].first.width();
+    const bool adjacent = i + 1 < moves.size() &&
+                          moves[i + 1].first.offset() == moves[i].first.offset() + moves[i].first.width() &&
+                          moves[i + 1].second.offset() == moves[i].second.offset() + moves[i].second.width();
+    if (!adjacent) {
+      m_moves.back().srcMask = widthMask(width);
+      m_moves.back().dstMask = widthMask(width);
+      width = 0;
+    }
+  }
+}
+
+CellIDRemap::CellID CellIDRemap::apply(CellID aOldId) const {
+  CellID newId = 0;
+  apply(&aOldId, &newId, 1);
+  return newId;
+}
+
+void CellIDRemap::apply(const CellID* aOldIds, CellID* aNewIds, size_t aSize) const {
+  // conversions are checked first, so that the arrays can be the same
+  bool outOfRange = false;
+  for (const auto& op : m_conversions) {
+    for (size_t i = 0; i < aSize; ++i) {
+      // branchless sign extension, no-op for signBit = 0
+      const long long value =
+          static_cast<long long>((((aOldIds[i] >> op.srcShift) & op.srcMask) ^ op.signBit) - op.signBit);
+      outOfRange |= (value < op.minValue) | (value > op.maxValue);
+    }
+  }
+  if (outOfRange) {
+    throwOutOfRange(aOldIds, aSize);
+  }
+  // the new cellIDs are accumulated in a scratch word per element to allow aOldIds == aNewIds
+  constexpr size_t kBlock = 256;
+  CellID block[kBlock];
+  for (size_t first = 0; first < aSize; first += kBlock) {
+    const size_t n = std::min(kBlock, aSize - first);
+    const CellID* oldIds = aOldIds + first;
+    std::fill(block, block + n, 0);
+    for (const auto& op : m_moves) {
+      for (size_t i = 0; i < n; ++i) {
+        block[i] |= ((oldIds[i] >> op.srcShift) & op.srcMask) << op.dstShift;
+      }
+    }
+    for (const auto& op : m_conversions) {
+      for (size_t i = 0; i < n; ++i) {
+        const CellID value = (((oldIds[i] >> op.srcShift) & op.srcMask) ^ op.signBit) - op.signBit;
+        block[i] |= (value & op.dstMask) << op.dstShift;
+      }
+    }
+    std::copy(block, block + n, aNewIds + first);
+  }
+}
+
+void CellIDRemap::throwOutOfRange(const CellID* aOldIds, size_t aSize) const {
+  for (size_t i = 0; i < aSize; ++i) {
+    CellID newId = 0;
+    copyFields(m_copies, aOldIds[i], newId);
+  }
+  throw std::runtime_error("Value out of range in the remap of the cellID");
+}
+}
@@ -0,0 +1,141 @@
+#ifndef DETCOMPONENTS_CELLIDFIELDS_H
+#define DETCOMPONENTS_CELLIDFIELDS_H
+
+// DD4hep
+#include "DDSegmentation/BitFieldCoder.h"
+
+// STL
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace det {
+/** @class det::CellIDField Detector/DetComponents/src/CellIDFields.h CellIDFields.h
+ *
+ *  Field of the cellID bitfield, resolved from the decoder at initialize.
+ *  Reading and writing the field is plain bit arithmetic on the precomputed offset and mask,
+ *  with the same sign handling and range check as dd4hep::BitFieldElement, but without the
+ *  lookup of the field by name for every hit.
+ */
+class CellIDField {
+public:
+  using CellID = dd4hep::DDSegmentation::CellID;
+  using long64 = dd4hep::DDSegmentation::long64;
+
+  CellIDField() = default;
+  /// Constructor from the field of the decoder
+  explicit CellIDField(const dd4hep::DDSegmentation::BitFieldElement& aElement);
+  /// Constructor from the name of the field
+  /// @throws std::runtime_error if the decoder has no such field
+  CellIDField(const dd4hep::DDSegmentation::BitFieldCoder& aDecoder, const std::string& aName);
+
+  /// Value of the field in the cellID
+  long64 value(CellID aCellId) const {
+    long64 val = (aCellId & m_mask) >> m_offset;
+    if (m_isSigned && (val & m_signBit)) {
+      val -= 2 * m_signBit;
+    }
+    return val;
+  }
+  /// Set the value of the field in the cellID
+  /// @throws std::runtime_error if the value does not fit into the field
+  void set(CellID& aCellId, long64 aValue) const {
+    if (aValue < m_minValue || aValue > m_maxValue) {
+      throwOutOfRange(aValue);
+    }
+    aCellId = (aCellId & ~m_mask) | ((CellID(aValue) << m_offset) & m_mask);
+  }
+
+  const std::string& name() const { return m_name; }
+  unsigned offset() const { return m_offset; }
+  unsigned width() const { return m_width; }
+  bool isSigned() const { return m_isSigned; }
+  CellID mask() const { return m_mask; }
+  long64 minValue() const { return m_minValue; }
+  long64 maxValue() const { return m_maxValue; }
+
+private:
+  [[noreturn]] void throwOutOfRange(long64 aValue) const;
+
+  std::string m_name;
+  unsigned m_offset = 0;
+  unsigned m_width = 0;
+  bool m_isSigned = false;
+  CellID m_mask = 0;
+  long64 m_signBit = 0;
+  long64 m_minValue = 0;
+  long64 m_maxValue = 0;
+};
+
+/// Copy of a field between two bitfields (old and new readout)
+using CellIDFieldCopy = std::pair<CellIDField, CellIDField>;
+
+/// Resolve the fields with the given names, present in both decoders
+/// @throws std::runtime_error if any of the decoders has no such field
+std::vector<CellIDFieldCopy> resolveFieldCopies(const dd4hep::DDSegmentation::BitFieldCoder& aOldDecoder,
+                                                const dd4hep::DDSegmentation::BitFieldCoder& aNewDecoder,
+                                                const std::vector<std::string>& aNames);
+
+/// Copy the fields from the old cellID into the new cellID
+inline void copyFields(const std::vector<CellIDFieldCopy>& aCopies, CellIDField::CellID aOldId,
+                       CellIDField::CellID& aNewId) {
+  for (const auto& copy : aCopies) {
+    copy.second.set(aNewId, copy.first.value(aOldId));
+  }
+}
+
+/** @class det::CellIDRemap Detector/DetComponents/src/CellIDFields.h CellIDFields.h
+ *
+ *  Copy of the fields from the old into the new bitfield, compiled at initialize into a short
+ *  list of operations (source shift, mask, destination shift).
+ *  Fields of the same width and signedness are moved as raw bits, and fields adjacent in both
+ *  bitfields are merged into a single move. Other fields are sign extended (if signed) and
+ *  checked against the range of the new field, as in copyFields.
+ *  The batch version applies one operation at a time to a contiguous array of cellIDs, the
+ *  inner loops have no branches and can be vectorised by the compiler.
+ */
+class CellIDRemap {
+public:
+  using CellID = CellIDField::CellID;
+
+  CellIDRemap() = default;
+  /// Compile the copies of the fields
+  explicit CellIDRemap(const std::vector<CellIDFieldCopy>& aCopies);
+
+  /// New cellID with the fields copied from the old cellID
+  /// @throws std::runtime_error if a value does not fit into the new field
+  CellID apply(CellID aOldId) const;
+  /// Remap the array of cellIDs
+  /// @param[in] aOldIds, aNewIds arrays of aSize cellIDs (may be the same array)
+  /// @throws std::runtime_error if a value does not fit into the new field
+  void apply(const CellID* aOldIds, CellID* aNewIds, size_t aSize) const;
+
+  /// Number of bit moves (merged fields)
+  size_t numMoves() const { return m_moves.size(); }
+  /// Number of fields converted with sign extension and range check
+  size_t numConversions() const { return m_conversions.size(); }
+
+private:
+  /// Field (or adjacent fields) extracted with (id >> srcShift) & srcMask and stored at dstShift
+  struct Operation {
+    unsigned srcShift;
+    CellID srcMask;
+    unsigned dstShift;
+    CellID dstMask;
+    /// Sign bit of the extracted value, 0 for unsigned fields
+    CellID signBit;
+    /// Range of the new field
+    long long minValue;
+    long long maxValue;
+  };
+  /// Throw the error of copyFields for the first cellID that does not fit
+  [[noreturn]] void throwOutOfRange(const CellID* aOldIds, size_t aSize) const;
+
+  std::vector<Operation> m_moves;
+  std::vector<Operation> m_conversions;
+  /// Original copies, used for the error messages
+  std::vector<CellIDFieldCopy> m_copies;
+};
+}
+
+#endif /* DETCOMPONENTS_CELLIDFIELDS_H */
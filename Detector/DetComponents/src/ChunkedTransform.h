@@ -0,0 +1,34 @@
+#ifndef DETCOMPONENTS_CHUNKEDTRANSFORM_H
+#define DETCOMPONENTS_CHUNKEDTRANSFORM_H
+
+// TBB
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
+// STL
+#include <cstddef>
+
+namespace det {
+/**  Call the function for consecutive ranges [first, last) covering the hits [0, aNumHits).
+ *   The ranges of at most aChunkSize hits are processed concurrently by the TBB task pool shared with the
+ *   Gaudi scheduler. If aChunkSize is 0 or not smaller than the number of hits, the function is called once
+ *   for all hits in the calling thread. The function may only write the outputs of its own range, so that
+ *   the result does not depend on the order in which the ranges are processed.
+ *   @param[in] aNumHits number of hits.
+ *   @param[in] aChunkSize maximum number of hits processed by one task, 0 for serial processing.
+ *   @param[in] aFunction function called with the first and past-the-last index of the range.
+ */
+template <typename RangeFunction>
+void forEachChunk(size_t aNumHits, size_t aChunkSize, const RangeFunction& aFunction) {
+  if (aChunkSize == 0 || aNumHits <= aChunkSize) {
+    aFunction(size_t(0), aNumHits);
+    return;
+  }
+  tbb::parallel_for(
+      tbb::blocked_range<size_t>(0, aNumHits, aChunkSize),
+      [&aFunction](const tbb::blocked_range<size_t>& aRange) { aFunction(aRange.begin(), aRange.end()); },
+      tbb::simple_partitioner());
+}
+}
+
+#endif /* DETCOMPONENTS_CHUNKEDTRANSFORM_H */
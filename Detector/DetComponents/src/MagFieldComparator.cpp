@@ -0,0 +1,208 @@
+#include "MagFieldComparator.h"
+
+// Geant4
+#include "G4MagneticField.hh"
+#include "G4SystemOfUnits.hh"
+
+// k4SimGeant4
+#include "SimG4Common/FieldComparison.h"
+
+// STD
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+
+MagFieldComparator::MagFieldComparator(const std::string& name,
+                                       ISvcLocator* svcLoc) : Service(name, svcLoc) {
+  declareProperty("field", m_fieldTool, "Handle for the tested magnetic field");
+  declareProperty("referenceField", m_referenceFieldTool, "Handle for the reference magnetic field");
+}
+
+
+StatusCode MagFieldComparator::initialize() {
+  {
+    StatusCode sc = Service::initialize();
+    if (sc.isFailure()) {
+      return sc;
+    }
+  }
+
+  if (!m_fieldTool.retrieve()) {
+    error() << "Unable to retrieve the tested magnetic field tool!" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  if (!m_referenceFieldTool.retrieve()) {
+    error() << "Unable to retrieve the reference magnetic field tool!" << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  const G4MagneticField* field = m_fieldTool->field();
+  const G4MagneticField* referenceField = m_referenceFieldTool->field();
+  if (!field || !referenceField) {
+    error() << "Both field tools have to provide a magnetic field, check their FieldOn flag!" << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  if (m_sampling.value() != "random" && m_sampling.value() != "grid") {
+    error() << "Unknown sampling: " << m_sampling.value() << endmsg;
+    error() << "Supported samplings: random, grid" << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  std::vector<Region> regions;
+  for (size_t iRegion = 0; iRegion < m_regions.value().size(); ++iRegion) {
+    const auto& regionDef = m_regions.value().at(iRegion);
+    if (regionDef.size() != 4) {
+      warning() << "Region has to be defined by rMin, rMax, zMin and zMax!" << endmsg;
+      continue;
+    }
+    if (regionDef[0] < 0. || regionDef[1] <= regionDef[0] || regionDef[3] <= regionDef[2]) {
+      warning() << "Region defined with empty or negative extent!" << endmsg;
+      continue;
+    }
+    std::string regionName = "region_" + std::to_string(iRegion);
+    if (iRegion < m_regionNames.value().size()) {
+      regionName = m_regionNames.value().at(iRegion);
+    }
+    const Region region{regionName, regionDef[0], regionDef[1], regionDef[2], regionDef[3]};
+    regions.emplace_back(region);
+  }
+  if (regions.empty()) {
+    error() << "No regions to compare the fields in!" << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  info() << "Comparing field " << m_fieldTool.name() << " to reference "
+         << m_referenceFieldTool.name() << endmsg;
+
+  bool withinTolerance = true;
+  std::vector<double> x, y, z;
+  std::vector<double> bField[3], bFieldRef[3];
+  for (const auto& region : regions) {
+    samplePoints(region, x, y, z);
+    const double callsPerSecond = evaluateField(*field, x, y, z, bField);
+    const double callsPerSecondRef = evaluateField(*referenceField, x, y, z, bFieldRef);
+
+    sim::FieldDifferenceAccumulator accumulator;
+    const double* const values[3] = {bField[0].data(), bField[1].data(), bField[2].data()};
+    const double* const valuesRef[3] = {bFieldRef[0].data(), bFieldRef[1].data(), bFieldRef[2].data()};
+    accumulator.add(x.size(), values, valuesRef);
+    const sim::FieldDifference difference = accumulator.result();
+
+    info() << region << ", " << difference.nPoints << " " << m_sampling.value()
+           << " samples:" << endmsg;
+    info() << "  max |dB| = " << difference.maxDiffMag / tesla
+           << " T, RMS |dB| = " << difference.rmsDiffMag / tesla << " T" << endmsg;
+    info() << "  max |dBx|, |dBy|, |dBz| = " << difference.maxDiff[0] / tesla << ", "
+           << difference.maxDiff[1] / tesla << ", " << difference.maxDiff[2] / tesla << " T" << endmsg;
+    info() << "  RMS dBx, dBy, dBz = " << difference.rmsDiff[0] / tesla << ", "
+           << difference.rmsDiff[1] / tesla << ", " << difference.rmsDiff[2] / tesla << " T" << endmsg;
+    info() << "  throughput: " << callsPerSecond << " calls/s (field), "
+           << callsPerSecondRef << " calls/s (reference)" << endmsg;
+
+    if (m_maxDiffTolerance.value() >= 0. && difference.maxDiffMag > m_maxDiffTolerance.value()) {
+      error() << "Field difference in " << region.name << " exceeds the tolerance of "
+              << m_maxDiffTolerance.value() / tesla << " T!" << endmsg;
+      withinTolerance = false;
+    }
+  }
+
+  if (!withinTolerance) {
+    return StatusCode::FAILURE;
+  }
+  info() << "Field comparison finished in " << regions.size() << " regions" << endmsg;
+
+  return StatusCode::SUCCESS;
+}
+
+
+StatusCode MagFieldComparator::finalize() { return Service::finalize(); }
+
+
+void MagFieldComparator::samplePoints(const Region& region,
+                                      std::vector<double>& x,
+                                      std::vector<double>& y,
+                                      std::vector<double>& z) const {
+  x.clear();
+  y.clear();
+  z.clear();
+
+  if (m_sampling.value() == "grid") {
+    // Same number of bins along r, phi and z
+    const size_t nBins = std::max<size_t>(1, std::lround(std::cbrt(m_nSamples.value())));
+    const double binR = (region.rMax - region.rMin) / nBins;
+    const double binPhi = 2 * CLHEP::pi / nBins;
+    const double binZ = (region.zMax - region.zMin) / nBins;
+    for (size_t i = 0; i < nBins; ++i) {
+      const double r = region.rMin + (i + 0.5) * binR;
+      for (size_t j = 0; j < nBins; ++j) {
+        const double phi = (j + 0.5) * binPhi;
+        for (size_t k = 0; k < nBins; ++k) {
+          x.push_back(r * std::cos(phi));
+          y.push_back(r * std::sin(phi));
+          z.push_back(region.zMin + (k + 0.5) * binZ);
+        }
+      }
+    }
+    return;
+  }
+
+  // Uniform in the volume of the cylindrical shell, the same points for every run
+  std::mt19937_64 generator(m_seed.value());
+  std::uniform_real_distribution<double> r2Dist(region.rMin * region.rMin, region.rMax * region.rMax);
+  std::uniform_real_distribution<double> phiDist(0., 2 * CLHEP::pi);
+  std::uniform_real_distribution<double> zDist(region.zMin, region.zMax);
+  for (unsigned i = 0; i < m_nSamples.value(); ++i) {
+    const double r = std::sqrt(r2Dist(generator));
+    const double phi = phiDist(generator);
+    x.push_back(r * std::cos(phi));
+    y.push_back(r * std::sin(phi));
+    z.push_back(zDist(generator));
+  }
+}
+
+
+double MagFieldComparator::evaluateField(const G4MagneticField& field,
+                                         const std::vector<double>& x,
+                                         const std::vector<double>& y,
+                                         const std::vector<double>& z,
+                                         std::vector<double> (&bField)[3]) const {
+  const size_t nPoints = x.size();
+  for (auto& component : bField) {
+    component.resize(nPoints);
+  }
+
+  // Points are evaluated one by one, the way Geant4 steppers query the field
+  double bestTime = -1.;
+  for (unsigned iRepetition = 0; iRepetition < std::max(1u, m_nRepetitions.value()); ++iRepetition) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < nPoints; ++i) {
+      const double point[4] = {x[i], y[i], z[i], 0.};
+      double value[3] = {0., 0., 0.};
+      field.GetFieldValue(point, value);
+      bField[0][i] = value[0];
+      bField[1][i] = value[1];
+      bField[2][i] = value[2];
+    }
+    const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    if (bestTime < 0. || time.count() < bestTime) {
+      bestTime = time.count();
+    }
+  }
+
+  return bestTime > 0. ? nPoints / bestTime : 0.;
+}
+
+
+std::ostream& operator<<(std::ostream& outStream,
+                         const MagFieldComparator::Region& region) {
+  return outStream << region.name << ": rMin = " << region.rMin
+                   << " mm, rMax = " << region.rMax
+                   << " mm, zMin = " << region.zMin
+                   << " mm, zMax = " << region.zMax << " mm";
+}
+
+
+DECLARE_COMPONENT(MagFieldComparator)
@@ -0,0 +1,127 @@
+#ifndef MAGFIELDCOMPARATOR_H
+#define MAGFIELDCOMPARATOR_H
+
+// Gaudi
+#include "GaudiKernel/Service.h"
+#include "GaudiKernel/ToolHandle.h"
+
+// k4FWCore
+#include "k4Interface/ISimG4MagneticFieldTool.h"
+
+// STD
+#include <string>
+#include <vector>
+
+class G4MagneticField;
+
+
+/** @class MagFieldComparator Detector/DetComponents/src/MagFieldComparator.h MagFieldComparator.h
+ *
+ *  Service compares two magnetic fields on initialize, e.g. after switching the
+ *  field map or the interpolation.
+ *
+ *  Both fields are evaluated in the same sample points inside every region.
+ *  A region is a cylindrical shell defined with parameters: rMin, rMax, zMin
+ *  and zMax. The points are placed randomly (uniformly in volume) or on a
+ *  regular grid in r, phi and z. For every region the maximal and RMS
+ *  difference of the fields is reported together with the number of
+ *  GetFieldValue calls per second each field sustains.
+ *
+ *  With maxDiffTolerance set the service fails if the difference in any region
+ *  exceeds it, so it can guard against regressions.
+ *
+ *  Field tools modify the global Geant4 field manager when initialized, the
+ *  service is meant to be run in a standalone job without the simulation.
+ */
+
+class MagFieldComparator : public Service {
+public:
+  explicit MagFieldComparator(const std::string& name, ISvcLocator* svcLoc);
+
+  virtual StatusCode initialize();
+  virtual StatusCode finalize();
+  virtual ~MagFieldComparator(){};
+
+private:
+  /// Handle to the tested magnetic field tool
+  ToolHandle<ISimG4MagneticFieldTool> m_fieldTool{"SimG4MagneticFieldFromMapTool", this, true};
+
+  /// Handle to the reference magnetic field tool
+  ToolHandle<ISimG4MagneticFieldTool> m_referenceFieldTool{"SimG4ConstantMagneticFieldTool", this, true};
+
+  /// Region definitions
+  Gaudi::Property<std::vector<std::vector<double>>> m_regions{
+      this,
+      "regions",
+      {},
+      "Region definitions: rMin, rMax, zMin, zMax"};
+
+  /// Region names
+  Gaudi::Property<std::vector<std::string>> m_regionNames{
+      this,
+      "regionNames",
+      {},
+      "Region names used in the report"};
+
+  /// Placement of the sample points
+  Gaudi::Property<std::string> m_sampling{this,
+                                          "sampling",
+                                          "random",
+                                          "Placement of the sample points: random or grid"};
+
+  /// Number of sample points per region
+  Gaudi::Property<unsigned> m_nSamples{this,
+                                       "nSamples",
+                                       100000,
+                                       "Number of sample points per region"};
+
+  /// Seed of the random sample points
+  Gaudi::Property<unsigned> m_seed{this,
+                                   "seed",
+                                   12345,
+                                   "Seed of the random sample points"};
+
+  /// Number of timed evaluations of the sample, the fastest one is reported
+  Gaudi::Property<unsigned> m_nRepetitions{this,
+                                           "nRepetitions",
+                                           5,
+                                           "Number of timed evaluations of the sample"};
+
+  /// Maximal allowed difference of the fields, negative value disables the check
+  Gaudi::Property<double> m_maxDiffTolerance{this,
+                                             "maxDiffTolerance",
+                                             -1.,
+                                             "Maximal allowed magnitude of the field difference"};
+
+  struct Region {
+    const std::string name;
+    const double rMin;
+    const double rMax;
+    const double zMin;
+    const double zMax;
+  };
+
+  /// Sample points inside the region
+  /// @param[in] region the sampled region
+  /// @param[out] x, y, z coordinates of the points
+  void samplePoints(const Region& region,
+                    std::vector<double>& x,
+                    std::vector<double>& y,
+                    std::vector<double>& z) const;
+
+  /// Evaluate the field in all points, repeatedly
+  /// @param[in] field the evaluated field
+  /// @param[in] x, y, z coordinates of the points
+  /// @param[out] bField components of the field in the points
+  /// @returns the number of GetFieldValue calls per second of the fastest repetition
+  double evaluateField(const G4MagneticField& field,
+                       const std::vector<double>& x,
+                       const std::vector<double>& y,
+                       const std::vector<double>& z,
+                       std::vector<double> (&bField)[3]) const;
+
+  friend std::ostream& operator<<(std::ostream& outStream,
+                                  const Region& region);
+};
+
+#endif /* MAGFIELDCOMPARATOR_H */
@@ -10,6 +10,32 @@
 #include "TFile.h"
 #include "TString.h"
 
+// k4SimGeant4
+#include "SimG4Common/BatchMagneticField.h"
+
+// TBB
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+// STD
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+
+namespace {
+  /// Center of the bin of the axis
+  double binCenter(double min, double max, size_t nBins, size_t iBin) {
+    return min + (iBin + 0.5) * (max - min) / nBins;
+  }
+
+  /// Write the value into the binary stream
+  template <typename T>
+  void writeValue(std::ofstream& outFile, const T& value) {
+    outFile.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+}
 
 MagFieldScanner::MagFieldScanner(const std::string& name,
                                  ISvcLocator* svcLoc) : Service(name, svcLoc),
@@ -51,6 +77,19 @@ StatusCode MagFieldScanner::initialize() {
       dynamic_cast<const G4MagneticField*>(fieldManager->GetDetectorField());
   if (!magField) {
     error() << "Found Geant4 field is not a magnetic field!" << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  if (m_outputFormat.value() != "root" && m_outputFormat.value() != "binary") {
+    error() << "Unknown output format: " << m_outputFormat.value() << endmsg;
+    error() << "Supported formats: root, binary" << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  if (m_nBins.value().size() != 2 ||
+      m_nBins.value().at(0) == 0 || m_nBins.value().at(1) == 0) {
+    error() << "Number of bins of the planar probes has to be given by two positive numbers!" << endmsg;
+    return StatusCode::FAILURE;
   }
 
   debug() << "Probe results will be written to:" << endmsg;
@@ -117,215 +156,243 @@ StatusCode MagFieldScanner::initialize() {
     }
   }
 
-  std::vector<TH2D> xyPlaneProbeHistosX;
-  std::vector<TH2D> xyPlaneProbeHistosY;
-  std::vector<TH2D> xyPlaneProbeHistosZ;
-  for (const auto& probe : xyPlaneProbes) {
-    std::string histName = "xyPlane_";
-    histName += std::to_string((int) probe.xMax) + "_";
-    histName += std::to_string((int) probe.yMax) + "_";
-    histName += std::to_string((int) probe.z) + "_bField";
-    std::string histTitle = "xyPlane, z = ";
-    histTitle += std::to_string((int) probe.z) + " mm, bField";
-
-    auto histX = TH2D((histName + "_x").c_str(),
-                      (histTitle + "(x)").c_str(),
-                      500, -probe.xMax, probe.xMax,
-                      500, -probe.yMax, probe.yMax);
-    histX.GetXaxis()->SetTitle("x [mm]");
-    histX.GetYaxis()->SetTitle("y [mm]");
-    histX.GetZaxis()->SetTitle("B_{x} [T]");
-
-    auto histY = TH2D((histName + "_y").c_str(),
-                      (histTitle + "(y)").c_str(),
-                      500, -probe.xMax, probe.xMax,
-                      500, -probe.yMax, probe.yMax);
-    histY.GetXaxis()->SetTitle("x [mm]");
-    histY.GetYaxis()->SetTitle("y [mm]");
-    histY.GetZaxis()->SetTitle("B_{y} [T]");
-
-
-    auto histZ = TH2D((histName + "_z").c_str(),
-                      (histTitle + "(z)").c_str(),
-                      500, -probe.xMax, probe.xMax,
-                      500, -probe.yMax, probe.yMax);
-    histZ.GetXaxis()->SetTitle("x [mm]");
-    histZ.GetYaxis()->SetTitle("y [mm]");
-    histZ.GetZaxis()->SetTitle("B_{z} [T]");
-
-    xyPlaneProbeHistosX.emplace_back(histX);
-    xyPlaneProbeHistosY.emplace_back(histY);
-    xyPlaneProbeHistosZ.emplace_back(histZ);
+  std::vector<BoxProbe> boxProbes;
+  for (const auto& probeDef : m_boxProbes.value()) {
+    if (probeDef.size() != 9) {
+      continue;
+    }
+    if (probeDef[2] < 1. || probeDef[5] < 1. || probeDef[8] < 1.) {
+      warning() << "Box probe defined with less than one bin!" << endmsg;
+      continue;
+    }
+    const BoxProbe boxProbe{probeDef[0], probeDef[1], static_cast<size_t>(probeDef[2]),
+                            probeDef[3], probeDef[4], static_cast<size_t>(probeDef[5]),
+                            probeDef[6], probeDef[7], static_cast<size_t>(probeDef[8])};
+    boxProbes.emplace_back(boxProbe);
   }
 
-  for (size_t iProbe = 0; iProbe < xyPlaneProbes.size(); ++iProbe) {
-    auto& histX = xyPlaneProbeHistosX.at(iProbe);
-    for (int i = 1; i <= histX.GetXaxis()->GetNbins(); ++i) {
-      for (int j = 1; j <= histX.GetYaxis()->GetNbins(); ++j) {
-        const double point[] = {histX.GetXaxis()->GetBinCenter(i),
-                                histX.GetYaxis()->GetBinCenter(j),
-                                xyPlaneProbes.at(iProbe).z,
-                                0.};
-        double field[] = {0., 0., 0.};
-        magField->GetFieldValue(point, field);
-        histX.SetBinContent(i, j, field[0] / tesla);
-        xyPlaneProbeHistosY.at(iProbe).SetBinContent(i, j, field[1] / tesla);
-        xyPlaneProbeHistosZ.at(iProbe).SetBinContent(i, j, field[2] / tesla);
-      }
+  if (boxProbes.size()) {
+    info() << "Defined box probes:" << endmsg;
+    for (const auto& probe : boxProbes) {
+      info() << probe << endmsg;
+    }
+    if (m_outputFormat.value() != "binary") {
+      error() << "Box probes can be written only in the binary output format!" << endmsg;
+      return StatusCode::FAILURE;
     }
   }
 
-  std::vector<TH2D> zPlaneProbeHistosX;
-  std::vector<TH2D> zPlaneProbeHistosY;
-  std::vector<TH2D> zPlaneProbeHistosZ;
-  for (const auto& probe : zPlaneProbes) {
-    TString histName;
-    histName.Form("zPlane_%i_%i_%i_%.3f_bField",
-                  (int)probe.zMin, (int)probe.zMax, (int)probe.rMax, probe.phi);
-    TString histTitle;
-    histTitle.Form("zPlane, phi = %.3f, bField", probe.phi);
-
-    auto histX = TH2D((histName + "_x").Data(),
-                      (histTitle + "(x)").Data(),
-                      500, probe.zMin, probe.zMax,
-                      500, 0., probe.rMax);
-    histX.GetXaxis()->SetTitle("z [mm]");
-    histX.GetYaxis()->SetTitle("r [mm]");
-    histX.GetZaxis()->SetTitle("B_{x} [T]");
-
-    auto histY = TH2D((histName + "_y").Data(),
-                      (histTitle + "(y)").Data(),
-                      500, probe.zMin, probe.zMax,
-                      500, 0., probe.rMax);
-    histY.GetXaxis()->SetTitle("z [mm]");
-    histY.GetYaxis()->SetTitle("r [mm]");
-    histY.GetZaxis()->SetTitle("B_{y} [T]");
-
-
-    auto histZ = TH2D((histName + "_z").Data(),
-                      (histTitle + "(z)").Data(),
-                      500, probe.zMin, probe.zMax,
-                      500, 0., probe.rMax);
-    histZ.GetXaxis()->SetTitle("z [mm]");
-    histZ.GetYaxis()->SetTitle("r [mm]");
-    histZ.GetZaxis()->SetTitle("B_{z} [T]");
-
-    zPlaneProbeHistosX.emplace_back(histX);
-    zPlaneProbeHistosY.emplace_back(histY);
-    zPlaneProbeHistosZ.emplace_back(histZ);
+  const size_t nBinsU = m_nBins.value().at(0);
+  const size_t nBinsV = m_nBins.value().at(1);
+
+  std::vector<ScanGrid> grids;
+  for (const auto& probe : xyPlaneProbes) {
+    std::string gridName = "xyPlane_";
+    gridName += std::to_string((int) probe.xMax) + "_";
+    gridName += std::to_string((int) probe.yMax) + "_";
+    gridName += std::to_string((int) probe.z) + "_bField";
+    std::string gridTitle = "xyPlane, z = ";
+    gridTitle += std::to_string((int) probe.z) + " mm, bField";
+
+    grids.push_back({gridName, gridTitle,
+                     {"z [mm]", "x [mm]", "y [mm]"},
+                     {1, nBinsU, nBinsV},
+                     {probe.z, -probe.xMax, -probe.yMax},
+                     {probe.z, probe.xMax, probe.yMax},
+                     [](double z, double x, double y) {
+                       return std::array<double, 3>{x, y, z};
+                     }});
   }
 
-  for (size_t iProbe = 0; iProbe < zPlaneProbes.size(); ++iProbe) {
-    auto& histX = zPlaneProbeHistosX.at(iProbe);
-    const auto& probe = zPlaneProbes.at(iProbe);
-    for (int i = 1; i <= histX.GetXaxis()->GetNbins(); ++i) {
-      for (int j = 1; j <= histX.GetYaxis()->GetNbins(); ++j) {
-        const double z = histX.GetXaxis()->GetBinCenter(i);
-        const double r = histX.GetYaxis()->GetBinCenter(j);
-        const double point[] = {r * std::cos(probe.phi),
-                                r * std::sin(probe.phi),
-                                z,
-                                0};
-        double field[] = {0., 0., 0.};
-        magField->GetFieldValue(point, field);
-        histX.SetBinContent(i, j, field[0] / tesla);
-        zPlaneProbeHistosY.at(iProbe).SetBinContent(i, j, field[1] / tesla);
-        zPlaneProbeHistosZ.at(iProbe).SetBinContent(i, j, field[2] / tesla);
-      }
-    }
+  for (const auto& probe : zPlaneProbes) {
+    TString gridName;
+    gridName.Form("zPlane_%i_%i_%i_%.3f_bField",
+                  (int)probe.zMin, (int)probe.zMax, (int)probe.rMax, probe.phi);
+    TString gridTitle;
+    gridTitle.Form("zPlane, phi = %.3f, bField", probe.phi);
+
+    grids.push_back({gridName.Data(), gridTitle.Data(),
+                     {"#phi", "z [mm]", "r [mm]"},
+                     {1, nBinsU, nBinsV},
+                     {probe.phi, probe.zMin, 0.},
+                     {probe.phi, probe.zMax, probe.rMax},
+                     [](double phi, double z, double r) {
+                       return std::array<double, 3>{r * std::cos(phi), r * std::sin(phi), z};
+                     }});
   }
 
-  std::vector<TH2D> tubeProbeHistosX;
-  std::vector<TH2D> tubeProbeHistosY;
-  std::vector<TH2D> tubeProbeHistosZ;
   for (const auto& probe : tubeProbes) {
-    std::string histName = "tube_";
-    histName += std::to_string((int) probe.zMin) + "_";
-    histName += std::to_string((int) probe.zMax) + "_";
-    histName += std::to_string((int) probe.r) + "_bField";
-    std::string histTitle = "Tube, r = ";
-    histTitle += std::to_string((int) probe.r) + " mm, bField";
-
-    auto histX = TH2D((histName + "_x").c_str(),
-                      (histTitle + "(x)").c_str(),
-                      500, probe.zMin, probe.zMax,
-                      500, 0., 2 * CLHEP::pi);
-    histX.GetXaxis()->SetTitle("z [mm]");
-    histX.GetYaxis()->SetTitle("#phi");
-    histX.GetZaxis()->SetTitle("B_{x} [T]");
-
-    auto histY = TH2D((histName + "_y").c_str(),
-                      (histTitle + "(y)").c_str(),
-                      500, probe.zMin, probe.zMax,
-                      500, 0., 2 * CLHEP::pi);
-    histY.GetXaxis()->SetTitle("z [mm]");
-    histY.GetYaxis()->SetTitle("#phi");
-    histY.GetZaxis()->SetTitle("B_{y} [T]");
-
-
-    auto histZ = TH2D((histName + "_z").c_str(),
-                      (histTitle + "(z)").c_str(),
-                      500, probe.zMin, probe.zMax,
-                      500, 0., 2 * CLHEP::pi);
-    histZ.GetXaxis()->SetTitle("z [mm]");
-    histZ.GetYaxis()->SetTitle("#phi");
-    histZ.GetZaxis()->SetTitle("B_{z} [T]");
-
-    tubeProbeHistosX.emplace_back(histX);
-    tubeProbeHistosY.emplace_back(histY);
-    tubeProbeHistosZ.emplace_back(histZ);
+    std::string gridName = "tube_";
+    gridName += std::to_string((int) probe.zMin) + "_";
+    gridName += std::to_string((int) probe.zMax) + "_";
+    gridName += std::to_string((int) probe.r) + "_bField";
+    std::string gridTitle = "Tube, r = ";
+    gridTitle += std::to_string((int) probe.r) + " mm, bField";
+
+    grids.push_back({gridName, gridTitle,
+                     {"r [mm]", "z [mm]", "#phi"},
+                     {1, nBinsU, nBinsV},
+                     {probe.r, probe.zMin, 0.},
+                     {probe.r, probe.zMax, 2 * CLHEP::pi},
+                     [](double r, double z, double phi) {
+                       return std::array<double, 3>{r * std::cos(phi), r * std::sin(phi), z};
+                     }});
   }
 
-  for (size_t iProbe = 0; iProbe < tubeProbes.size(); ++iProbe) {
-    auto& histX = tubeProbeHistosX.at(iProbe);
-    const auto& probe = tubeProbes.at(iProbe);
-    for (int i = 1; i <= histX.GetXaxis()->GetNbins(); ++i) {
-      for (int j = 1; j <= histX.GetYaxis()->GetNbins(); ++j) {
-        const double z = histX.GetXaxis()->GetBinCenter(i);
-        const double phi = histX.GetYaxis()->GetBinCenter(j);
-        const double point[] = {probe.r * std::cos(phi),
-                                probe.r * std::sin(phi),
-                                z,
-                                0};
-        double field[] = {0., 0., 0.};
-        magField->GetFieldValue(point, field);
-        histX.SetBinContent(i, j, field[0] / tesla);
-        tubeProbeHistosY.at(iProbe).SetBinContent(i, j, field[1] / tesla);
-        tubeProbeHistosZ.at(iProbe).SetBinContent(i, j, field[2] / tesla);
-      }
-    }
+  for (const auto& probe : boxProbes) {
+    std::string gridName = "box_";
+    gridName += std::to_string((int) probe.xMin) + "_";
+    gridName += std::to_string((int) probe.xMax) + "_";
+    gridName += std::to_string((int) probe.yMin) + "_";
+    gridName += std::to_string((int) probe.yMax) + "_";
+    gridName += std::to_string((int) probe.zMin) + "_";
+    gridName += std::to_string((int) probe.zMax) + "_bField";
+
+    grids.push_back({gridName, "Box, bField",
+                     {"x [mm]", "y [mm]", "z [mm]"},
+                     {probe.nBinsX, probe.nBinsY, probe.nBinsZ},
+                     {probe.xMin, probe.yMin, probe.zMin},
+                     {probe.xMax, probe.yMax, probe.zMax},
+                     [](double x, double y, double z) {
+                       return std::array<double, 3>{x, y, z};
+                     }});
   }
 
-  auto outFile = TFile(m_outFilePath.value().c_str(), "RECREATE");
-  for (const auto& hist : xyPlaneProbeHistosX) {
-    hist.Write();
+  StatusCode sc = StatusCode::SUCCESS;
+  if (m_outputFormat.value() == "binary") {
+    sc = writeBinary(*magField, grids);
+  } else {
+    sc = writeHistograms(*magField, grids);
   }
-  for (const auto& hist : xyPlaneProbeHistosY) {
-    hist.Write();
+  if (sc.isSuccess()) {
+    info() << "Field scanned by " << grids.size() << " probes, written to: "
+           << m_outFilePath.value() << endmsg;
   }
-  for (const auto& hist : xyPlaneProbeHistosZ) {
-    hist.Write();
+
+  return sc;
+}
+
+
+void MagFieldScanner::scanSlice(const G4MagneticField& magField,
+                                const ScanGrid& grid,
+                                size_t iSlice,
+                                std::vector<double>& values) const {
+  const size_t nRows = grid.nBins[1];
+  const size_t nRow = grid.nBins[2];
+  values.resize(3 * nRows * nRow);
+  const double u = binCenter(grid.min[0], grid.max[0], grid.nBins[0], iSlice);
+
+  // Every row of bins along the last axis is evaluated in one batch
+  auto scanRows = [&](size_t firstRow, size_t lastRow) {
+    std::vector<double> x(nRow), y(nRow), z(nRow), bField(3 * nRow);
+    for (size_t j = firstRow; j < lastRow; ++j) {
+      const double v = binCenter(grid.min[1], grid.max[1], nRows, j);
+      for (size_t k = 0; k < nRow; ++k) {
+        const auto point = grid.position(u, v, binCenter(grid.min[2], grid.max[2], nRow, k));
+        x[k] = point[0];
+        y[k] = point[1];
+        z[k] = point[2];
+      }
+      sim::getFieldValues(magField, nRow, x.data(), y.data(), z.data(),
+                          &bField[0], &bField[nRow], &bField[2 * nRow]);
+      double* rowValues = &values[3 * j * nRow];
+      for (size_t k = 0; k < nRow; ++k) {
+        for (size_t c = 0; c < 3; ++c) {
+          rowValues[3 * k + c] = bField[c * nRow + k] / tesla;
+        }
+      }
+    }
+  };
+
+  unsigned nThreads = m_nThreads.value();
+  if (nThreads == 0) {
+    nThreads = std::max(1, tbb::this_task_arena::max_concurrency());
   }
-  for (const auto& hist : zPlaneProbeHistosX) {
-    hist.Write();
+  nThreads = std::min<size_t>(nThreads, std::max<size_t>(nRows, 1));
+  if (nThreads == 1) {
+    scanRows(0, nRows);
+    return;
   }
-  for (const auto& hist : zPlaneProbeHistosY) {
-    hist.Write();
+  tbb::task_arena arena(nThreads);
+  arena.execute([&]() {
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, nRows),
+                      [&](const tbb::blocked_range<size_t>& range) { scanRows(range.begin(), range.end()); });
+  });
+}
+
+
+StatusCode MagFieldScanner::writeHistograms(const G4MagneticField& magField,
+                                            const std::vector<ScanGrid>& grids) const {
+  TFile outFile(m_outFilePath.value().c_str(), "RECREATE");
+  if (outFile.IsZombie()) {
+    error() << "Unable to create output file: " << m_outFilePath.value() << endmsg;
+    return StatusCode::FAILURE;
   }
-  for (const auto& hist : zPlaneProbeHistosZ) {
-    hist.Write();
+
+  const std::string components[] = {"x", "y", "z"};
+  std::vector<double> values;
+  for (const auto& grid : grids) {
+    scanSlice(magField, grid, 0, values);
+    // Histograms are created one at a time, only after the scan, setting their
+    // bins is not thread safe
+    for (size_t c = 0; c < 3; ++c) {
+      TH2D hist((grid.name + "_" + components[c]).c_str(),
+                (grid.title + "(" + components[c] + ")").c_str(),
+                grid.nBins[1], grid.min[1], grid.max[1],
+                grid.nBins[2], grid.min[2], grid.max[2]);
+      hist.GetXaxis()->SetTitle(grid.axisTitles[1].c_str());
+      hist.GetYaxis()->SetTitle(grid.axisTitles[2].c_str());
+      hist.GetZaxis()->SetTitle(("B_{" + components[c] + "} [T]").c_str());
+      for (size_t j = 0; j < grid.nBins[1]; ++j) {
+        for (size_t k = 0; k < grid.nBins[2]; ++k) {
+          hist.SetBinContent(j + 1, k + 1, values[3 * (j * grid.nBins[2] + k) + c]);
+        }
+      }
+      hist.Write();
+    }
   }
-  for (const auto& hist : tubeProbeHistosX) {
-    hist.Write();
+  outFile.Close();
+
+  return StatusCode::SUCCESS;
+}
+
+
+StatusCode MagFieldScanner::writeBinary(const G4MagneticField& magField,
+                                        const std::vector<ScanGrid>& grids) const {
+  std::ofstream outFile(m_outFilePath.value(), std::ios::binary);
+  if (!outFile) {
+    error() << "Unable to create output file: " << m_outFilePath.value() << endmsg;
+    return StatusCode::FAILURE;
   }
-  for (const auto& hist : tubeProbeHistosY) {
-    hist.Write();
+
+  const char magic[8] = {'k', '4', 'F', 'S', 'C', 'A', 'N', '1'};
+  outFile.write(magic, sizeof(magic));
+  writeValue(outFile, static_cast<uint32_t>(grids.size()));
+
+  std::vector<double> values;
+  std::vector<float> compactValues;
+  for (const auto& grid : grids) {
+    writeValue(outFile, static_cast<uint32_t>(grid.name.size()));
+    outFile.write(grid.name.data(), grid.name.size());
+    for (size_t a = 0; a < 3; ++a) {
+      writeValue(outFile, static_cast<uint64_t>(grid.nBins[a]));
+      writeValue(outFile, grid.min[a]);
+      writeValue(outFile, grid.max[a]);
+    }
+    // Only one slice is kept in memory
+    for (size_t i = 0; i < grid.nBins[0]; ++i) {
+      scanSlice(magField, grid, i, values);
+      compactValues.assign(values.begin(), values.end());
+      outFile.write(reinterpret_cast<const char*>(compactValues.data()),
+                    compactValues.size() * sizeof(float));
+    }
+    debug() << "Probe " << grid.name << " written" << endmsg;
   }
-  for (const auto& hist : tubeProbeHistosZ) {
-    hist.Write();
+
+  if (!outFile) {
+    error() << "Failed to write output file: " << m_outFilePath.value() << endmsg;
+    return StatusCode::FAILURE;
   }
-  outFile.Write();
-  outFile.Close();
 
   return StatusCode::SUCCESS;
 }
@@ -359,4 +426,15 @@ std::ostream& operator<<(std::ostream& outStream,
 }
 
 
+std::ostream& operator<<(std::ostream& outStream,
+                         const MagFieldScanner::BoxProbe& probe) {
+  return outStream << "box: x = [" << probe.xMin << ", " << probe.xMax
+                   << "] mm in " << probe.nBinsX << " bins, y = ["
+                   << probe.yMin << ", " << probe.yMax
+                   << "] mm in " << probe.nBinsY << " bins, z = ["
+                   << probe.zMin << ", " << probe.zMax
+                   << "] mm in " << probe.nBinsZ << " bins";
+}
+
+
 DECLARE_COMPONENT(MagFieldScanner)
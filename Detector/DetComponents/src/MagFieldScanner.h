@@ -9,16 +9,43 @@
 #include "k4Interface/ISimG4Svc.h"
 #include "k4Interface/ISimG4MagneticFieldTool.h"
 
+// STD
+#include <array>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class G4MagneticField;
+
 
 /** @class MagFieldScanner Detector/DetComponents/src/MagFieldScanner.h MagFieldScanner.h
  *
  *  Service probes the Geant4 magnetic field on initialize.
  *  This service outputs a ROOT file containing resulting histograms.
  *
- *  There are three probe types:
+ *  There are four probe types:
  *  * XYPlane probe with parameters: xMax, yMax and z
  *  * ZPlane probe with parameters: zMin, zMax, rMax and phi (angle from x-axis)
  *  * Tube probe with parameters: zMin, zMax and r
+ *  * Box probe with parameters: xMin, xMax, nBinsX, yMin, yMax, nBinsY, zMin,
+ *    zMax and nBinsZ (binary output only)
+ *
+ *  The planar probes are binned with nBins bins along each axis.
+ *
+ *  With outputFormat = "root" every planar probe is written as three TH2D
+ *  histograms, one per field component. With outputFormat = "binary" all
+ *  probes are written into a flat binary file:
+ *    file:   char[8] "k4FSCAN1", uint32 number of probes, probes
+ *    probe:  uint32 name length, name, 3 x (uint64 nBins, double min, double max),
+ *            float32 (Bx, By, Bz) in tesla for every bin, last axis running fastest
+ *  Planar probes are stored with one bin along the first axis. The box probes
+ *  are scanned and written one slice along x at a time, so their size is not
+ *  limited by the available memory.
+ *
+ *  The field is evaluated in batches, one row of bins at a time, and the rows
+ *  are distributed by tbb::parallel_for among nThreads threads (all cores by
+ *  default). Use nThreads = 1 for fields which can't be evaluated concurrently.
  *
  *  @author J. Smiesko
  *  @date 2023-06-23
@@ -45,6 +72,24 @@ private:
                                              "magFieldProbes.root",
                                              "Output file path"};
 
+  /// Format of the output file
+  Gaudi::Property<std::string> m_outputFormat{this,
+                                              "outputFormat",
+                                              "root",
+                                              "Output file format: root or binary"};
+
+  /// Number of bins of the planar probes along their two axes
+  Gaudi::Property<std::vector<unsigned>> m_nBins{this,
+                                                 "nBins",
+                                                 {500, 500},
+                                                 "Number of bins of the planar probes"};
+
+  /// Number of threads scanning the field, 0 means one per core
+  Gaudi::Property<unsigned> m_nThreads{this,
+                                       "nThreads",
+                                       0,
+                                       "Number of threads scanning the field"};
+
   /// Probes
   Gaudi::Property<std::vector<std::vector<double>>> m_xyPlaneProbes{
       this,
@@ -64,6 +109,12 @@ private:
       {},
       "Tube probe definitions"};
 
+  Gaudi::Property<std::vector<std::vector<double>>> m_boxProbes{
+      this,
+      "boxProbes",
+      {},
+      "Box probe definitions"};
+
 
   struct XYPlaneProbe {
     const double xMax;
@@ -84,12 +135,60 @@ private:
     const double r;
   };
 
+  struct BoxProbe {
+    const double xMin;
+    const double xMax;
+    const size_t nBinsX;
+    const double yMin;
+    const double yMax;
+    const size_t nBinsY;
+    const double zMin;
+    const double zMax;
+    const size_t nBinsZ;
+  };
+
+  /// Grid of bins scanned by one probe, the last axis runs fastest
+  struct ScanGrid {
+    /// Name of the probe, prefix of the histogram names
+    std::string name;
+    /// Title of the probe, prefix of the histogram titles
+    std::string title;
+    /// Titles of the axes, used for the histograms
+    std::array<std::string, 3> axisTitles;
+    /// Number of bins along the axes
+    std::array<size_t, 3> nBins;
+    /// Lower edges of the axes
+    std::array<double, 3> min;
+    /// Upper edges of the axes
+    std::array<double, 3> max;
+    /// Position of the bin center given by the axis coordinates
+    std::function<std::array<double, 3>(double, double, double)> position;
+  };
+
+  /// Evaluate the field in one slice of the grid (fixed bin along the first axis)
+  /// @param[in] magField the scanned field
+  /// @param[in] grid the scanned grid
+  /// @param[in] iSlice index of the bin along the first axis
+  /// @param[out] values (Bx, By, Bz) triplets in tesla, last axis running fastest
+  void scanSlice(const G4MagneticField& magField, const ScanGrid& grid,
+                 size_t iSlice, std::vector<double>& values) const;
+
+  /// Write the planar probes as histograms into the ROOT file
+  StatusCode writeHistograms(const G4MagneticField& magField,
+                             const std::vector<ScanGrid>& grids) const;
+
+  /// Write all probes into the flat binary file
+  StatusCode writeBinary(const G4MagneticField& magField,
+                         const std::vector<ScanGrid>& grids) const;
+
   friend std::ostream& operator<<(std::ostream& outStream,
                                   const XYPlaneProbe& probe);
   friend std::ostream& operator<<(std::ostream& outStream,
                                   const ZPlaneProbe& probe);
   friend std::ostream& operator<<(std::ostream& outStream,
                                   const TubeProbe& probe);
+  friend std::ostream& operator<<(std::ostream& outStream,
+                                  const BoxProbe& probe);
 };
 
 #endif /* MAGFIELDSCANNER_H */
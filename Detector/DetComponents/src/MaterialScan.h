@@ -1,6 +1,5 @@
 #include "k4Interface/IGeoSvc.h"
 
-#include "GaudiKernel/RndmGenerators.h"
 #include "GaudiKernel/Service.h"
 
 /** @class MaterialScan Detector/DetComponents/src/MaterialScan.h MaterialScan.h
@@ -9,6 +8,10 @@
  *  This service outputs a ROOT file containing a TTree with radiation lengths and material thickness
  *  For an example on how to read the file, see Examples/scripts/material_plots.py
  *
+ *  The eta bins are scanned by MaterialScanEngine with nThreads threads. Random numbers of every
+ *  bin are generated from the seed and the bin index, so the output does not depend on the
+ *  number of threads.
+ *
  *  !!! Superseeded by MaterialScan_genericAngle.h that extends this script by the possibility
  *  to use also theta (degrees), theta (radians) or cos(theta) instead of eta. !!!
  *  @author J. Lingemann
@@ -37,9 +40,8 @@ private:
   /// Name of the envelope within which the material is measured (by default: world volume)
   Gaudi::Property<std::string> m_envelopeName{this, "envelopeName", "world",
                                               "name of the envelope within which the material is measured"};
-  /// Flat random number generator
-  Rndm::Numbers m_flatPhiDist;
-  /// Flat random number generator
-  Rndm::Numbers m_flatEtaDist;
-
+  /// Number of threads scanning the eta bins, 0 means one per core
+  Gaudi::Property<unsigned> m_nThreads{this, "nThreads", 1, "number of threads scanning the eta bins, 0 for one per core"};
+  /// Seed of the random phi and eta values
+  Gaudi::Property<unsigned> m_seed{this, "seed", 12345, "seed of the random phi and eta values"};
 };
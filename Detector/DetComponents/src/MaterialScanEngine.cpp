@@ -0,0 +1,221 @@
+#include "MaterialScanEngine.h"
+#include "MaterialTreeWriter.h"
+
+#include "DDRec/MaterialManager.h"
+#include "DDRec/Vector3D.h"
+
+#include "TGeoManager.h"
+#include "TGeoMaterial.h"
+#include "TList.h"
+#include "TVector3.h"
+
+#include "tbb/blocked_range.h"
+#include "tbb/global_control.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+/// Multi-threaded navigation of the geometry for the duration of the scan, the previous mode is restored afterwards
+class ThreadedNavigation {
+public:
+  ThreadedNavigation(TGeoManager* geoManager, unsigned nThreads)
+      : m_geoManager(geoManager), m_previousMaxThreads(geoManager->GetMaxThreads()) {
+    m_geoManager->SetMaxThreads(nThreads);
+  }
+  ~ThreadedNavigation() {
+    m_geoManager->ClearThreadsMap();
+    m_geoManager->SetMaxThreads(m_previousMaxThreads);
+  }
+  ThreadedNavigation(const ThreadedNavigation&) = delete;
+  ThreadedNavigation& operator=(const ThreadedNavigation&) = delete;
+
+private:
+  TGeoManager* m_geoManager;
+  int m_previousMaxThreads;
+};
+}
+
+namespace det {
+MaterialScanEngine::MaterialScanEngine(dd4hep::Volume envelope, unsigned nThreads, size_t batchSize)
+    : m_envelope(envelope), m_boundary(envelope->GetShape()), m_nThreads(nThreads),
+      m_batchSize(std::max<size_t>(batchSize, 1)) {
+  if (m_nThreads == 0) {
+    m_nThreads = std::max(1, tbb::this_task_arena::max_concurrency());
+  }
+  // GetIndex caches the position in the list, afterwards it can be called concurrently
+  TIter next(envelope->GetGeoManager()->GetListOfMaterials());
+  while (TGeoMaterial* material = static_cast<TGeoMaterial*>(next())) {
+    const size_t id = material->GetIndex();
+    if (id >= m_materials.size()) {
+      m_materials.resize(id + 1);
+    }
+    m_materials[id] = {material->GetName(), material->GetRadLen(), material->GetIntLen()};
+  }
+}
+
+MaterialScanEngine::Result MaterialScanEngine::scan(size_t nEntries, const RayGenerator& generator) const {
+  TGeoManager* geoManager = m_envelope->GetGeoManager();
+  const unsigned nThreads = std::min<size_t>(m_nThreads, std::max<size_t>(nEntries, 1));
+
+  // materials of every entry, concatenated into the columns once all entries are scanned
+  std::vector<std::vector<int>> entryIds(nEntries);
+  std::vector<std::vector<double>> entryDepths(nEntries);
+  // cumulative profiles have fixed size, entries are written directly into the result
+  const size_t nCheckpoints = m_checkpoints.size();
+  Result result;
+  result.cumulativeX0.resize(nEntries * nCheckpoints, 0.);
+  result.cumulativeLambda.resize(nEntries * nCheckpoints, 0.);
+  // scans the entries of the range, with its own navigator created in the calling thread if several threads navigate
+  auto scanEntries = [&](size_t firstEntry, size_t lastEntry, bool ownNavigator) {
+    TGeoNavigator* navigator = ownNavigator ? geoManager->CreateNavigator() : nullptr;
+    dd4hep::rec::MaterialManager matMgr(m_envelope);
+    const dd4hep::rec::Vector3D beginning(0, 0, 0);
+    const double origin[3] = {0, 0, 0};
+    std::vector<double> depths(m_materials.size(), 0.);
+    std::vector<char> found(m_materials.size(), 0);
+    std::vector<int> foundIds;
+    std::vector<Ray> rays;
+    for (size_t iEntry = firstEntry; iEntry < lastEntry; ++iEntry) {
+      rays.clear();
+      generator(iEntry, rays);
+      double* profileX0 = result.cumulativeX0.data() + iEntry * nCheckpoints;
+      double* profileLambda = result.cumulativeLambda.data() + iEntry * nCheckpoints;
+      for (const auto& ray : rays) {
+        // if the start point (origin) is inside the envelope (e.g. if envelope is world volume)
+        double distance = m_boundary->DistFromInside(origin, ray.direction.data());
+        // if the start point (origin) is not inside the envelope
+        if (distance == 0) {
+          distance = m_boundary->DistFromOutside(origin, ray.direction.data());
+        }
+        const dd4hep::rec::Vector3D end(ray.direction[0] * distance, ray.direction[1] * distance,
+                                        ray.direction[2] * distance);
+        const dd4hep::rec::MaterialVec& materials = matMgr.materialsBetween(beginning, end);
+        // the materials are ordered along the ray, starting in the origin
+        double path = 0.;
+        double sumX0 = 0.;
+        double sumLambda = 0.;
+        size_t iCheckpoint = 0;
+        for (const auto& material : materials) {
+          const int id = material.first->GetMaterial()->GetIndex();
+          if (!found[id]) {
+            found[id] = 1;
+            foundIds.push_back(id);
+          }
+          depths[id] += material.second * ray.weight;
+
+          const MaterialInfo& info = m_materials[id];
+          for (; iCheckpoint < nCheckpoints && m_checkpoints[iCheckpoint] <= path + material.second; ++iCheckpoint) {
+            const double inside = m_checkpoints[iCheckpoint] - path;
+            profileX0[iCheckpoint] += ray.weight * (sumX0 + inside / info.radLength);
+            profileLambda[iCheckpoint] += ray.weight * (sumLambda + inside / info.intLength);
+          }
+          path += material.second;
+          sumX0 += material.second / info.radLength;
+          sumLambda += material.second / info.intLength;
+        }
+        // checkpoints outside of the envelope see all the material along the ray
+        for (; iCheckpoint < nCheckpoints; ++iCheckpoint) {
+          profileX0[iCheckpoint] += ray.weight * sumX0;
+          profileLambda[iCheckpoint] += ray.weight * sumLambda;
+        }
+      }
+      std::sort(foundIds.begin(), foundIds.end());
+      for (int id : foundIds) {
+        entryIds[iEntry].push_back(id);
+        entryDepths[iEntry].push_back(depths[id]);
+        depths[id] = 0.;
+        found[id] = 0;
+      }
+      foundIds.clear();
+    }
+    if (navigator) {
+      geoManager->RemoveNavigator(navigator);
+    }
+  };
+
+  if (nThreads > 1) {
+    // the tasks may run in any thread of the TBB pool, each of them has to be known to the geometry
+    const size_t maxThreads = tbb::global_control::active_value(tbb::global_control::max_allowed_parallelism);
+    ThreadedNavigation threadedNavigation(geoManager, std::max<size_t>(nThreads, maxThreads));
+    tbb::task_arena arena(nThreads);
+    arena.execute([&]() {
+      tbb::parallel_for(
+          tbb::blocked_range<size_t>(0, nEntries, m_batchSize),
+          [&](const tbb::blocked_range<size_t>& range) { scanEntries(range.begin(), range.end(), true); },
+          tbb::simple_partitioner());
+    });
+  } else {
+    scanEntries(0, nEntries, false);
+  }
+
+  result.offsets.reserve(nEntries + 1);
+  for (size_t iEntry = 0; iEntry < nEntries; ++iEntry) {
+    result.materialIds.insert(result.materialIds.end(), entryIds[iEntry].begin(), entryIds[iEntry].end());
+    result.depths.insert(result.depths.end(), entryDepths[iEntry].begin(), entryDepths[iEntry].end());
+    result.offsets.push_back(result.materialIds.size());
+  }
+  return result;
+}
+
+bool MaterialScanEngine::writeTree(const std::string& fileName,
+                                   const std::vector<std::pair<std::string, std::vector<double>>>& columns,
+                                   const Result& result) const {
+  std::vector<std::string> columnNames;
+  std::vector<const double*> columnValues;
+  for (const auto& column : columns) {
+    if (column.second.size() < result.size()) {
+      return false;
+    }
+    columnNames.push_back(column.first);
+    columnValues.push_back(column.second.data());
+  }
+  try {
+    MaterialTreeWriter writer(m_materials, columnNames);
+    writer.open(fileName);
+    writer.fill(columnValues, result);
+    writer.close();
+  } catch (const std::runtime_error&) {
+    return false;
+  }
+  return true;
+}
+
+bool MaterialScanEngine::parseAngleDefinition(const std::string& name, AngleDefinition& definition) {
+  if (name == "eta") {
+    definition = AngleDefinition::Eta;
+  } else if (name == "theta") {
+    definition = AngleDefinition::Theta;
+  } else if (name == "thetaRad") {
+    definition = AngleDefinition::ThetaRad;
+  } else if (name == "cosTheta") {
+    definition = AngleDefinition::CosTheta;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+std::array<double, 3> MaterialScanEngine::direction(AngleDefinition definition, double angle, double phi) {
+  TVector3 vec(0, 0, 0);
+  switch (definition) {
+    case AngleDefinition::Eta:
+      vec.SetPtEtaPhi(1, angle, phi);
+      break;
+    case AngleDefinition::Theta:
+      vec.SetPtThetaPhi(1, angle / 360.0 * 2 * M_PI, phi);
+      break;
+    case AngleDefinition::ThetaRad:
+      vec.SetPtThetaPhi(1, angle, phi);
+      break;
+    case AngleDefinition::CosTheta:
+      vec.SetPtThetaPhi(1, std::acos(angle), phi);
+      break;
+  }
+  auto n = vec.Unit();
+  return {n.X(), n.Y(), n.Z()};
+}
+}
@@ -0,0 +1,126 @@
+#ifndef DETCOMPONENTS_MATERIALSCANENGINE_H
+#define DETCOMPONENTS_MATERIALSCANENGINE_H
+
+#include "DD4hep/Volumes.h"
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class TGeoShape;
+
+namespace det {
+/** @class det::MaterialScanEngine Detector/DetComponents/src/MaterialScanEngine.h MaterialScanEngine.h
+ *
+ *  Ray casting shared by the material scan services.
+ *
+ *  The scan consists of entries (rows of the output tree), every entry averages the material
+ *  along several rays starting in the origin and ending at the boundary of the envelope.
+ *  The rays of an entry are provided by the generator given to scan(), which is called
+ *  concurrently and has to depend only on the entry index.
+ *  Entries are scanned in batches by tbb::parallel_for in an arena of nThreads threads, every
+ *  batch with its own geometry navigator and material manager. The geometry is switched to
+ *  multi-threaded navigation only for the duration of scan(). Materials are identified by
+ *  their index in the list of materials of the geometry, the thickness is accumulated in a
+ *  dense array indexed by it.
+ *  The result is stored column-wise, with materials of every entry ordered by their ID, so
+ *  the output does not depend on the number of threads.
+ *  With radial checkpoints set, the cumulative number of X0 and lambda from the origin up to
+ *  every checkpoint (distance along the ray) is recorded for every entry as well.
+ */
+class MaterialScanEngine {
+public:
+  /// Definitions of the polar angle of the scan
+  enum class AngleDefinition { Eta, Theta, ThetaRad, CosTheta };
+
+  /// Ray starting in the origin, the thickness of its materials is multiplied by the weight
+  struct Ray {
+    std::array<double, 3> direction;
+    double weight;
+  };
+
+  /// Fills the rays of the entry
+  using RayGenerator = std::function<void(size_t iEntry, std::vector<Ray>& rays)>;
+
+  /// Properties of the material referenced by its ID
+  struct MaterialInfo {
+    std::string name;
+    /// Radiation length in cm
+    double radLength;
+    /// Nuclear interaction length in cm
+    double intLength;
+  };
+
+  /// Materials found in all entries, stored column-wise
+  struct Result {
+    /// Position of the first material of every entry in the columns, followed by the total size
+    std::vector<size_t> offsets{0};
+    /// ID of the material
+    std::vector<int> materialIds;
+    /// Weighted thickness of the material in cm
+    std::vector<double> depths;
+    /// Weighted cumulative number of X0 at the radial checkpoints, checkpoints running fastest
+    std::vector<double> cumulativeX0;
+    /// Weighted cumulative number of lambda at the radial checkpoints, checkpoints running fastest
+    std::vector<double> cumulativeLambda;
+    /// Number of entries
+    size_t size() const { return offsets.size() - 1; }
+  };
+
+  /// Constructor
+  /// @param[in] envelope volume within which the material is measured
+  /// @param[in] nThreads number of threads, 0 means one per core
+  /// @param[in] batchSize number of entries scanned by one task
+  explicit MaterialScanEngine(dd4hep::Volume envelope, unsigned nThreads = 1, size_t batchSize = 8);
+
+  /// Scan the material of the entries
+  /// @param[in] nEntries number of entries
+  /// @param[in] generator provides the rays of every entry
+  Result scan(size_t nEntries, const RayGenerator& generator) const;
+
+  /// Write the result into the ROOT file as a TTree "materials"
+  /// @param[in] fileName path to the output file
+  /// @param[in] columns values stored per entry in front of the materials, e.g. the angles
+  /// @param[in] result the scanned materials
+  /// @returns false if the file can't be written
+  bool writeTree(const std::string& fileName,
+                 const std::vector<std::pair<std::string, std::vector<double>>>& columns,
+                 const Result& result) const;
+
+  /// Record the cumulative material at the distances from the origin
+  /// @param[in] checkpoints increasing distances in DD4hep units
+  void setRadialCheckpoints(const std::vector<double>& checkpoints) { m_checkpoints = checkpoints; }
+
+  /// Table of the materials indexed by their ID
+  const std::vector<MaterialInfo>& materials() const { return m_materials; }
+
+  /// Number of threads used by the scan
+  unsigned nThreads() const { return m_nThreads; }
+
+  /// Convert the name ("eta", "theta", "thetaRad" or "cosTheta") into the angle definition
+  /// @returns false if the name is not recognized
+  static bool parseAngleDefinition(const std::string& name, AngleDefinition& definition);
+
+  /// Unit vector of the direction given by the polar angle and phi
+  static std::array<double, 3> direction(AngleDefinition definition, double angle, double phi);
+
+private:
+  /// Volume within which the material is measured
+  dd4hep::Volume m_envelope;
+  /// Shape of the envelope, the rays end at its boundary
+  const TGeoShape* m_boundary;
+  /// Table of the materials indexed by their ID
+  std::vector<MaterialInfo> m_materials;
+  /// Number of threads
+  unsigned m_nThreads;
+  /// Number of entries scanned by one task
+  size_t m_batchSize;
+  /// Distances from the origin where the cumulative material is recorded
+  std::vector<double> m_checkpoints;
+};
+}
+
+#endif /* DETCOMPONENTS_MATERIALSCANENGINE_H */
@@ -1,20 +1,34 @@
 #include "MaterialScan_2D_genericAngle.h"
+#include "MaterialScanEngine.h"
+#include "MaterialTreeWriter.h"
 #include "k4Interface/IGeoSvc.h"
+#include "SimG4Common/MaterialMap.h"
 
-#include "GaudiKernel/IRndmGenSvc.h"
 #include "GaudiKernel/ITHistSvc.h"
-#include "GaudiKernel/RndmGenerators.h"
 #include "GaudiKernel/Service.h"
 
 #include "DD4hep/Detector.h"
-#include "DD4hep/Printout.h"
-#include "DDRec/MaterialManager.h"
-#include "DDRec/Vector3D.h"
 
-#include "TFile.h"
 #include "TMath.h"
-#include "TTree.h"
-#include "TVector3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+sim::MaterialMap::AngleDefinition mapAngleDefinition(det::MaterialScanEngine::AngleDefinition definition) {
+  switch (definition) {
+    case det::MaterialScanEngine::AngleDefinition::Theta:
+      return sim::MaterialMap::AngleDefinition::Theta;
+    case det::MaterialScanEngine::AngleDefinition::ThetaRad:
+      return sim::MaterialMap::AngleDefinition::ThetaRad;
+    case det::MaterialScanEngine::AngleDefinition::CosTheta:
+      return sim::MaterialMap::AngleDefinition::CosTheta;
+    default:
+      return sim::MaterialMap::AngleDefinition::Eta;
+  }
+}
+}
 
 MaterialScan_2D_genericAngle::MaterialScan_2D_genericAngle(const std::string& name, ISvcLocator* svcLoc) : Service(name, svcLoc),
 m_geoSvc("GeoSvc", name) {}
@@ -29,104 +43,117 @@ StatusCode MaterialScan_2D_genericAngle::initialize() {
     return StatusCode::FAILURE;
   }
 
-  std::list<std::string> allowed_angleDef = {"eta", "theta", "thetaRad", "cosTheta"};
-  if (std::find(allowed_angleDef.begin(), allowed_angleDef.end(), m_angleDef) == allowed_angleDef.end()){
+  det::MaterialScanEngine::AngleDefinition angleDef;
+  if (!det::MaterialScanEngine::parseAngleDefinition(m_angleDef, angleDef)) {
     error() << "Non valid angleDef option given. Use either 'eta', 'theta', 'thetaRad' or 'cosTheta'!" << endmsg;
     return StatusCode::FAILURE;
   }
 
-  SmartIF<IRndmGenSvc> randSvc;
-  randSvc = service("RndmGenSvc");
-  StatusCode sc = m_flatAngleDist.initialize(randSvc, Rndm::Flat(0., m_angleBinning));
-  if (sc == StatusCode::FAILURE) {
-    error() << "Unable to initialize random number generator." << endmsg;
-    return sc;
+  // one entry per (angle, phi) bin, evaluated in the bin centre
+  std::vector<double> angles;
+  std::vector<double> phis;
+  size_t nAngleBins = 0;
+  for (double angle = m_angleMin; angle < m_angleMax; angle += m_angleBinning) {
+    ++nAngleBins;
+    for (int iPhi = 0; iPhi < m_nPhi; ++iPhi) {
+      angles.push_back(angle + 0.5 * m_angleBinning);
+      phis.push_back(-M_PI + (0.5 + iPhi) / m_nPhi * 2 * M_PI);
+    }
   }
 
-  std::unique_ptr<TFile> rootFile(TFile::Open(m_filename.value().c_str(), "RECREATE"));
-  // no smart pointers possible because TTree is owned by rootFile (root mem management FTW!)
-  TTree* tree = new TTree("materials", "");
-  double angle = 0;
-  double phi = 0;
-  double angleRndm = 0;
-  unsigned nMaterials = 0;
-  std::unique_ptr<std::vector<double>> nX0(new std::vector<double>);
-  std::unique_ptr<std::vector<double>> nLambda(new std::vector<double>);
-  std::unique_ptr<std::vector<double>> matDepth(new std::vector<double>);
-  std::unique_ptr<std::vector<std::string>> material(new std::vector<std::string>);
-  auto nX0Ptr = nX0.get();
-  auto nLambdaPtr = nLambda.get();
-  auto matDepthPtr = matDepth.get();
-  auto materialPtr = material.get();
-
-  tree->Branch("angle", &angleRndm);
-  tree->Branch("phi", &phi);
-  tree->Branch("nMaterials", &nMaterials);
-  tree->Branch("nX0", &nX0Ptr);
-  tree->Branch("nLambda", &nLambdaPtr);
-  tree->Branch("matDepth", &matDepthPtr);
-  tree->Branch("material", &materialPtr);
+  // the shard scans its part of the angle bins, with all phi bins
+  if (m_nShards == 0 || m_shard >= m_nShards) {
+    error() << "Shard " << m_shard.value() << " out of " << m_nShards.value() << " shards requested" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  const size_t nPhiBins = nAngleBins > 0 ? angles.size() / nAngleBins : 0;
+  const size_t firstEntry = m_shard * nAngleBins / m_nShards * nPhiBins;
+  const size_t endEntry = (m_shard + 1) * nAngleBins / m_nShards * nPhiBins;
+  det::MaterialTreeWriter::ShardInfo shard;
+  shard.shard = m_shard;
+  shard.nShards = m_nShards;
+  shard.firstEntry = firstEntry;
+  shard.endEntry = endEntry;
+
+  const bool writeMap = !m_mapFilename.empty();
+  if (writeMap && (m_nShards > 1 || m_resume)) {
+    error() << "Material map can only be written by a single job scanning all bins, without resume" << endmsg;
+    return StatusCode::FAILURE;
+  }
 
   auto lcdd = m_geoSvc->getDetector();
-  dd4hep::rec::MaterialManager matMgr(lcdd->detector(m_envelopeName).volume());
-  dd4hep::rec::Vector3D beginning(0, 0, 0);
-  auto boundaryVol = lcdd->detector(m_envelopeName).volume()->GetShape();
-  std::array<Double_t, 3> pos = {0, 0, 0};
-  std::array<Double_t, 3> dir = {0, 0, 0};
-  TVector3 vec(0, 0, 0);
+  det::MaterialScanEngine engine(lcdd->detector(m_envelopeName).volume(), m_nThreads);
+  if (writeMap) {
+    if (m_mapNRadii < 2 || m_mapRMax <= 0) {
+      error() << "Material map needs at least two checkpoints and positive mapRMax" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    // checkpoints equally spaced in the distance from the origin, converted from mm to DD4hep units
+    std::vector<double> checkpoints;
+    for (unsigned iRadius = 0; iRadius < m_mapNRadii; ++iRadius) {
+      checkpoints.push_back(m_mapRMax * iRadius / (m_mapNRadii - 1) * dd4hep::mm);
+    }
+    engine.setRadialCheckpoints(checkpoints);
+  }
 
-  for (angle = m_angleMin; angle < m_angleMax; angle += m_angleBinning) {
-    std::cout << m_angleDef << ": " << angle << std::endl;
+  det::MaterialTreeWriter writer(engine.materials(), {"angle", "phi"});
+  size_t nResumed = 0;
+  try {
+    writer.open(m_filename, &shard, m_resume);
+    nResumed = writer.nEntries();
+  } catch (const std::runtime_error& e) {
+    error() << e.what() << endmsg;
+    return StatusCode::FAILURE;
+  }
+  const size_t nShardEntries = endEntry - firstEntry;
+  if (nResumed > nShardEntries) {
+    error() << "File " << m_filename.value() << " to resume has more entries than the shard" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  if (m_nShards > 1 || nResumed > 0) {
+    info() << "Shard " << m_shard.value() << " of " << m_nShards.value() << " scans entries [" << firstEntry << ", "
+           << endEntry << "), " << nResumed << " of them resumed from " << m_filename.value() << endmsg;
+  }
 
-    for (int iPhi = 0; iPhi < m_nPhi; ++iPhi) {
-      nX0->clear();
-      nLambda->clear();
-      matDepth->clear();
-      material->clear();
-
-      std::map<dd4hep::Material, double> phiMaterialsBetween; // For phi scan
-
-      phi = -M_PI + (0.5+iPhi)/m_nPhi * 2 * M_PI;
-      angleRndm = angle+0.5*m_angleBinning;
-
-      if(m_angleDef=="eta")
-        vec.SetPtEtaPhi(1, angleRndm, phi);
-      else if(m_angleDef=="theta")
-        vec.SetPtThetaPhi(1, angleRndm/360.0*2*M_PI, phi);
-      else if(m_angleDef=="thetaRad")
-        vec.SetPtThetaPhi(1, angleRndm, phi);
-      else if(m_angleDef=="cosTheta")
-        vec.SetPtThetaPhi(1, acos(angleRndm), phi);
-          
-      auto n = vec.Unit();
-      dir = {n.X(), n.Y(), n.Z()};
-      // if the start point (beginning) is inside the material-scan envelope (e.g. if envelope is world volume)
-      double distance = boundaryVol->DistFromInside(pos.data(), dir.data());
-      // if the start point (beginning) is not inside the envelope
-      if (distance == 0) {
-        distance = boundaryVol->DistFromOutside(pos.data(), dir.data());
-      }
-      dd4hep::rec::Vector3D end(dir[0] * distance, dir[1] * distance, dir[2] * distance);
-      debug() << "Calculating material between 0 and (" << end.x() << ", " << end.y() << ", " << end.z()
-              << ") <=> " << m_angleDef << " = " << angle << ", phi =  " << phi << endmsg;
-      const dd4hep::rec::MaterialVec& materials = matMgr.materialsBetween(beginning, end);
-      for (unsigned i = 0, n_materials = materials.size(); i < n_materials; ++i) {
-        phiMaterialsBetween[materials[i].first] += materials[i].second;
-      }
-      nMaterials = phiMaterialsBetween.size();
-      for (auto matpair : phiMaterialsBetween) {
-        TGeoMaterial* mat = matpair.first->GetMaterial();
-        material->push_back(mat->GetName());
-        matDepth->push_back(matpair.second);
-        nX0->push_back(matpair.second / mat->GetRadLen());
-        nLambda->push_back(matpair.second / mat->GetIntLen());
+  // the tree is flushed into the file after every chunk of entries
+  const size_t chunkSize = m_checkpointEntries > 0 ? m_checkpointEntries.value() : std::max<size_t>(nShardEntries, 1);
+  std::vector<double> cumulativeX0;
+  std::vector<double> cumulativeLambda;
+  for (size_t first = firstEntry + nResumed; first < endEntry; first += chunkSize) {
+    const size_t nEntries = std::min(chunkSize, endEntry - first);
+    auto generateRays = [&](size_t iEntry, std::vector<det::MaterialScanEngine::Ray>& rays) {
+      rays.push_back(
+          {det::MaterialScanEngine::direction(angleDef, angles[first + iEntry], phis[first + iEntry]), 1.});
+    };
+    const det::MaterialScanEngine::Result result = engine.scan(nEntries, generateRays);
+    writer.fill({&angles[first], &phis[first]}, result);
+    writer.checkpoint();
+    debug() << "Checkpoint with " << writer.nEntries() << " of " << nShardEntries << " entries written" << endmsg;
+    cumulativeX0.insert(cumulativeX0.end(), result.cumulativeX0.begin(), result.cumulativeX0.end());
+    cumulativeLambda.insert(cumulativeLambda.end(), result.cumulativeLambda.begin(), result.cumulativeLambda.end());
+  }
+  writer.close();
+  info() << "Material scanned in " << nShardEntries - nResumed << " " << m_angleDef.value() << "-phi bins by "
+         << engine.nThreads() << " threads" << endmsg;
+
+  if (writeMap) {
+    try {
+      sim::MaterialMap map(mapAngleDefinition(angleDef), nAngleBins, m_angleMin,
+                           m_angleMin + nAngleBins * m_angleBinning, m_nPhi, m_mapNRadii, m_mapRMax);
+      for (size_t iAngle = 0; iAngle < nAngleBins; ++iAngle) {
+        for (size_t iPhi = 0; iPhi < map.nPhiBins(); ++iPhi) {
+          const size_t offset = (iAngle * map.nPhiBins() + iPhi) * m_mapNRadii;
+          map.setBin(iAngle, iPhi, &cumulativeX0[offset], &cumulativeLambda[offset]);
+        }
       }
-      tree->Fill();
+      map.write(m_mapFilename);
+    } catch (const std::exception& e) {
+      error() << "Unable to write the material map: " << e.what() << endmsg;
+      return StatusCode::FAILURE;
     }
+    info() << "Material map with " << nAngleBins << " x " << m_nPhi << " bins and " << m_mapNRadii
+           << " checkpoints written to " << m_mapFilename.value() << endmsg;
   }
-  tree->Write();
-  rootFile->Close();
-
   return StatusCode::SUCCESS;
 }
 
@@ -1,7 +1,7 @@
 #include "k4Interface/IGeoSvc.h"
 
-#include "GaudiKernel/RndmGenerators.h"
 #include "GaudiKernel/Service.h"
+#include "GaudiKernel/SystemOfUnits.h"
 
 /** @class MaterialScan_2D_genericAngle Detector/DetComponents/src/MaterialScan_2D_genericAngle.h MaterialScan_2D_genericAngle.h
  *
@@ -10,6 +10,16 @@
  *  in both eta/theta (in degrees)/cos(theta)/theta (in radians) and in phi (2D material scan).
  *  For an example on how to read the file, see Examples/scripts/material_plots.py
  *
+ *  The (angle, phi) bins are scanned by MaterialScanEngine with nThreads threads.
+ *  Large scans can be split into \b'nShards' jobs, the job \b'shard' i scans the angle bins
+ *  [i/N, (i+1)/N) of the range, with all phi bins. The tree is flushed into the file every
+ *  \b'checkpointEntries' entries, a killed job can be continued with \b'resume'. The shards are
+ *  combined into the output of the full scan with Detector/DetComponents/scripts/mergeMaterialScans.py.
+ *  With \b'mapFilename' set, the cumulative X0 and lambda along the rays are also written into
+ *  a binary lookup table (sim::MaterialMap), sampled at \b'mapNRadii' distances from the origin
+ *  up to \b'mapRMax'. Other components read it to get the material between two radii without
+ *  ray-tracing the geometry.
+ *
  *  @author J. Lingemann, A. Ilg
  */
 
@@ -43,7 +53,21 @@ private:
   /// Name of the envelope within which the material is measured (by default: world volume)
   Gaudi::Property<std::string> m_envelopeName{this, "envelopeName", "world",
                                               "name of the envelope within which the material is measured"};
-  /// Flat random number generator
-  Rndm::Numbers m_flatAngleDist;
-
+  /// name of the material map file, no map is written if empty
+  Gaudi::Property<std::string> m_mapFilename{this, "mapFilename", "", "file name to save the material map to"};
+  /// Distance from the origin of the last checkpoint of the material map
+  Gaudi::Property<double> m_mapRMax{this, "mapRMax", 6 * Gaudi::Units::m, "maximum distance stored in the material map"};
+  /// Number of checkpoints along every ray of the material map
+  Gaudi::Property<unsigned> m_mapNRadii{this, "mapNRadii", 100, "number of checkpoints along the rays of the material map"};
+  /// Number of jobs the scan is split into
+  Gaudi::Property<unsigned> m_nShards{this, "nShards", 1, "number of jobs the angle range is split into"};
+  /// Index of the job within the split scan
+  Gaudi::Property<unsigned> m_shard{this, "shard", 0, "index of the job scanning its part of the angle range"};
+  /// Number of entries after which the tree is flushed into the file, 0 means only at the end
+  Gaudi::Property<unsigned> m_checkpointEntries{this, "checkpointEntries", 0,
+                                                "number of entries after which the tree is flushed into the file"};
+  /// Continue the scan stored in the output file of a killed job
+  Gaudi::Property<bool> m_resume{this, "resume", false, "continue the scan stored in the output file"};
+  /// Number of threads scanning the bins, 0 means one per core
+  Gaudi::Property<unsigned> m_nThreads{this, "nThreads", 1, "number of threads scanning the bins, 0 for one per core"};
 };
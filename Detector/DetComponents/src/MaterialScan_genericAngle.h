@@ -1,6 +1,5 @@
 #include "k4Interface/IGeoSvc.h"
 
-#include "GaudiKernel/RndmGenerators.h"
 #include "GaudiKernel/Service.h"
 
 /** @class MaterialScan_genericAngle Detector/DetComponents/src/MaterialScan_genericAngle.h MaterialScan_genericAngle.h
@@ -10,6 +9,10 @@
  *  in either eta, theta (in degrees), cos(theta) or theta (in radians).
  *  For an example on how to read the file, see Examples/scripts/material_plots.py
  *
+ *  The angle bins are scanned by MaterialScanEngine with nThreads threads. Random numbers of every
+ *  bin are generated from the seed and the bin index, so the output does not depend on the
+ *  number of threads.
+ *
  *  This script superseeds Detector/DetComponents/src/MaterialScan.cpp
  *  @author J. Lingemann, A. Ilg
  */
@@ -42,9 +45,8 @@ private:
   /// Name of the envelope within which the material is measured (by default: world volume)
   Gaudi::Property<std::string> m_envelopeName{this, "envelopeName", "world",
                                               "name of the envelope within which the material is measured"};
-  /// Flat random number generator
-  Rndm::Numbers m_flatPhiDist;
-  /// Flat random number generator
-  Rndm::Numbers m_flatAngleDist;
-
+  /// Number of threads scanning the angle bins, 0 means one per core
+  Gaudi::Property<unsigned> m_nThreads{this, "nThreads", 1, "number of threads scanning the angle bins, 0 for one per core"};
+  /// Seed of the random phi and angle values
+  Gaudi::Property<unsigned> m_seed{this, "seed", 12345, "seed of the random phi and angle values"};
 };
@@ -0,0 +1,117 @@
+#include "MaterialTreeWriter.h"
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include <stdexcept>
+
+namespace det {
+MaterialTreeWriter::MaterialTreeWriter(const std::vector<MaterialScanEngine::MaterialInfo>& materials,
+                                       const std::vector<std::string>& columnNames)
+    : m_materials(materials), m_columnNames(columnNames), m_columnValues(columnNames.size(), 0.) {}
+
+MaterialTreeWriter::~MaterialTreeWriter() { close(); }
+
+void MaterialTreeWriter::open(const std::string& fileName, const ShardInfo* shard, bool resume) {
+  // UPDATE creates the file if it doesn't exist and recovers the trees saved before the job was killed
+  m_file.reset(TFile::Open(fileName.c_str(), resume ? "UPDATE" : "RECREATE"));
+  if (!m_file || m_file->IsZombie()) {
+    throw std::runtime_error("Unable to open the output file " + fileName);
+  }
+  if (resume) {
+    m_tree = m_file->Get<TTree>("materials");
+  }
+
+  if (m_tree == nullptr) {
+    if (shard != nullptr) {
+      ShardInfo info = *shard;
+      TTree* shardTree = new TTree("shardInfo", "");
+      shardTree->Branch("shard", &info.shard);
+      shardTree->Branch("nShards", &info.nShards);
+      shardTree->Branch("firstEntry", &info.firstEntry);
+      shardTree->Branch("endEntry", &info.endEntry);
+      shardTree->Fill();
+      shardTree->Write("", TObject::kOverwrite);
+      shardTree->ResetBranchAddresses();
+    }
+    // no smart pointers possible because TTree is owned by the file (root mem management FTW!)
+    m_tree = new TTree("materials", "");
+    for (size_t iColumn = 0; iColumn < m_columnNames.size(); ++iColumn) {
+      m_tree->Branch(m_columnNames[iColumn].c_str(), &m_columnValues[iColumn]);
+    }
+    m_tree->Branch("nMaterials", &m_nMaterials);
+    m_tree->Branch("nX0", &m_nX0Ptr);
+    m_tree->Branch("nLambda", &m_nLambdaPtr);
+    m_tree->Branch("matDepth", &m_matDepthPtr);
+    m_tree->Branch("material", &m_materialPtr);
+    return;
+  }
+
+  // the resumed file has to contain the same range of entries
+  if (shard != nullptr) {
+    TTree* shardTree = m_file->Get<TTree>("shardInfo");
+    ShardInfo info;
+    if (shardTree == nullptr || shardTree->SetBranchAddress("shard", &info.shard) < 0 ||
+        shardTree->SetBranchAddress("nShards", &info.nShards) < 0 ||
+        shardTree->SetBranchAddress("firstEntry", &info.firstEntry) < 0 ||
+        shardTree->SetBranchAddress("endEntry", &info.endEntry) < 0 || shardTree->GetEntry(0) <= 0) {
+      m_tree = nullptr;
+      throw std::runtime_error("File " + fileName + " to resume has no shard information");
+    }
+    shardTree->ResetBranchAddresses();
+    if (info.shard != shard->shard || info.nShards != shard->nShards || info.firstEntry != shard->firstEntry ||
+        info.endEntry != shard->endEntry) {
+      m_tree = nullptr;
+      throw std::runtime_error("File " + fileName + " to resume belongs to a different shard or scan");
+    }
+  }
+  for (size_t iColumn = 0; iColumn < m_columnNames.size(); ++iColumn) {
+    m_tree->SetBranchAddress(m_columnNames[iColumn].c_str(), &m_columnValues[iColumn]);
+  }
+  m_tree->SetBranchAddress("nMaterials", &m_nMaterials);
+  m_tree->SetBranchAddress("nX0", &m_nX0Ptr);
+  m_tree->SetBranchAddress("nLambda", &m_nLambdaPtr);
+  m_tree->SetBranchAddress("matDepth", &m_matDepthPtr);
+  m_tree->SetBranchAddress("material", &m_materialPtr);
+}
+
+size_t MaterialTreeWriter::nEntries() const { return m_tree == nullptr ? 0 : m_tree->GetEntries(); }
+
+void MaterialTreeWriter::fill(const std::vector<const double*>& columns, const MaterialScanEngine::Result& result) {
+  for (size_t iEntry = 0; iEntry < result.size(); ++iEntry) {
+    for (size_t iColumn = 0; iColumn < m_columnValues.size(); ++iColumn) {
+      m_columnValues[iColumn] = columns[iColumn][iEntry];
+    }
+    m_nX0.clear();
+    m_nLambda.clear();
+    m_matDepth.clear();
+    m_material.clear();
+    for (size_t i = result.offsets[iEntry]; i < result.offsets[iEntry + 1]; ++i) {
+      const MaterialScanEngine::MaterialInfo& info = m_materials[result.materialIds[i]];
+      m_material.push_back(info.name);
+      m_matDepth.push_back(result.depths[i]);
+      m_nX0.push_back(result.depths[i] / info.radLength);
+      m_nLambda.push_back(result.depths[i] / info.intLength);
+    }
+    m_nMaterials = m_material.size();
+    m_tree->Fill();
+  }
+}
+
+void MaterialTreeWriter::checkpoint() {
+  // SaveSelf also writes the directory of the file, which is otherwise only written on Close
+  m_tree->AutoSave("SaveSelf");
+}
+
+void MaterialTreeWriter::close() {
+  if (!m_file) {
+    return;
+  }
+  if (m_tree != nullptr) {
+    m_tree->Write("", TObject::kOverwrite);
+  }
+  m_file->Close();
+  m_file.reset();
+  m_tree = nullptr;
+}
+}
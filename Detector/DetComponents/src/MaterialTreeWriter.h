@@ -0,0 +1,92 @@
+#ifndef DETCOMPONENTS_MATERIALTREEWRITER_H
+#define DETCOMPONENTS_MATERIALTREEWRITER_H
+
+#include "MaterialScanEngine.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class TFile;
+class TTree;
+
+namespace det {
+/** @class det::MaterialTreeWriter Detector/DetComponents/src/MaterialTreeWriter.h MaterialTreeWriter.h
+ *
+ *  Writes the materials found by MaterialScanEngine into the TTree "materials", entry by entry
+ *  in the order of the scan. The tree can be filled in several chunks and flushed to the file
+ *  after each of them (checkpoint()), so a killed job leaves a readable file with all entries
+ *  up to the last checkpoint. Such a file can be reopened with resume, the scan then continues
+ *  after the entries already stored.
+ *  Scans split into shards store the range of the entries in the tree "shardInfo", used to
+ *  check the resumed file and to merge the shards (see Detector/DetComponents/scripts/mergeMaterialScans.py).
+ */
+class MaterialTreeWriter {
+public:
+  /// Range of the entries scanned by the job
+  struct ShardInfo {
+    /// Index of the shard
+    unsigned shard = 0;
+    /// Number of shards of the scan
+    unsigned nShards = 1;
+    /// First entry of the shard in the full scan
+    unsigned long long firstEntry = 0;
+    /// Entry following the last entry of the shard in the full scan
+    unsigned long long endEntry = 0;
+  };
+
+  /// Constructor
+  /// @param[in] materials table of the materials indexed by their ID (MaterialScanEngine::materials())
+  /// @param[in] columnNames names of the values stored per entry in front of the materials, e.g. the angles
+  MaterialTreeWriter(const std::vector<MaterialScanEngine::MaterialInfo>& materials,
+                     const std::vector<std::string>& columnNames);
+  /// Destructor, closes the file
+  ~MaterialTreeWriter();
+  MaterialTreeWriter(const MaterialTreeWriter&) = delete;
+  MaterialTreeWriter& operator=(const MaterialTreeWriter&) = delete;
+
+  /// Create the output file
+  /// @param[in] fileName path to the output file
+  /// @param[in] shard range of the entries, stored in the file if given
+  /// @param[in] resume continue the tree found in the file instead of overwriting it
+  /// @throws std::runtime_error if the file can't be written or doesn't belong to the same shard
+  void open(const std::string& fileName, const ShardInfo* shard = nullptr, bool resume = false);
+
+  /// Number of entries in the tree, including the resumed ones
+  size_t nEntries() const;
+
+  /// Append the scanned entries to the tree
+  /// @param[in] columns values of every column, pointing to the value of the first entry of the result
+  /// @param[in] result the scanned materials
+  void fill(const std::vector<const double*>& columns, const MaterialScanEngine::Result& result);
+
+  /// Flush the tree into the file, so that it can be read or resumed if the job is killed
+  void checkpoint();
+
+  /// Write the tree and close the file
+  void close();
+
+private:
+  /// Table of the materials indexed by their ID
+  const std::vector<MaterialScanEngine::MaterialInfo>& m_materials;
+  /// Names of the values stored per entry in front of the materials
+  std::vector<std::string> m_columnNames;
+  /// Output file
+  std::unique_ptr<TFile> m_file;
+  /// Output tree, owned by the file
+  TTree* m_tree = nullptr;
+  /// Branch buffers
+  std::vector<double> m_columnValues;
+  unsigned m_nMaterials = 0;
+  std::vector<double> m_nX0;
+  std::vector<double> m_nLambda;
+  std::vector<double> m_matDepth;
+  std::vector<std::string> m_material;
+  std::vector<double>* m_nX0Ptr = &m_nX0;
+  std::vector<double>* m_nLambdaPtr = &m_nLambda;
+  std::vector<double>* m_matDepthPtr = &m_matDepth;
+  std::vector<std::string>* m_materialPtr = &m_material;
+};
+}
+
+#endif /* DETCOMPONENTS_MATERIALTREEWRITER_H */
@@ -1,4 +1,6 @@
 #include "MergeCells.h"
+#include "CaloHitAccumulator.h"
+#include "ChunkedTransform.h"
 
 #include "GaudiKernel/EventContext.h"
 
@@ -67,8 +69,12 @@ StatusCode MergeCells::initialize() {
             << "(to ensure that middle cell is centred at 0)." << endmsg;
     return StatusCode::FAILURE;
   }
+  m_field = det::CellIDField(*(*itIdentifier).second);
   info() << "Field description: " << m_descriptor.fieldDescription() << endmsg;
   info() << "Merging cells for identifier: " << m_idToMerge << endmsg;
+  if (m_aggregate) {
+    info() << "Hits with the same new cellID are combined into one hit" << endmsg;
+  }
   info() << "Number of adjacent cells to be merged: " << m_numToMerge << "\n" << endmsg;
   return StatusCode::SUCCESS;
 }
@@ -77,44 +83,67 @@ StatusCode MergeCells::execute(const EventContext&) const {
   const auto inHits = m_inHits.get();
   auto outHits = new edm4hep::CalorimeterHitCollection();
 
-  uint field_id = m_descriptor.fieldID(m_idToMerge);
-  auto decoder = m_descriptor.decoder();
-  dd4hep::DDSegmentation::CellID cellId = 0;
-  int value = 0;
+  // with parallel chunks the cellIDs are merged first, the hits are then created in the input order
+  std::vector<CellID> newIds;
+  if (m_chunkSize > 0) {
+    newIds.reserve(inHits->size());
+    for (const auto& hit : *inHits) {
+      newIds.push_back(hit.getCellID());
+    }
+    det::forEachChunk(newIds.size(), m_chunkSize, [&](size_t aFirst, size_t aLast) {
+      for (size_t iHit = aFirst; iHit < aLast; iHit++) {
+        newIds[iHit] = mergedCellID(newIds[iHit]);
+      }
+    });
+  }
+
   uint debugIter = 0;
+  det::CaloHitAccumulator cells;
+  if (m_aggregate) {
+    cells.reserve(inHits->size());
+  }
 
+  size_t iHit = 0;
   for (const auto& hit : *inHits) {
+    const CellID cellId = m_chunkSize > 0 ? newIds[iHit++] : mergedCellID(hit.getCellID());
+    if (debugIter < m_debugPrint) {
+      debug() << "old ID = " << int(m_field.value(hit.getCellID())) << endmsg;
+      debug() << "new ID = " << int(m_field.value(cellId)) << endmsg;
+      debugIter++;
+    }
+    if (m_aggregate) {
+      cells.add(cellId, hit);
+      continue;
+    }
     auto newHit = outHits->create();
     newHit.setEnergy(hit.getEnergy());
     newHit.setEnergyError(hit.getEnergyError());
     newHit.setPosition(hit.getPosition());
     newHit.setType(hit.getType());
     newHit.setTime(hit.getTime());
-    cellId = hit.getCellID();
-    value = (*decoder)[field_id].value(cellId);
-    if (debugIter < m_debugPrint) {
-      debug() << "old ID = " << value << endmsg;
-    }
-    if ((*decoder)[field_id].isSigned()) { //??
-      if (value < 0) {
-        value -= m_numToMerge / 2;
-      } else {
-        value += m_numToMerge / 2;
-      }
-    }
-    value /= int(m_numToMerge);
-    if (debugIter < m_debugPrint) {
-      debug() << "new ID = " << value << endmsg;
-      debugIter++;
-    }
-    //decoder->set(cellId, field_id, value);
-    //newHit.cellId(cellId);
-    (*decoder)[field_id].set(cellId, value);
     newHit.setCellID(cellId);
   }
+  if (m_aggregate) {
+    cells.fill(*outHits);
+    debug() << "Merged " << inHits->size() << " hits into " << cells.size() << " cells" << endmsg;
+  }
   m_outHits.put(outHits);
 
   return StatusCode::SUCCESS;
 }
 
+CellID MergeCells::mergedCellID(CellID aCellId) const {
+  int value = m_field.value(aCellId);
+  if (m_field.isSigned()) {
+    if (value < 0) {
+      value -= m_numToMerge / 2;
+    } else {
+      value += m_numToMerge / 2;
+    }
+  }
+  value /= int(m_numToMerge);
+  m_field.set(aCellId, value);
+  return aCellId;
+}
+
 StatusCode MergeCells::finalize() { return Gaudi::Algorithm::finalize(); }
@@ -10,6 +10,7 @@
 class IGeoSvc;
 
 #include "DD4hep/IDDescriptor.h"
+#include "CellIDFields.h"
 
 // datamodel
 namespace edm4hep {
@@ -26,7 +27,12 @@ class CalorimeterHitCollection;
  *  If the identifier describes an unsigned field, the number of cells to be merged can be any number.
  *  If the identifier describes a signed field, however, the number of cells to be merged need to be an odd number (to
  * keep the centre of the central bin in 0).
- *  For an example see Detector/DetComponents/tests/options/mergeCells.py
+ *  If property '\b aggregate' is set, the hits that end up with the same cellID are combined into one hit (see
+ *  det::CaloHitAccumulator): the energy is summed, position and time are averaged with the energy as weight.
+ *  If property '\b parallelChunkSize' is set, the cellIDs are transformed in chunks of that many hits in parallel (TBB),
+ *  the output keeps the order of the input hits.
+ *  For an example see Detector/DetComponents/tests/options/mergeCells.py, with aggregation
+ *  Detector/DetComponents/tests/options/transformCellIDs.py
  *
  *  @author Anna Zaborowska
  */
@@ -50,6 +56,11 @@ public:
   virtual StatusCode finalize() final;
 
 private:
+  /**  Merge the cells of the field.
+   *   @param[in] aCellId ID of the cell.
+   *   @return ID of the merged cell.
+   */
+  dd4hep::DDSegmentation::CellID mergedCellID(dd4hep::DDSegmentation::CellID aCellId) const;
   /// Pointer to the geometry service
   ServiceHandle<IGeoSvc> m_geoSvc;
   /// Handle for the EDM Hits to be read
@@ -60,10 +71,18 @@ private:
   dd4hep::IDDescriptor m_descriptor;
   /// Name of the detector readout
   Gaudi::Property<std::string> m_readoutName{this, "readout", "", "Name of the detector readout"};
+  /// Field to be merged, resolved from the decoder at initialize
+  det::CellIDField m_field;
   /// Identifier to be merged
   Gaudi::Property<std::string> m_idToMerge{this, "identifier", "", "Identifier to be merged"};
   /// Number of adjacent cells to be merged
   Gaudi::Property<uint> m_numToMerge{this, "merge", 0, "Number of adjacent cells to be merged"};
+  /// Combine the hits with the same new cellID into one hit
+  Gaudi::Property<bool> m_aggregate{this, "aggregate", false,
+                                    "Combine hits with the same new cellID, summing their energy"};
+  /// Number of hits per chunk transformed in parallel
+  Gaudi::Property<unsigned> m_chunkSize{this, "parallelChunkSize", 0,
+                                        "Number of hits per chunk transformed in parallel, 0 for a serial loop"};
   /// Limit of debug printing
   Gaudi::Property<uint> m_debugPrint{this, "debugPrint", 10, "Limit of debug printing"};
 };
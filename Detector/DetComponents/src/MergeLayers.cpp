@@ -1,4 +1,6 @@
 #include "MergeLayers.h"
+#include "CaloHitAccumulator.h"
+#include "ChunkedTransform.h"
 
 // FCCSW
 #include "k4Interface/IGeoSvc.h"
@@ -15,6 +17,8 @@
 // STL
 #include <numeric>
 
+using dd4hep::DDSegmentation::CellID;
+
 DECLARE_COMPONENT(MergeLayers)
 
 MergeLayers::MergeLayers(const std::string& aName, ISvcLocator* aSvcLoc) : Gaudi::Algorithm(aName, aSvcLoc), m_geoSvc("GeoSvc", aName) {
@@ -54,9 +58,20 @@ StatusCode MergeLayers::initialize() {
             << endmsg;
     return StatusCode::FAILURE;
   }
+  m_field = det::CellIDField(*(*itIdentifier).second);
+  // rewriting list of cell sizes to list of top boundaries to facilitate the loop over hits
+  m_listToMergeBoundary.resize(m_listToMerge.size());
+  unsigned int sumCells = 0;
+  for (unsigned int i = 0; i < m_listToMerge.size(); i++) {
+    sumCells += m_listToMerge[i];
+    m_listToMergeBoundary[i] = sumCells;
+  }
   info() << "Field description: " << m_descriptor.fieldDescription() << endmsg;
   info() << "Merging volumes named: " << m_volumeName << endmsg;
   info() << "Merging volumes for identifier: " << m_idToMerge << endmsg;
+  if (m_aggregate) {
+    info() << "Hits with the same new cellID are combined into one hit" << endmsg;
+  }
   info() << "List of number of volumes to be merged: " << m_listToMerge << "\n" << endmsg;
   return StatusCode::SUCCESS;
 }
@@ -65,48 +80,64 @@ StatusCode MergeLayers::execute(const EventContext&) const {
   const auto inHits = m_inHits.get();
   auto outHits = new edm4hep::CalorimeterHitCollection();
 
-  // rewriting list of cell sizes to list of top boundaries to facilitate the loop over hits
-  std::vector<unsigned int> listToMergeBoundary(m_listToMerge.size());
-  unsigned int sumCells = 0;
-  for (unsigned int i = 0; i < m_listToMerge.size(); i++) {
-    sumCells += m_listToMerge[i];
-    listToMergeBoundary[i] = sumCells;
+  // with parallel chunks the cellIDs are merged first, the hits are then created in the input order
+  std::vector<CellID> newIds;
+  if (m_chunkSize > 0) {
+    newIds.reserve(inHits->size());
+    for (const auto& hit : *inHits) {
+      newIds.push_back(hit.getCellID());
+    }
+    det::forEachChunk(newIds.size(), m_chunkSize, [&](size_t aFirst, size_t aLast) {
+      for (size_t iHit = aFirst; iHit < aLast; iHit++) {
+        newIds[iHit] = mergedCellID(newIds[iHit]);
+      }
+    });
   }
 
-  unsigned int field_id = m_descriptor.fieldID(m_idToMerge);
-  auto decoder = m_descriptor.decoder();
-  dd4hep::DDSegmentation::CellID cellId = 0;
-  unsigned int value = 0;
-  unsigned int debugIter = 0;
+  uint debugIter = 0;
+  det::CaloHitAccumulator cells;
+  if (m_aggregate) {
+    cells.reserve(inHits->size());
+  }
 
+  size_t iHit = 0;
   for (const auto& hit : *inHits) {
+    const CellID cellId = m_chunkSize > 0 ? newIds[iHit++] : mergedCellID(hit.getCellID());
+    if (debugIter < m_debugPrint) {
+      debug() << "old ID = " << unsigned(m_field.value(hit.getCellID())) << endmsg;
+      debug() << "new ID = " << unsigned(m_field.value(cellId)) << endmsg;
+      debugIter++;
+    }
+    if (m_aggregate) {
+      cells.add(cellId, hit);
+      continue;
+    }
     auto newHit = outHits->create();
     newHit.setEnergy(hit.getEnergy());
     newHit.setEnergyError(hit.getEnergyError());
     newHit.setPosition(hit.getPosition());
     newHit.setType(hit.getType());
     newHit.setTime(hit.getTime());
-    cellId = hit.getCellID();
-    value = decoder->get(cellId, field_id);
-    if (debugIter < m_debugPrint) {
-      debug() << "old ID = " << value << endmsg;
-    }
-    for (unsigned int i = 0; i < listToMergeBoundary.size(); i++) {
-      if (value < listToMergeBoundary[i]) {
-        value = i;
-        break;
-      }
-    }
-    if (debugIter < m_debugPrint) {
-      debug() << "new ID = " << value << endmsg;
-      debugIter++;
-    }
-    decoder->set(cellId, field_id, value);
     newHit.setCellID(cellId);
   }
+  if (m_aggregate) {
+    cells.fill(*outHits);
+    debug() << "Merged " << inHits->size() << " hits into " << cells.size() << " cells" << endmsg;
+  }
   m_outHits.put(outHits);
 
   return StatusCode::SUCCESS;
 }
 
+CellID MergeLayers::mergedCellID(CellID aCellId) const {
+  const unsigned int value = m_field.value(aCellId);
+  for (unsigned int i = 0; i < m_listToMergeBoundary.size(); i++) {
+    if (value < m_listToMergeBoundary[i]) {
+      m_field.set(aCellId, i);
+      break;
+    }
+  }
+  return aCellId;
+}
+
 StatusCode MergeLayers::finalize() { return Gaudi::Algorithm::finalize(); }
@@ -9,6 +9,7 @@
 class IGeoSvc;
 
 #include "DD4hep/IDDescriptor.h"
+#include "CellIDFields.h"
 
 // datamodel
 namespace edm4hep {
@@ -29,6 +30,10 @@ class CalorimeterHitCollection;
  *  and finally last 2 layers are merged into last cell (id=2).
  *  The sum of all sizes from the list should correspond to the total number of volumes named as indicated in '\b
  * volumeName'.
+ *  If property '\b aggregate' is set, the hits that end up with the same cellID are combined into one hit (see
+ *  det::CaloHitAccumulator): the energy is summed, position and time are averaged with the energy as weight.
+ *  If property '\b parallelChunkSize' is set, the cellIDs are transformed in chunks of that many hits in parallel (TBB),
+ *  the output keeps the order of the input hits.
  *  For an example see Detector/DetComponents/tests/options/mergeLayers.py
  *
  *  @author Anna Zaborowska
@@ -53,6 +58,11 @@ public:
   virtual StatusCode finalize() final;
 
 private:
+  /**  Merge the volumes of the field.
+   *   @param[in] aCellId ID of the cell.
+   *   @return ID of the cell in the merged volume.
+   */
+  dd4hep::DDSegmentation::CellID mergedCellID(dd4hep::DDSegmentation::CellID aCellId) const;
   /// Pointer to the geometry service
   ServiceHandle<IGeoSvc> m_geoSvc;
   /// Handle for the EDM Hits to be read
@@ -63,6 +73,10 @@ private:
   dd4hep::IDDescriptor m_descriptor;
   /// Name of the detector readout
   Gaudi::Property<std::string> m_readoutName{this, "readout", "", "Name of the detector readout"};
+  /// Field to be merged, resolved from the decoder at initialize
+  det::CellIDField m_field;
+  /// Top boundaries of the merged volumes, computed from the list of numbers of volumes to be merged
+  std::vector<unsigned int> m_listToMergeBoundary;
   /// Identifier to be merged
   Gaudi::Property<std::string> m_idToMerge{this, "identifier", "", "Identifier to be merged"};
   /// Name (or its part) of the volume
@@ -70,6 +84,12 @@ private:
   /// List with number of adjacent cells to be merged
   Gaudi::Property<std::vector<uint>> m_listToMerge{
       this, "merge", {}, "List with number of adjacent cells to be merged"};
+  /// Combine the hits with the same new cellID into one hit
+  Gaudi::Property<bool> m_aggregate{this, "aggregate", false,
+                                    "Combine hits with the same new cellID, summing their energy"};
+  /// Number of hits per chunk transformed in parallel
+  Gaudi::Property<unsigned> m_chunkSize{this, "parallelChunkSize", 0,
+                                        "Number of hits per chunk transformed in parallel, 0 for a serial loop"};
   /// Maximum number of lines in debug output
   Gaudi::Property<uint> m_debugPrint{this, "debugPrint", 10, "Maximum number of lines in debug output"};
 };
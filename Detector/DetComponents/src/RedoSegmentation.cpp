@@ -1,8 +1,13 @@
 #include "RedoSegmentation.h"
+#include "ChunkedTransform.h"
 
 // DD4hep
 #include "DD4hep/Detector.h"
 
+// STL
+#include <stdexcept>
+#include <unordered_map>
+
 DECLARE_COMPONENT(RedoSegmentation)
 
 RedoSegmentation::RedoSegmentation(const std::string& aName, ISvcLocator* aSvcLoc) : Gaudi::Algorithm(aName, aSvcLoc), m_geoSvc("GeoSvc", aName) {
@@ -63,16 +68,23 @@ StatusCode RedoSegmentation::initialize() {
   info() << "Old bitfield:\t" << m_oldDecoder->fieldDescription() << endmsg;
   info() << "New bitfield:\t" << m_segmentation->decoder()->fieldDescription() << endmsg;
   info() << "New segmentation is of type:\t" << m_segmentation->type() << endmsg;
-  if (m_segmentation->type() == "FCCSWGridModuleThetaMerged")
-    m_segmentationType=2;
-  else
-    m_segmentationType=0;
   m_oldSegmentation = m_geoSvc->getDetector()->readout(m_oldReadoutName).segmentation().segmentation();
   info() << "Old segmentation is of type:\t" << m_oldSegmentation->type() << endmsg;
-  if (m_oldSegmentation->type() == "FCCSWGridModuleThetaMerged")
-    m_oldSegmentationType=2;
-  else
-    m_oldSegmentationType=0;
+
+  // resolve the fields once, the loop over hits only does bit arithmetic
+  try {
+    m_resegmentation = det::Resegmentation(*m_oldSegmentation, *m_segmentation, m_oldIdentifiers);
+  } catch (const std::runtime_error& e) {
+    error() << "Unable to resolve the bitfield: " << e.what() << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  // with the position from the old cellID, the new cellID is a function of the old cellID
+  m_useCache = m_cacheSize > 0 && m_resegmentation.positionFromCellID();
+  if (m_useCache) {
+    m_cache = det::CellIDCache(m_cacheSize);
+    info() << "New cellIDs are cached for up to " << m_cacheSize << " old cellIDs" << endmsg;
+  }
 
   m_outHitsCellIDEncoding.put(m_segmentation->decoder()->fieldDescription());
 
@@ -82,70 +94,88 @@ StatusCode RedoSegmentation::initialize() {
 StatusCode RedoSegmentation::execute(const EventContext&) const {
   const auto inHits = m_inHits.get();
   auto outHits = m_outHits.createAndPut();
-  // loop over positioned hits to get the energy deposits: position and cellID
   // cellID contains the volumeID that needs to be copied to the new id
-  dd4hep::DDSegmentation::CellID oldid = 0;
+  // the new cellIDs are computed for all hits (in parallel chunks if requested), then the hits are created in order
+  std::vector<dd4hep::DDSegmentation::CellID> cellIds;
+  std::vector<dd4hep::DDSegmentation::Vector3D> positions;
+  cellIds.reserve(inHits->size());
+  positions.reserve(inHits->size());
+  for (const auto& hit : *inHits) {
+    cellIds.push_back(hit.getCellID());
+    auto pos = hit.getPosition();
+    // factor 10 to convert mm to cm
+    positions.emplace_back(pos.x / 10., pos.y / 10., pos.z / 10.);
+  }
+  std::vector<dd4hep::DDSegmentation::CellID> newIds(cellIds.size());
+  det::forEachChunk(cellIds.size(), m_chunkSize, [&](size_t aFirst, size_t aLast) {
+    newCellIDs(cellIds.data() + aFirst, positions.data() + aFirst, newIds.data() + aFirst, aLast - aFirst);
+  });
+
+  // loop over positioned hits to get the energy deposits
   uint debugIter = 0;
+  size_t iHit = 0;
   for (const auto& hit : *inHits) {
     auto newHit = outHits->create();
     newHit.setEnergy(hit.getEnergy());
     // SimCalorimeterHit type (needed for createCaloCells which runs after RedoSegmentation) has no time member
     // newHit.setTime(hit.getTime());
-    dd4hep::DDSegmentation::CellID cellId = hit.getCellID();
+    newHit.setCellID(newIds[iHit]);
     if (debugIter < m_debugPrint) {
-      debug() << "OLD: " << m_oldDecoder->valueString(cellId) << endmsg;
-    }
-    dd4hep::DDSegmentation::Vector3D position;
-    if (m_oldSegmentationType == 2) {
-      position = m_oldSegmentation->position(cellId);
+      debug() << "OLD: " << m_oldDecoder->valueString(cellIds[iHit]) << endmsg;
+      debug() << "NEW: " << m_segmentation->decoder()->valueString(newIds[iHit]) << endmsg;
+      debugIter++;
     }
-    else {
-      auto pos = hit.getPosition();
-      // factor 10 to convert mm to cm
-      position = dd4hep::DDSegmentation::Vector3D (pos.x / 10., pos.y / 10., pos.z / 10.);
+    iHit++;
+  }
+
+  return StatusCode::SUCCESS;
+}
+
+void RedoSegmentation::newCellIDs(const dd4hep::DDSegmentation::CellID* aCellIds,
+                                  const dd4hep::DDSegmentation::Vector3D* aPositions,
+                                  dd4hep::DDSegmentation::CellID* aNewIds, size_t aNumHits) const {
+  if (!m_useCache) {
+    for (size_t iHit = 0; iHit < aNumHits; iHit++) {
+      aNewIds[iHit] = m_resegmentation.newCellID(aCellIds[iHit], aPositions[iHit]);
     }
-    // debug
-    debug() << "x = " << position.x() << " y = " << position.y() << " z = " << position.z() << endmsg;
-
-    // first calculate proper segmentation fields
-    // pass volumeID: we need layer / module information
-    // (which is easier/safer to get from cellID than infer from position)
-    dd4hep::DDSegmentation::VolumeID vID = volumeID(cellId);
-    // for module-theta merged segmentation in which we are replacing
-    // initial module number with merged module number, we still want
-    // to pass the initial module number to segmentation->cellID(..)
-    // as part of the volume ID
-    dd4hep::DDSegmentation::CellID newCellId;
-    if (m_segmentationType == 2) {
-      m_segmentation->decoder()->set(vID, "module", m_oldDecoder->get(cellId, "module"));
-      newCellId = m_segmentation->cellID(position, position, vID);
+    return;
+  }
+  // look up all cellIDs at once, compute the missing ones without holding the lock
+  std::vector<char> cached(aNumHits);
+  {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    for (size_t iHit = 0; iHit < aNumHits; iHit++) {
+      cached[iHit] = m_cache.find(aCellIds[iHit], aNewIds[iHit]);
     }
-    else {
-      newCellId = m_segmentation->cellID(position, position, 0);
+  }
+  // cells hit more than once in the chunk are computed once
+  std::unordered_map<dd4hep::DDSegmentation::CellID, dd4hep::DDSegmentation::CellID> computed;
+  for (size_t iHit = 0; iHit < aNumHits; iHit++) {
+    if (cached[iHit]) {
+      continue;
     }
-    // now rewrite all other fields (detector ID)
-    for (const auto& detectorField : m_detectorIdentifiers) {
-      oldid = m_oldDecoder->get(cellId, detectorField);
-      m_segmentation->decoder()->set(newCellId, detectorField, oldid);
+    auto inserted = computed.try_emplace(aCellIds[iHit], 0);
+    if (inserted.second) {
+      inserted.first->second = m_resegmentation.newCellID(aCellIds[iHit], aPositions[iHit]);
     }
-    newHit.setCellID(newCellId);
-    if (debugIter < m_debugPrint) {
-      debug() << "NEW: " << m_segmentation->decoder()->valueString(newCellId) << endmsg;
-      debugIter++;
+    aNewIds[iHit] = inserted.first->second;
+  }
+  if (!computed.empty()) {
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    for (size_t iHit = 0; iHit < aNumHits; iHit++) {
+      if (!cached[iHit]) {
+        m_cache.insert(aCellIds[iHit], aNewIds[iHit]);
+      }
     }
   }
-
-  return StatusCode::SUCCESS;
 }
 
 StatusCode RedoSegmentation::finalize() {
+  if (m_useCache) {
+    const uint64_t lookups = m_cache.hits() + m_cache.misses();
+    info() << "Cache of new cellIDs: " << lookups << " lookups, hit rate "
+           << (lookups > 0 ? 100. * m_cache.hits() / lookups : 0.) << "%, " << m_cache.size() << " cellIDs cached"
+           << endmsg;
+  }
   info() << "RedoSegmentation finalize! " << endmsg;
    return Gaudi::Algorithm::finalize(); }
-
-uint64_t RedoSegmentation::volumeID(uint64_t aCellId) const {
-  dd4hep::DDSegmentation::CellID cID = aCellId;
-  for (const auto& identifier : m_oldIdentifiers) {
-    m_oldDecoder->set(cID, identifier, 0);
-  }
-  return cID;
-}
@@ -13,12 +13,18 @@
 // DD4hep
 #include "DD4hep/Readout.h"
 #include "DD4hep/Segmentations.h"
+#include "CellIDCache.h"
+#include "Resegmentation.h"
 
 // EDM4hep
 #include "edm4hep/CalorimeterHitCollection.h"
 #include "edm4hep/SimCalorimeterHitCollection.h"
 #include "edm4hep/Constants.h"
 
+// STL
+#include <mutex>
+#include <vector>
+
 /** @class RedoSegmentation Detector/DetComponents/src/RedoSegmentation.h RedoSegmentation.h
  *
  *  Redo the segmentation after the simulation has ended.
@@ -27,6 +33,15 @@
  *  Cell IDs are rewritten from the old readout (`\b oldReadoutName`) to the new readout (`\b newReadoutName`).
  *  Names of the old segmentation fields need to be passed as a vector '\b oldSegmentationIds'.
  *  Those fields are replaced by the new segmentation.
+ *  If the old segmentation is FCCSWGridModuleThetaMerged, the position is taken from the old cellID, so the new
+ *  cellID depends only on the old one. The new cellIDs are then kept in a least recently used cache of
+ *  '\b cacheSize' entries (0 disables it), shared by all events. Its hit rate is printed in finalize.
+ *  The new cellIDs are computed by det::Resegmentation with local cellID arithmetic only, so the hits can be
+ *  transformed from several threads at once. The algorithm itself is not reentrant, as the k4FWCore data
+ *  handles keep the collection of the current event.
+ *  If property '\b parallelChunkSize' is set, the cellIDs of an event are computed in chunks of that many hits in
+ *  parallel (TBB), the output keeps the order of the input hits. The cache is then consulted once
+ *  per chunk and cells hit more than once within a chunk are computed once.
  *
  *  For an example see Detector/DetComponents/tests/options/redoSegmentationXYZ.py
  *  and Detector/DetComponents/tests/options/redoSegmentationRPhi.py.
@@ -52,11 +67,14 @@ public:
   virtual StatusCode finalize() final;
 
 private:
-  /**  Get ID of the volume that contains the cell.
-   *   @param[in] aCellId ID of the cell.
-   *   @return ID of the volume.
+  /**  Compute the IDs of the cells in the new segmentation, using the cache if enabled.
+   *   @param[in] aCellIds IDs of the cells in the old segmentation.
+   *   @param[in] aPositions true positions of the hits (in cm).
+   *   @param[out] aNewIds IDs of the cells in the new segmentation.
+   *   @param[in] aNumHits number of hits.
    */
-  uint64_t volumeID(uint64_t aCellId) const;
+  void newCellIDs(const dd4hep::DDSegmentation::CellID* aCellIds, const dd4hep::DDSegmentation::Vector3D* aPositions,
+                  dd4hep::DDSegmentation::CellID* aNewIds, size_t aNumHits) const;
   /// Pointer to the geometry service
   ServiceHandle<IGeoSvc> m_geoSvc;
   /// Handle for the EDM positioned hits to be read
@@ -70,13 +88,11 @@ private:
       m_outHits, edm4hep::labels::CellIDEncoding, Gaudi::DataHandle::Writer};
   /// New segmentation
   dd4hep::DDSegmentation::Segmentation* m_segmentation;
-  int m_segmentationType; // use enum instead? defined in some namespace?
   /// Name of the detector readout used in simulation
   Gaudi::Property<std::string> m_oldReadoutName{this, "oldReadoutName", "",
                                                 "Name of the detector readout used in simulation"};
   /// Old segmentation
   dd4hep::DDSegmentation::Segmentation* m_oldSegmentation;
-  int m_oldSegmentationType; // use enum instead? defined in some namespace?
   /// Name of the new detector readout
   Gaudi::Property<std::string> m_newReadoutName{this, "newReadoutName", "", "Name of the new detector readout"};
   /// Old bitfield decoder
@@ -86,6 +102,20 @@ private:
       this, "oldSegmentationIds", {}, "Segmentation fields that are going to be replaced by the new segmentation"};
   /// Detector fields that are going to be rewritten
   std::vector<std::string> m_detectorIdentifiers;
+  /// Computation of the new cellIDs, resolved at initialize
+  det::Resegmentation m_resegmentation;
+  /// Maximum number of cellIDs in the cache of the new cellIDs
+  Gaudi::Property<unsigned> m_cacheSize{this, "cacheSize", 100000,
+                                        "Maximum number of new cellIDs cached for the old cellIDs, 0 to disable"};
+  /// Whether the new cellIDs are cached (only if they depend on the old cellID alone)
+  bool m_useCache = false;
+  /// Cache of the new cellIDs for the old cellIDs
+  mutable det::CellIDCache m_cache;
+  /// Protection of the cache against the chunks transformed in parallel
+  mutable std::mutex m_cacheMutex;
+  /// Number of hits per chunk transformed in parallel
+  Gaudi::Property<unsigned> m_chunkSize{this, "parallelChunkSize", 0,
+                                        "Number of hits per chunk transformed in parallel, 0 for a serial loop"};
   /// Limit of debug printing
   Gaudi::Property<uint> m_debugPrint{this, "debugPrint", 10, "Limit of debug printing"};
 };
@@ -0,0 +1,56 @@
+#include "Resegmentation.h"
+
+// STL
+#include <algorithm>
+
+namespace det {
+Resegmentation::Resegmentation(const dd4hep::DDSegmentation::Segmentation& aOldSegmentation,
+                               const dd4hep::DDSegmentation::Segmentation& aNewSegmentation,
+                               const std::vector<std::string>& aOldSegmentationIds)
+    : m_oldSegmentation(&aOldSegmentation),
+      m_segmentation(&aNewSegmentation),
+      m_oldModuleThetaMerged(aOldSegmentation.type() == "FCCSWGridModuleThetaMerged"),
+      m_moduleThetaMerged(aNewSegmentation.type() == "FCCSWGridModuleThetaMerged") {
+  const auto& oldDecoder = *aOldSegmentation.decoder();
+  const auto& newDecoder = *aNewSegmentation.decoder();
+  // detector identifiers = all bitfield ids - segmentation ids
+  std::vector<std::string> detectorIdentifiers;
+  for (size_t itField = 0; itField < oldDecoder.size(); itField++) {
+    const std::string& field = oldDecoder[itField].name();
+    if (std::find(aOldSegmentationIds.begin(), aOldSegmentationIds.end(), field) == aOldSegmentationIds.end()) {
+      detectorIdentifiers.push_back(field);
+    }
+  }
+  m_detectorFields = resolveFieldCopies(oldDecoder, newDecoder, detectorIdentifiers);
+  for (const auto& identifier : aOldSegmentationIds) {
+    m_oldSegmentationMask |= CellIDField(oldDecoder, identifier).mask();
+  }
+  if (m_moduleThetaMerged) {
+    m_moduleField = resolveFieldCopies(oldDecoder, newDecoder, {"module"}).front();
+  }
+}
+
+Resegmentation::CellID Resegmentation::newCellID(CellID aCellId,
+                                                 const dd4hep::DDSegmentation::Vector3D& aPosition) const {
+  const dd4hep::DDSegmentation::Vector3D position =
+      m_oldModuleThetaMerged ? m_oldSegmentation->position(aCellId) : aPosition;
+  // first calculate proper segmentation fields
+  // pass volumeID: we need layer / module information
+  // (which is easier/safer to get from cellID than infer from position)
+  CellID newCellId = 0;
+  if (m_moduleThetaMerged) {
+    // for module-theta merged segmentation in which we are replacing
+    // initial module number with merged module number, we still want
+    // to pass the initial module number to segmentation->cellID(..)
+    // as part of the volume ID
+    dd4hep::DDSegmentation::VolumeID vID = volumeID(aCellId);
+    m_moduleField.second.set(vID, m_moduleField.first.value(aCellId));
+    newCellId = m_segmentation->cellID(position, position, vID);
+  } else {
+    newCellId = m_segmentation->cellID(position, position, 0);
+  }
+  // now rewrite all other fields (detector ID)
+  copyFields(m_detectorFields, aCellId, newCellId);
+  return newCellId;
+}
+}
@@ -0,0 +1,70 @@
+#ifndef DETCOMPONENTS_RESEGMENTATION_H
+#define DETCOMPONENTS_RESEGMENTATION_H
+
+// DD4hep
+#include "DDSegmentation/Segmentation.h"
+
+#include "CellIDFields.h"
+
+// STL
+#include <string>
+#include <vector>
+
+namespace det {
+/** @class det::Resegmentation Detector/DetComponents/src/Resegmentation.h Resegmentation.h
+ *
+ *  Computation of the cellID in a new segmentation from the cellID in the old segmentation, as done by
+ *  RedoSegmentation. The fields are resolved in the constructor; newCellID() only does arithmetic on local
+ *  cellIDs and calls const methods of the segmentations, so it can be called from several threads at once.
+ */
+class Resegmentation {
+public:
+  using CellID = dd4hep::DDSegmentation::CellID;
+
+  Resegmentation() = default;
+  /**  Constructor.
+   *   @param[in] aOldSegmentation segmentation used in simulation.
+   *   @param[in] aNewSegmentation new segmentation.
+   *   @param[in] aOldSegmentationIds fields of the old segmentation, replaced by the new segmentation.
+   *   @throws std::runtime_error if a detector field of the old bitfield is missing in the new one.
+   */
+  Resegmentation(const dd4hep::DDSegmentation::Segmentation& aOldSegmentation,
+                 const dd4hep::DDSegmentation::Segmentation& aNewSegmentation,
+                 const std::vector<std::string>& aOldSegmentationIds);
+
+  /**  Get ID of the volume that contains the cell.
+   *   @param[in] aCellId ID of the cell.
+   *   @return ID of the volume.
+   */
+  CellID volumeID(CellID aCellId) const {
+    // same as setting all old segmentation fields to 0
+    return aCellId & ~m_oldSegmentationMask;
+  }
+  /**  Compute the ID of the cell in the new segmentation.
+   *   @param[in] aCellId ID of the cell in the old segmentation.
+   *   @param[in] aPosition true position of the hit (in cm), ignored if positionFromCellID().
+   *   @return ID of the cell in the new segmentation.
+   */
+  CellID newCellID(CellID aCellId, const dd4hep::DDSegmentation::Vector3D& aPosition) const;
+  /// Whether the position is taken from the old cellID (module-theta merged segmentation), not from the hit
+  bool positionFromCellID() const { return m_oldModuleThetaMerged; }
+
+private:
+  /// Old segmentation
+  const dd4hep::DDSegmentation::Segmentation* m_oldSegmentation = nullptr;
+  /// New segmentation
+  const dd4hep::DDSegmentation::Segmentation* m_segmentation = nullptr;
+  /// Whether the old segmentation is FCCSWGridModuleThetaMerged
+  bool m_oldModuleThetaMerged = false;
+  /// Whether the new segmentation is FCCSWGridModuleThetaMerged
+  bool m_moduleThetaMerged = false;
+  /// Detector fields in the old and the new bitfield
+  std::vector<CellIDFieldCopy> m_detectorFields;
+  /// Bits of the old segmentation fields, cleared to get the volume ID
+  CellID m_oldSegmentationMask = 0;
+  /// Module field in the old and the new bitfield (for module-theta merged segmentation)
+  CellIDFieldCopy m_moduleField;
+};
+}
+
+#endif /* DETCOMPONENTS_RESEGMENTATION_H */
@@ -1,4 +1,5 @@
 #include "RewriteBitfield.h"
+#include "ChunkedTransform.h"
 
 // FCCSW
 #include "k4Interface/IGeoSvc.h"
@@ -64,9 +65,12 @@ StatusCode RewriteBitfield::initialize() {
       return StatusCode::FAILURE;
     }
   }
+  m_remap = det::CellIDRemap(det::resolveFieldCopies(*m_oldDecoder, *m_newDecoder, m_detectorIdentifiers));
   info() << "Rewritting the readout bitfield." << endmsg;
   info() << "Old bitfield:\t" << m_oldDecoder->fieldDescription() << endmsg;
   info() << "New bitfield:\t" << m_newDecoder->fieldDescription() << endmsg;
+  info() << "Detector fields copied by " << m_remap.numMoves() << " bit moves and " << m_remap.numConversions()
+         << " conversions" << endmsg;
 
   return StatusCode::SUCCESS;
 }
@@ -74,29 +78,31 @@ StatusCode RewriteBitfield::initialize() {
 StatusCode RewriteBitfield::execute(const EventContext&) const {
   const auto inHits = m_inHits.get();
   auto outHits = m_outHits.createAndPut();
-  // loop over positioned hits to get the energy deposits: position and cellID
   // cellID contains the volumeID that needs to be copied to the new id
-  uint64_t oldid = 0;
+  // all cellIDs are remapped at once (or in parallel chunks) in place, rewriting all fields except for those to be
+  // removed
+  std::vector<dd4hep::DDSegmentation::CellID> newIds;
+  newIds.reserve(inHits->size());
+  for (const auto& hit : *inHits) {
+    newIds.push_back(hit.getCellID());
+  }
+  det::forEachChunk(newIds.size(), m_chunkSize, [&](size_t aFirst, size_t aLast) {
+    m_remap.apply(newIds.data() + aFirst, newIds.data() + aFirst, aLast - aFirst);
+  });
+
   uint debugIter = 0;
+  size_t iHit = 0;
   for (const auto& hit : *inHits) {
     auto newHit = outHits->create();
     newHit.setEnergy(hit.getEnergy());
     newHit.setTime(hit.getTime());
-    dd4hep::DDSegmentation::CellID cID = hit.getCellID();
-    if (debugIter < m_debugPrint) {
-      debug() << "OLD: " << m_oldDecoder->valueString(cID) << endmsg;
-    }
-    // now rewrite all fields except for those to be removed
-    dd4hep::DDSegmentation::CellID newID=0;
-    for (const auto& detectorField : m_detectorIdentifiers) {
-      oldid = m_oldDecoder->get(cID, detectorField);
-      m_newDecoder->set(newID, detectorField, oldid);
-    }
-    newHit.setCellID(newID);
+    newHit.setCellID(newIds[iHit]);
     if (debugIter < m_debugPrint) {
-      debug() << "NEW: " << m_newDecoder->valueString(newID) << endmsg;
+      debug() << "OLD: " << m_oldDecoder->valueString(hit.getCellID()) << endmsg;
+      debug() << "NEW: " << m_newDecoder->valueString(newIds[iHit]) << endmsg;
       debugIter++;
     }
+    iHit++;
   }
   return StatusCode::SUCCESS;
 }
@@ -17,6 +17,8 @@ class Segmentation;
 }
 }
 
+#include "CellIDFields.h"
+
 // datamodel
 namespace edm4hep {
 class CalorimeterHitCollection;
@@ -30,6 +32,10 @@ class CalorimeterHitCollection;
  *  New readout bitfield has to be added to <readouts> tag in the detector description xml.
  *  Cell IDs are rewritten from the old readout (`\b oldReadoutName`) to the new readout (`\b newReadoutName`).
  *  Names of the fields to be removed (for verification) are passed as a vector '\b removeIds'.
+ *  The copy of the detector fields is compiled at initialize into a few bit operations
+ *  (det::CellIDRemap), applied to the cellIDs of all hits at once before the output hits are created.
+ *  If property '\b parallelChunkSize' is set, the cellIDs are remapped in chunks of that many hits in parallel (TBB),
+ *  the output keeps the order of the input hits.
  *
  *  For an example see Detector/DetComponents/tests/options/rewriteBitfield.py
  *
@@ -74,6 +80,11 @@ private:
       this, "removeIds", {}, "Segmentation fields that are going to be removed"};
   /// Detector fields that are going to be rewritten ( = old field - to be removed)
   std::vector<std::string> m_detectorIdentifiers;
+  /// Copy of the detector fields into the new bitfield, compiled at initialize
+  det::CellIDRemap m_remap;
+  /// Number of hits per chunk transformed in parallel
+  Gaudi::Property<unsigned> m_chunkSize{this, "parallelChunkSize", 0,
+                                        "Number of hits per chunk transformed in parallel, 0 for a serial loop"};
   /// Limit of debug printing
   Gaudi::Property<uint> m_debugPrint{this, "debugPrint", 10, "Limit of debug printing"};
 };
@@ -0,0 +1,182 @@
+#include "TransformCellIDs.h"
+#include "CaloHitAccumulator.h"
+
+// FCCSW
+#include "k4Interface/IGeoSvc.h"
+
+// datamodel
+#include "edm4hep/CalorimeterHitCollection.h"
+
+// DD4hep
+#include "DD4hep/Detector.h"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+DECLARE_COMPONENT(TransformCellIDs)
+
+namespace {
+std::vector<std::string> split(const std::string& aText, char aDelimiter) {
+  std::vector<std::string> parts;
+  std::stringstream stream(aText);
+  std::string part;
+  while (std::getline(stream, part, aDelimiter)) {
+    parts.push_back(part);
+  }
+  return parts;
+}
+}
+
+TransformCellIDs::TransformCellIDs(const std::string& aName, ISvcLocator* aSvcLoc)
+    : Gaudi::Algorithm(aName, aSvcLoc), m_geoSvc("GeoSvc", aName) {
+  declareProperty("inhits", m_inHits, "Hit collection to transform (input)");
+  declareProperty("outhits", m_outHits, "Merged hit collection (output)");
+}
+
+TransformCellIDs::~TransformCellIDs() {}
+
+StatusCode TransformCellIDs::initialize() {
+  if (Gaudi::Algorithm::initialize().isFailure()) return StatusCode::FAILURE;
+
+  if (!m_geoSvc) {
+    error() << "Unable to locate Geometry Service. "
+            << "Make sure you have GeoSvc and SimSvc in the right order in the configuration." << endmsg;
+    return StatusCode::FAILURE;
+  }
+  // check if readout exists
+  if (m_geoSvc->getDetector()->readouts().find(m_readoutName) == m_geoSvc->getDetector()->readouts().end()) {
+    error() << "Readout <<" << m_readoutName << ">> does not exist." << endmsg;
+    return StatusCode::FAILURE;
+  }
+  const dd4hep::DDSegmentation::BitFieldCoder* decoder =
+      m_geoSvc->getDetector()->readout(m_readoutName).idSpec().decoder();
+  info() << "Input bitfield:\t" << decoder->fieldDescription() << endmsg;
+  for (const auto& description : m_transforms) {
+    if (addStep(description, decoder).isFailure()) {
+      return StatusCode::FAILURE;
+    }
+    info() << "Transformation: " << description << endmsg;
+  }
+  m_outDecoder = decoder;
+  info() << "Output bitfield:\t" << m_outDecoder->fieldDescription() << endmsg;
+  m_outHitsCellIDEncoding.put(m_outDecoder->fieldDescription());
+  return StatusCode::SUCCESS;
+}
+
+StatusCode TransformCellIDs::addStep(const std::string& aDescription,
+                                     const dd4hep::DDSegmentation::BitFieldCoder*& aDecoder) {
+  const std::vector<std::string> parts = split(aDescription, ':');
+  if (parts.size() < 2 || parts.size() > 3 || (parts[0] != "RewriteBitfield" && parts.size() != 3)) {
+    error() << "Transformation <<" << aDescription << ">> is not of the form <type>:<name>:<parameters>" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  Step step;
+  try {
+    if (parts[0] == "MergeCells") {
+      step.type = Step::Type::MergeCells;
+      step.field = det::CellIDField(*aDecoder, parts[1]);
+      step.numToMerge = std::stoi(parts[2]);
+      // same conditions as in MergeCells
+      if (step.numToMerge < 2 || step.numToMerge > std::pow(2, step.field.width())) {
+        error() << "Number of cells to be merged in <<" << aDescription << ">> must be larger than 1 "
+                << "and not exceed the number of cells." << endmsg;
+        return StatusCode::FAILURE;
+      }
+      if (step.field.isSigned() && step.numToMerge % 2 == 0) {
+        error() << "If field is signed, merge can only be done for an odd number of cells: " << aDescription << endmsg;
+        return StatusCode::FAILURE;
+      }
+    } else if (parts[0] == "MergeLayers") {
+      step.type = Step::Type::MergeLayers;
+      step.field = det::CellIDField(*aDecoder, parts[1]);
+      unsigned int sumCells = 0;
+      for (const auto& number : split(parts[2], ',')) {
+        sumCells += std::stoul(number);
+        step.boundaries.push_back(sumCells);
+      }
+    } else if (parts[0] == "RewriteBitfield") {
+      step.type = Step::Type::RewriteBitfield;
+      if (m_geoSvc->getDetector()->readouts().find(parts[1]) == m_geoSvc->getDetector()->readouts().end()) {
+        error() << "Readout <<" << parts[1] << ">> does not exist." << endmsg;
+        return StatusCode::FAILURE;
+      }
+      const std::vector<std::string> removeIds = parts.size() == 3 ? split(parts[2], ',') : std::vector<std::string>();
+      std::vector<std::string> detectorIdentifiers;
+      for (size_t itField = 0; itField < aDecoder->size(); itField++) {
+        const std::string& field = (*aDecoder)[itField].name();
+        if (std::find(removeIds.begin(), removeIds.end(), field) == removeIds.end()) {
+          detectorIdentifiers.push_back(field);
+        }
+      }
+      const dd4hep::DDSegmentation::BitFieldCoder* newDecoder =
+          m_geoSvc->getDetector()->readout(parts[1]).idSpec().decoder();
+      step.remap = det::CellIDRemap(det::resolveFieldCopies(*aDecoder, *newDecoder, detectorIdentifiers));
+      aDecoder = newDecoder;
+    } else {
+      error() << "Unknown transformation <<" << parts[0] << ">>, use MergeCells, MergeLayers or RewriteBitfield"
+              << endmsg;
+      return StatusCode::FAILURE;
+    }
+  } catch (const std::exception& e) {
+    // unknown fields and numbers that can't be parsed
+    error() << "Unable to resolve the transformation <<" << aDescription << ">>: " << e.what() << endmsg;
+    return StatusCode::FAILURE;
+  }
+  m_steps.push_back(std::move(step));
+  return StatusCode::SUCCESS;
+}
+
+dd4hep::DDSegmentation::CellID TransformCellIDs::transform(dd4hep::DDSegmentation::CellID aCellId) const {
+  for (const auto& step : m_steps) {
+    switch (step.type) {
+      case Step::Type::MergeCells: {
+        auto value = step.field.value(aCellId);
+        if (step.field.isSigned()) {
+          value += value < 0 ? -step.numToMerge / 2 : step.numToMerge / 2;
+        }
+        step.field.set(aCellId, value / step.numToMerge);
+        break;
+      }
+      case Step::Type::MergeLayers: {
+        const unsigned int value = step.field.value(aCellId);
+        for (unsigned int i = 0; i < step.boundaries.size(); i++) {
+          if (value < step.boundaries[i]) {
+            step.field.set(aCellId, i);
+            break;
+          }
+        }
+        break;
+      }
+      case Step::Type::RewriteBitfield:
+        aCellId = step.remap.apply(aCellId);
+        break;
+    }
+  }
+  return aCellId;
+}
+
+StatusCode TransformCellIDs::execute(const EventContext&) const {
+  const auto inHits = m_inHits.get();
+  auto outHits = new edm4hep::CalorimeterHitCollection();
+
+  det::CaloHitAccumulator cells;
+  cells.reserve(inHits->size());
+  uint debugIter = 0;
+  for (const auto& hit : *inHits) {
+    const dd4hep::DDSegmentation::CellID cellId = transform(hit.getCellID());
+    if (debugIter < m_debugPrint) {
+      debug() << "old ID = " << hit.getCellID() << " new ID = " << m_outDecoder->valueString(cellId) << endmsg;
+      debugIter++;
+    }
+    cells.add(cellId, hit);
+  }
+  cells.fill(*outHits);
+  debug() << "Merged " << inHits->size() << " hits into " << cells.size() << " cells" << endmsg;
+  m_outHits.put(outHits);
+  return StatusCode::SUCCESS;
+}
+
+StatusCode TransformCellIDs::finalize() { return Gaudi::Algorithm::finalize(); }
@@ -0,0 +1,102 @@
+#ifndef DETCOMPONENTS_TRANSFORMCELLIDS_H
+#define DETCOMPONENTS_TRANSFORMCELLIDS_H
+
+// GAUDI
+#include "Gaudi/Algorithm.h"
+
+// FCCSW
+#include "k4FWCore/DataHandle.h"
+#include "k4FWCore/MetaDataHandle.h"
+class IGeoSvc;
+
+#include "CellIDFields.h"
+
+// datamodel
+#include "edm4hep/Constants.h"
+namespace edm4hep {
+class CalorimeterHitCollection;
+}
+
+/** @class TransformCellIDs Detector/DetComponents/src/TransformCellIDs.h TransformCellIDs.h
+ *
+ *  Apply a sequence of cellID transformations to a collection of hits in one pass, and merge
+ *  the hits that end up in the same cell.
+ *  It replaces a chain of MergeCells, MergeLayers and RewriteBitfield algorithms, without the
+ *  intermediate collections and with one hit per resulting cell: the energy is summed, position
+ *  and time are averaged with the energy as weight (see det::CaloHitAccumulator).
+ *  The hits are described by the readout '\b readout'. The transformations are listed in
+ *  '\b transforms' and applied in the given order, each of them is one of:
+ *    - "MergeCells:<identifier>:<merge>" merge adjacent cells of the field, as MergeCells
+ *    - "MergeLayers:<identifier>:<n1>,<n2>,..." merge adjacent volumes, as MergeLayers
+ *    - "RewriteBitfield:<newReadout>[:<removeId1>,<removeId2>,...]" rewrite the cellID into
+ *      the new readout without the removed fields, as RewriteBitfield. The transformations that
+ *      follow refer to the fields of the new readout.
+ *  The cellID encoding of the output collection is the one of the last readout.
+ *
+ *  For an example see Detector/DetComponents/tests/options/transformCellIDs.py
+ */
+
+class TransformCellIDs : public Gaudi::Algorithm {
+public:
+  explicit TransformCellIDs(const std::string&, ISvcLocator*);
+  virtual ~TransformCellIDs();
+  /**  Initialize.
+   *   @return status code
+   */
+  virtual StatusCode initialize() final;
+  /**  Execute.
+   *   @return status code
+   */
+  virtual StatusCode execute(const EventContext&) const final;
+  /**  Finalize.
+   *   @return status code
+   */
+  virtual StatusCode finalize() final;
+
+private:
+  /// Transformation of the cellID resolved at initialize
+  struct Step {
+    enum class Type { MergeCells, MergeLayers, RewriteBitfield };
+    Type type;
+    /// Field of MergeCells and MergeLayers
+    det::CellIDField field;
+    /// Number of cells merged by MergeCells
+    int numToMerge = 0;
+    /// Top boundaries of the merged volumes of MergeLayers
+    std::vector<unsigned int> boundaries;
+    /// Copy of the fields of RewriteBitfield
+    det::CellIDRemap remap;
+  };
+  /**  Resolve the transformation described by the string.
+   *   @param[in] aDescription transformation, see the class description.
+   *   @param[in, out] aDecoder decoder of the cellIDs, replaced by the one of the new readout by RewriteBitfield.
+   *   @return status code
+   */
+  StatusCode addStep(const std::string& aDescription, const dd4hep::DDSegmentation::BitFieldCoder*& aDecoder);
+  /**  Apply all transformations to the cellID.
+   *   @param[in] aCellId ID of the cell.
+   *   @return transformed ID of the cell.
+   */
+  dd4hep::DDSegmentation::CellID transform(dd4hep::DDSegmentation::CellID aCellId) const;
+
+  /// Pointer to the geometry service
+  ServiceHandle<IGeoSvc> m_geoSvc;
+  /// Handle for the EDM hits to be read
+  mutable DataHandle<edm4hep::CalorimeterHitCollection> m_inHits{"hits/caloInHits", Gaudi::DataHandle::Reader, this};
+  /// Handle for the EDM hits to be written
+  mutable DataHandle<edm4hep::CalorimeterHitCollection> m_outHits{"hits/caloOutHits", Gaudi::DataHandle::Writer, this};
+  /// Handle for the output hits cell id encoding.
+  MetaDataHandle<std::string> m_outHitsCellIDEncoding{m_outHits, edm4hep::labels::CellIDEncoding,
+                                                      Gaudi::DataHandle::Writer};
+  /// Name of the detector readout of the input hits
+  Gaudi::Property<std::string> m_readoutName{this, "readout", "", "Name of the detector readout"};
+  /// Transformations applied in the given order
+  Gaudi::Property<std::vector<std::string>> m_transforms{this, "transforms", {}, "Transformations of the cellID"};
+  /// Limit of debug printing
+  Gaudi::Property<uint> m_debugPrint{this, "debugPrint", 10, "Limit of debug printing"};
+  /// Transformations resolved at initialize
+  std::vector<Step> m_steps;
+  /// Decoder of the output cellIDs
+  const dd4hep::DDSegmentation::BitFieldCoder* m_outDecoder = nullptr;
+};
+#endif /* DETCOMPONENTS_TRANSFORMCELLIDS_H */
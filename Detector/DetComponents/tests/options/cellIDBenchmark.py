@@ -0,0 +1,32 @@
+# Throughput of the cellID transformations of RewriteBitfield and RedoSegmentation on a million hits,
+# with the fields looked up by name for every hit and with the fields resolved at initialize
+# The resegmentation is benchmarked in cellIDBenchmarkModuleThetaMerged.py, sublayer is not a segmentation field
+import os
+from Gaudi.Configuration import INFO
+
+from Configurables import ApplicationMgr
+ApplicationMgr().EvtSel = 'NONE'
+ApplicationMgr().EvtMax = 1
+ApplicationMgr().OutputLevel = INFO
+
+# DD4hep geometry service
+from Configurables import GeoSvc
+geoservice = GeoSvc("GeoSvc")
+path_to_detectors = os.environ.get("FCCDETECTORS", "")
+detectors_to_use = [
+    'Detector/DetFCChhBaseline1/compact/FCChh_DectEmptyMaster.xml',
+    'Detector/DetFCChhCalDiscs/compact/Endcaps_coneCryo.xml',
+]
+geoservice.detectors = [os.path.join(path_to_detectors, det)
+                        for det in detectors_to_use]
+geoservice.OutputLevel = INFO
+ApplicationMgr().ExtSvc += [geoservice]
+
+from Configurables import CellIDBenchmark
+benchmark = CellIDBenchmark("CellIDBenchmark",
+                            oldReadoutName = "EMECPhiEta",
+                            newReadoutName = "EMECPhiEtaReco",
+                            removeIds = ["sublayer"],
+                            nHits = 1000000,
+                            nThreads = 0)
+ApplicationMgr().ExtSvc += [benchmark]
@@ -0,0 +1,35 @@
+# Resegmentation of RedoSegmentation from the module-theta merged readout of the FCC-ee calorimeter barrel
+# into the readout with a different merging, on a million valid cells, run in 4 threads and compared
+# with the serial one
+import os
+from Gaudi.Configuration import INFO
+
+from Configurables import ApplicationMgr
+ApplicationMgr().EvtSel = 'NONE'
+ApplicationMgr().EvtMax = 1
+ApplicationMgr().OutputLevel = INFO
+
+# DD4hep geometry service
+from Configurables import GeoSvc
+geoservice = GeoSvc("GeoSvc")
+path_to_detectors = os.environ.get("FCCDETECTORS", "")
+detectors_to_use = [
+    'Detector/DetFCCeeIDEA-LAr/compact/FCCee_DectEmptyMaster.xml',
+    'Detector/DetFCCeeECalInclined/compact/FCCee_ECalBarrel_thetamodulemerged.xml',
+]
+geoservice.detectors = [os.path.join(path_to_detectors, det)
+                        for det in detectors_to_use]
+geoservice.OutputLevel = INFO
+ApplicationMgr().ExtSvc += [geoservice]
+
+# cells of the 12 layers and 1536 modules of the barrel, within its theta range
+from Configurables import CellIDBenchmark
+benchmark = CellIDBenchmark("CellIDBenchmark",
+                            oldReadoutName = "ECalBarrelModuleThetaMerged",
+                            newReadoutName = "ECalBarrelModuleThetaMerged2",
+                            removeIds = ["module", "theta"],
+                            cellIDRanges = {"system": [4, 4], "cryo": [0, 0], "type": [0, 0], "subtype": [0, 0],
+                                            "layer": [0, 11], "module": [0, 1535], "theta": [0, 799]},
+                            nHits = 1000000,
+                            nThreads = 4)
+ApplicationMgr().ExtSvc += [benchmark]
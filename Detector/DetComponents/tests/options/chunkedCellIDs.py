@@ -0,0 +1,97 @@
+# RewriteBitfield, MergeCells and MergeLayers run twice on the hits of the calorimeter endcap: with the serial loop
+# and with the cellIDs transformed in parallel chunks of 100 hits, the outputs are compared hit by hit
+# by Detector/DetComponents/tests/scripts/compareCellIDs.py
+import os
+from Gaudi.Configuration import *
+
+# DD4hep geometry service
+from Configurables import GeoSvc
+path_to_detectors = os.environ.get("FCCDETECTORS", "")
+detectors_to_use = [
+    'Detector/DetFCChhBaseline1/compact/FCChh_DectEmptyMaster.xml',
+    'Detector/DetFCChhCalDiscs/compact/Endcaps_coneCryo.xml',
+]
+geoservice = GeoSvc("GeoSvc", detectors=[os.path.join(path_to_detectors, det) for det in detectors_to_use],
+                    OutputLevel = INFO)
+
+# Geant4 service
+# Configures the Geant simulation: geometry, physics list and user actions
+from Configurables import SimG4Svc
+geantservice = SimG4Svc("SimG4Svc")
+
+# Geant4 algorithm
+# Translates EDM to G4Event, passes the event to G4, writes out outputs via tools
+# and a tool that saves the calorimeter hits
+# showers of 100 GeV electrons leave thousands of hits, many chunks per event
+from Configurables import SimG4Alg, SimG4SaveCalHits
+savecaltool = SimG4SaveCalHits("saveECalHits", readoutNames = ["EMECPhiEta"])
+savecaltool.positionedCaloHits.Path = "positionedCaloHits"
+savecaltool.caloHits.Path = "caloHits"
+from Configurables import SimG4SingleParticleGeneratorTool
+pgun=SimG4SingleParticleGeneratorTool("SimG4SingleParticleGeneratorTool",saveEdm=True,
+                particleName="e-",energyMin=100000,energyMax=100000,etaMin=2,etaMax=2)
+geantsim = SimG4Alg("SimG4Alg", outputs= ["SimG4SaveCalHits/saveECalHits"], eventProvider=pgun)
+
+chunk_size = 100
+
+from Configurables import RewriteBitfield, MergeCells, MergeLayers
+rewrite = RewriteBitfield("Rewrite",
+                          oldReadoutName = "EMECPhiEta",
+                          removeIds = ["sublayer"],
+                          newReadoutName = "EMECPhiEtaReco")
+rewrite.inhits.Path = "caloHits"
+rewrite.outhits.Path = "caloRecoHits"
+rewriteChunked = RewriteBitfield("RewriteChunked",
+                                 oldReadoutName = "EMECPhiEta",
+                                 removeIds = ["sublayer"],
+                                 newReadoutName = "EMECPhiEtaReco",
+                                 parallelChunkSize = chunk_size)
+rewriteChunked.inhits.Path = "caloHits"
+rewriteChunked.outhits.Path = "caloRecoHitsChunked"
+
+# both merging algorithms read the hits of the serial RewriteBitfield
+merge = MergeCells("Merge",
+                   readout = "EMECPhiEtaReco",
+                   identifier = "phi",
+                   merge = 3)
+merge.inhits.Path = "caloRecoHits"
+merge.outhits.Path = "caloMergedHits"
+mergeChunked = MergeCells("MergeChunked",
+                          readout = "EMECPhiEtaReco",
+                          identifier = "phi",
+                          merge = 3,
+                          parallelChunkSize = chunk_size)
+mergeChunked.inhits.Path = "caloRecoHits"
+mergeChunked.outhits.Path = "caloMergedHitsChunked"
+
+mergeLayers = MergeLayers("MergeLayers",
+                          volumeName = "layer",
+                          identifier = "layer",
+                          readout = "EMECPhiEtaReco",
+                          merge = [2, 4, 4, 8])
+mergeLayers.inhits.Path = "caloRecoHits"
+mergeLayers.outhits.Path = "caloLayerHits"
+mergeLayersChunked = MergeLayers("MergeLayersChunked",
+                                 volumeName = "layer",
+                                 identifier = "layer",
+                                 readout = "EMECPhiEtaReco",
+                                 merge = [2, 4, 4, 8],
+                                 parallelChunkSize = chunk_size)
+mergeLayersChunked.inhits.Path = "caloRecoHits"
+mergeLayersChunked.outhits.Path = "caloLayerHitsChunked"
+
+# PODIO algorithm
+from Configurables import FCCDataSvc, PodioOutput
+podiosvc = FCCDataSvc("EventDataSvc")
+out = PodioOutput("out")
+out.outputCommands = ["keep *"]
+out.filename = "chunkedCellIDs_ecalEndcapSim.root"
+
+# ApplicationMgr
+from Configurables import ApplicationMgr
+ApplicationMgr( TopAlg = [geantsim, rewrite, rewriteChunked, merge, mergeChunked, mergeLayers, mergeLayersChunked, out],
+                EvtSel = 'NONE',
+                EvtMax   = 2,
+                # order is important, as GeoSvc is needed by G4SimSvc
+                ExtSvc = [podiosvc, geoservice, geantservice],
+                OutputLevel=INFO)
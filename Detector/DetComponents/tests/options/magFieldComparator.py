@@ -0,0 +1,42 @@
+from fieldMapUtils import write_regular_map
+
+# Small regular 3D fieldmap
+write_regular_map("testfield3d_comparator.root")
+
+
+from Gaudi.Configuration import INFO
+from GaudiKernel.SystemOfUnits import tesla, m
+
+from Configurables import ApplicationMgr
+ApplicationMgr().EvtSel = 'NONE'
+ApplicationMgr().EvtMax = 1
+ApplicationMgr().OutputLevel = INFO
+
+
+# Single precision map compared to the double precision one
+from Configurables import SimG4MagneticFieldFromMapTool
+field = SimG4MagneticFieldFromMapTool("SinglePrecisionField")
+field.MapFile = "testfield3d_comparator.root"
+field.MapPrecision = "float"
+field.FieldOn = True
+
+referenceField = SimG4MagneticFieldFromMapTool("DoublePrecisionField")
+referenceField.MapFile = "testfield3d_comparator.root"
+referenceField.MapPrecision = "double"
+referenceField.FieldOn = True
+
+from Configurables import MagFieldComparator
+comparator = MagFieldComparator("MagFieldComparator")
+comparator.field = field
+comparator.referenceField = referenceField
+comparator.regions = [
+#   rMin,  rMax,  zMin,  zMax
+    [0,    1*m,   -4*m,  4*m],
+    [1*m,  2*m,   -6*m,  6*m],
+]
+comparator.regionNames = ["inner", "outer"]
+comparator.sampling = "random"
+comparator.nSamples = 200000
+comparator.maxDiffTolerance = 1e-5 * tesla
+comparator.OutputLevel = INFO
+ApplicationMgr().ExtSvc += [comparator]
@@ -44,6 +44,7 @@ ApplicationMgr().ExtSvc += [geantservice]
 from Configurables import MagFieldScanner
 magfieldscanner = MagFieldScanner("MagFieldScanner")
 magfieldscanner.outFilePath = "hello.root"
+magfieldscanner.nThreads = 4
 magfieldscanner.xyPlaneProbes = [
 #   xMax,    yMax, z
     [160*cm, 1600, 0],
@@ -0,0 +1,37 @@
+import os
+from Gaudi.Configuration import INFO
+
+from Configurables import ApplicationMgr
+ApplicationMgr().EvtSel = 'NONE'
+ApplicationMgr().EvtMax = 1
+ApplicationMgr().OutputLevel = INFO
+ApplicationMgr().StopOnSignal = True
+
+# Detector geometry
+from Configurables import GeoSvc
+geoservice = GeoSvc("GeoSvc")
+path_to_detectors = os.environ.get("FCCDETECTORS", "")
+detectors_to_use = [
+    'Detector/DetFCCeeIDEA-LAr/compact/FCCee_DectMaster.xml',
+]
+geoservice.detectors = [os.path.join(path_to_detectors, det)
+                        for det in detectors_to_use]
+geoservice.OutputLevel = INFO
+ApplicationMgr().ExtSvc += [geoservice]
+
+# 2D scan writing the cumulative X0 / lambda lookup table
+# The last checkpoint (100 m) is outside of the world, so it sees all the material of the scanned ray
+# and the map can be compared to the scan with Detector/DetComponents/tests/scripts/checkMaterialMap.py
+from Configurables import MaterialScan_2D_genericAngle
+materialservice2D = MaterialScan_2D_genericAngle("GeoDumpMap")
+materialservice2D.filename = "materialMapScan.root"
+materialservice2D.angleDef = "theta"
+materialservice2D.angleBinning = 10.
+materialservice2D.angleMin = 10.
+materialservice2D.angleMax = 170.
+materialservice2D.nPhi = 8
+materialservice2D.nThreads = 4
+materialservice2D.mapFilename = "materialMap.bin"
+materialservice2D.mapRMax = 100000.
+materialservice2D.mapNRadii = 101
+ApplicationMgr().ExtSvc += [materialservice2D]
@@ -0,0 +1,43 @@
+import os
+from Gaudi.Configuration import INFO
+
+from Configurables import ApplicationMgr
+ApplicationMgr().EvtSel = 'NONE'
+ApplicationMgr().EvtMax = 1
+ApplicationMgr().OutputLevel = INFO
+ApplicationMgr().StopOnSignal = True
+
+# Detector geometry
+from Configurables import GeoSvc
+geoservice = GeoSvc("GeoSvc")
+path_to_detectors = os.environ.get("FCCDETECTORS", "")
+detectors_to_use = [
+    'Detector/DetFCCeeIDEA-LAr/compact/FCCee_DectMaster.xml',
+]
+geoservice.detectors = [os.path.join(path_to_detectors, det)
+                        for det in detectors_to_use]
+geoservice.OutputLevel = INFO
+ApplicationMgr().ExtSvc += [geoservice]
+
+# Material scan, the eta bins are scanned in parallel by MATERIAL_SCAN_NTHREADS threads
+n_threads = int(os.environ.get("MATERIAL_SCAN_NTHREADS", "4"))
+from Configurables import MaterialScan
+materialservice = MaterialScan("GeoDump")
+materialservice.filename = "materialScan_{}threads.root".format(n_threads)
+materialservice.etaBinning = 0.2
+materialservice.etaMax = 2.
+materialservice.nPhiTrials = 10
+materialservice.nThreads = n_threads
+ApplicationMgr().ExtSvc += [materialservice]
+
+# 2D scan on top of the same scan engine
+from Configurables import MaterialScan_2D_genericAngle
+materialservice2D = MaterialScan_2D_genericAngle("GeoDump2D")
+materialservice2D.filename = "materialScan2D_{}threads.root".format(n_threads)
+materialservice2D.angleDef = "theta"
+materialservice2D.angleBinning = 10.
+materialservice2D.angleMin = 10.
+materialservice2D.angleMax = 170.
+materialservice2D.nPhi = 8
+materialservice2D.nThreads = n_threads
+ApplicationMgr().ExtSvc += [materialservice2D]
@@ -0,0 +1,43 @@
+import os
+from Gaudi.Configuration import INFO
+
+from Configurables import ApplicationMgr
+ApplicationMgr().EvtSel = 'NONE'
+ApplicationMgr().EvtMax = 1
+ApplicationMgr().OutputLevel = INFO
+ApplicationMgr().StopOnSignal = True
+
+# Detector geometry
+from Configurables import GeoSvc
+geoservice = GeoSvc("GeoSvc")
+path_to_detectors = os.environ.get("FCCDETECTORS", "")
+detectors_to_use = [
+    'Detector/DetFCCeeIDEA-LAr/compact/FCCee_DectMaster.xml',
+]
+geoservice.detectors = [os.path.join(path_to_detectors, det)
+                        for det in detectors_to_use]
+geoservice.OutputLevel = INFO
+ApplicationMgr().ExtSvc += [geoservice]
+
+# 2D scan split into MATERIAL_SCAN_NSHARDS jobs, this one scanning the shard MATERIAL_SCAN_SHARD
+# merge the outputs with Detector/DetComponents/scripts/mergeMaterialScans.py
+n_shards = int(os.environ.get("MATERIAL_SCAN_NSHARDS", "1"))
+shard = int(os.environ.get("MATERIAL_SCAN_SHARD", "0"))
+from Configurables import MaterialScan_2D_genericAngle
+materialservice = MaterialScan_2D_genericAngle("GeoDump2D")
+if n_shards > 1:
+    materialservice.filename = "materialScanShard{}.root".format(shard)
+else:
+    materialservice.filename = "materialScanShardsFull.root"
+materialservice.angleDef = "theta"
+materialservice.angleBinning = 10.
+materialservice.angleMin = 10.
+materialservice.angleMax = 170.
+materialservice.nPhi = 8
+materialservice.nThreads = 4
+materialservice.nShards = n_shards
+materialservice.shard = shard
+# flush the tree into the file every 16 entries, killed jobs continue with resume
+materialservice.checkpointEntries = 16
+materialservice.resume = True
+ApplicationMgr().ExtSvc += [materialservice]
@@ -0,0 +1,48 @@
+# RedoSegmentation with the cache of the new cellIDs and parallel chunks, in the multithreaded event loop.
+# Reads the hits written by redoSegmentationModuleThetaMerged.py, the output is compared with its serial
+# RedoSegmentation hit by hit by Detector/DetComponents/tests/scripts/compareCellIDs.py
+import os
+from Gaudi.Configuration import INFO, WARNING
+
+from Configurables import HiveWhiteBoard, HiveSlimEventLoopMgr, AvalancheSchedulerSvc
+from k4FWCore import ApplicationMgr, IOSvc
+
+# several events are processed at once, sharing the cache of the algorithm
+evtslots = 4
+threads = 4
+whiteboard = HiveWhiteBoard("EventDataSvc", EventSlots=evtslots, ForceLeaves=True)
+slimeventloopmgr = HiveSlimEventLoopMgr(SchedulerName="AvalancheSchedulerSvc", OutputLevel=WARNING)
+scheduler = AvalancheSchedulerSvc(ThreadPoolSize=threads, OutputLevel=WARNING)
+
+iosvc = IOSvc("IOSvc")
+iosvc.Input = "redoSegmentationModuleThetaMerged.root"
+iosvc.Output = "redoSegmentationMT.root"
+iosvc.outputCommands = ["keep *"]
+
+# DD4hep geometry service
+from Configurables import GeoSvc
+path_to_detectors = os.environ.get("FCCDETECTORS", "")
+detectors_to_use = [
+    'Detector/DetFCCeeIDEA-LAr/compact/FCCee_DectEmptyMaster.xml',
+    'Detector/DetFCCeeECalInclined/compact/FCCee_ECalBarrel_thetamodulemerged.xml',
+]
+geoservice = GeoSvc("GeoSvc", detectors=[os.path.join(path_to_detectors, det) for det in detectors_to_use],
+                    OutputLevel = INFO)
+
+from Configurables import RedoSegmentation
+resegment = RedoSegmentation("ReSegmentationMT",
+                             oldReadoutName = "ECalBarrelModuleThetaMerged",
+                             oldSegmentationIds = ["module", "theta"],
+                             newReadoutName = "ECalBarrelModuleThetaMerged2",
+                             cacheSize = 100000,
+                             parallelChunkSize = 100)
+resegment.inhits.Path = "positionedCaloHits"
+resegment.outhits.Path = "newCaloHitsMT"
+
+ApplicationMgr(TopAlg = [resegment],
+               EvtSel = 'NONE',
+               EvtMax = -1,
+               ExtSvc = [whiteboard, geoservice],
+               EventLoop = slimeventloopmgr,
+               MessageSvcType = "InertMessageSvc",
+               OutputLevel = INFO)
@@ -0,0 +1,59 @@
+# RedoSegmentation of the hits of the FCC-ee calorimeter barrel from the module-theta merged readout into the readout
+# with a different merging, with the serial loop and with the cellIDs computed in parallel chunks of 100 hits.
+# The outputs are compared hit by hit by Detector/DetComponents/tests/scripts/compareCellIDs.py
+import os
+from Gaudi.Configuration import *
+
+# DD4hep geometry service
+from Configurables import GeoSvc
+path_to_detectors = os.environ.get("FCCDETECTORS", "")
+detectors_to_use = [
+    'Detector/DetFCCeeIDEA-LAr/compact/FCCee_DectEmptyMaster.xml',
+    'Detector/DetFCCeeECalInclined/compact/FCCee_ECalBarrel_thetamodulemerged.xml',
+]
+geoservice = GeoSvc("GeoSvc", detectors=[os.path.join(path_to_detectors, det) for det in detectors_to_use],
+                    OutputLevel = INFO)
+
+# Geant4 service
+from Configurables import SimG4Svc
+geantservice = SimG4Svc("SimG4Svc")
+
+# Geant4 algorithm with a tool that saves the calorimeter hits
+from Configurables import SimG4Alg, SimG4SaveCalHits
+savecaltool = SimG4SaveCalHits("saveECalHits", readoutNames = ["ECalBarrelModuleThetaMerged"])
+savecaltool.positionedCaloHits.Path = "positionedCaloHits"
+savecaltool.caloHits.Path = "caloHits"
+from Configurables import SimG4SingleParticleGeneratorTool
+pgun=SimG4SingleParticleGeneratorTool("SimG4SingleParticleGeneratorTool",saveEdm=True,
+                particleName="e-",energyMin=50000,energyMax=50000,etaMin=-0.5,etaMax=0.5)
+geantsim = SimG4Alg("SimG4Alg", outputs= ["SimG4SaveCalHits/saveECalHits"], eventProvider=pgun)
+
+# serial reference without the cache of the new cellIDs
+from Configurables import RedoSegmentation
+resegment = RedoSegmentation("ReSegmentation",
+                             oldReadoutName = "ECalBarrelModuleThetaMerged",
+                             oldSegmentationIds = ["module", "theta"],
+                             newReadoutName = "ECalBarrelModuleThetaMerged2",
+                             cacheSize = 0)
+resegment.inhits.Path = "positionedCaloHits"
+resegment.outhits.Path = "newCaloHits"
+resegmentChunked = RedoSegmentation("ReSegmentationChunked",
+                                    oldReadoutName = "ECalBarrelModuleThetaMerged",
+                                    oldSegmentationIds = ["module", "theta"],
+                                    newReadoutName = "ECalBarrelModuleThetaMerged2",
+                                    cacheSize = 0,
+                                    parallelChunkSize = 100)
+resegmentChunked.inhits.Path = "positionedCaloHits"
+resegmentChunked.outhits.Path = "newCaloHitsChunked"
+
+from Configurables import FCCDataSvc, PodioOutput
+podiosvc = FCCDataSvc("EventDataSvc")
+out = PodioOutput("out", filename="redoSegmentationModuleThetaMerged.root")
+out.outputCommands = ["keep *"]
+
+from Configurables import ApplicationMgr
+ApplicationMgr(TopAlg = [geantsim, resegment, resegmentChunked, out],
+               EvtSel = 'NONE',
+               EvtMax = 4,
+               ExtSvc = [podiosvc, geoservice, geantservice],
+               OutputLevel = INFO)
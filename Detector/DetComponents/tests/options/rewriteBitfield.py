@@ -31,6 +31,8 @@ rewrite = RewriteBitfield("Rewrite",
                           removeIds = ["sublayer"],
                           # new bitfield (readout), with new segmentation
                           newReadoutName = "EMECPhiEtaReco",
+                          # remap the cellIDs in parallel chunks of 10000 hits (0 for a serial loop)
+                          parallelChunkSize = 10000,
                           debugPrint = 10,
                           OutputLevel = DEBUG)
 # clusters are needed, with deposit position and cellID in bits
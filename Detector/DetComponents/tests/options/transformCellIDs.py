@@ -0,0 +1,79 @@
+# Fused transformation of the cellIDs, compared to the chain of RewriteBitfield and MergeCells with aggregation
+# by Detector/DetComponents/tests/scripts/checkTransformCellIDs.py
+import os
+from Gaudi.Configuration import *
+
+# DD4hep geometry service
+from Configurables import GeoSvc
+path_to_detectors = os.environ.get("FCCDETECTORS", "")
+detectors_to_use = [
+    'Detector/DetFCChhBaseline1/compact/FCChh_DectEmptyMaster.xml',
+    'Detector/DetFCChhCalDiscs/compact/Endcaps_coneCryo.xml',
+]
+geoservice = GeoSvc("GeoSvc", detectors=[os.path.join(path_to_detectors, det) for det in detectors_to_use],
+                    OutputLevel = INFO)
+
+# Geant4 service
+# Configures the Geant simulation: geometry, physics list and user actions
+from Configurables import SimG4Svc
+geantservice = SimG4Svc("SimG4Svc")
+
+# Geant4 algorithm
+# Translates EDM to G4Event, passes the event to G4, writes out outputs via tools
+# and a tool that saves the calorimeter hits
+from Configurables import SimG4Alg, SimG4SaveCalHits
+savecaltool = SimG4SaveCalHits("saveECalHits", readoutNames = ["EMECPhiEta"])
+savecaltool.positionedCaloHits.Path = "positionedCaloHits"
+savecaltool.caloHits.Path = "caloHits"
+from Configurables import SimG4SingleParticleGeneratorTool
+pgun=SimG4SingleParticleGeneratorTool("SimG4SingleParticleGeneratorTool",saveEdm=True,
+                particleName="e-",energyMin=50000,energyMax=50000,etaMin=2,etaMax=2)
+geantsim = SimG4Alg("SimG4Alg", outputs= ["SimG4SaveCalHits/saveECalHits"], eventProvider=pgun)
+
+from Configurables import TransformCellIDs
+transform = TransformCellIDs("Transform",
+                             # bitfield (readout) of the input hits
+                             readout = "EMECPhiEta",
+                             # transformations applied in the given order:
+                             # rewrite into the readout with new segmentation without the sublayer field,
+                             # then merge 3 cells in phi (odd number as the field is signed)
+                             transforms = ["RewriteBitfield:EMECPhiEtaReco:sublayer",
+                                           "MergeCells:phi:3"],
+                             debugPrint = 10,
+                             OutputLevel = DEBUG)
+# hits in the same merged cell are combined into one hit
+transform.inhits.Path = "caloHits"
+transform.outhits.Path = "caloMergedHits"
+
+# the same transformations as a chain of algorithms, for the comparison
+from Configurables import RewriteBitfield, MergeCells
+rewrite = RewriteBitfield("Rewrite",
+                          oldReadoutName = "EMECPhiEta",
+                          removeIds = ["sublayer"],
+                          newReadoutName = "EMECPhiEtaReco")
+rewrite.inhits.Path = "caloHits"
+rewrite.outhits.Path = "caloRecoHits"
+merge = MergeCells("Merge",
+                   readout = "EMECPhiEtaReco",
+                   identifier = "phi",
+                   merge = 3,
+                   # combine the hits that end up in the same merged cell into one hit
+                   aggregate = True)
+merge.inhits.Path = "caloRecoHits"
+merge.outhits.Path = "caloChainMergedHits"
+
+# PODIO algorithm
+from Configurables import FCCDataSvc, PodioOutput
+podiosvc = FCCDataSvc("EventDataSvc")
+out = PodioOutput("out")
+out.outputCommands = ["keep *"]
+out.filename = "transformedCellIDs_ecalEndcapSim.root"
+
+# ApplicationMgr
+from Configurables import ApplicationMgr
+ApplicationMgr( TopAlg = [geantsim, transform, rewrite, merge, out],
+                EvtSel = 'NONE',
+                EvtMax   = 1,
+                # order is important, as GeoSvc is needed by G4SimSvc
+                ExtSvc = [podiosvc, geoservice, geantservice],
+                OutputLevel=INFO)
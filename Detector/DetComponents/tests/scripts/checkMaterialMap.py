@@ -0,0 +1,43 @@
+# Read the material map back with sim::MaterialMap and compare it to the material scan it was made from.
+# usage: python checkMaterialMap.py <map file> <scan file> <SimG4Common include directory>
+# The last checkpoint of the map has to be outside of the scanned envelope.
+import math
+import sys
+
+import ROOT
+from numpy import testing
+
+if __name__ == "__main__":
+    map_name, scan_name, include_dir = sys.argv[1:4]
+    ROOT.gInterpreter.AddIncludePath(include_dir)
+    ROOT.gInterpreter.Declare('#include "SimG4Common/MaterialMap.h"')
+    ROOT.gSystem.Load("libSimG4Common")
+
+    material_map = ROOT.sim.MaterialMap.read(map_name)
+    scan = ROOT.TFile.Open(scan_name)
+    tree = scan.Get("materials")
+    n_checked = 0
+    for entry in tree:
+        theta = math.radians(entry.angle)
+        direction = ROOT.std.array("double", 3)()
+        direction[0] = math.sin(theta) * math.cos(entry.phi)
+        direction[1] = math.sin(theta) * math.sin(entry.phi)
+        direction[2] = math.cos(theta)
+        total = material_map.materialUpTo(direction, material_map.rMax())
+        testing.assert_allclose(total.nX0, sum(entry.nX0), rtol=1e-5)
+        testing.assert_allclose(total.nLambda, sum(entry.nLambda), rtol=1e-5)
+        # the material between two distances adds up to the total
+        half = 0.5 * material_map.rMax()
+        inner = material_map.materialBetween(direction, 0., half)
+        outer = material_map.materialBetween(direction, half, material_map.rMax())
+        testing.assert_allclose(inner.nX0 + outer.nX0, total.nX0, rtol=1e-5)
+        n_checked += 1
+    # directions outside of the angle range are clamped to the first and last bin
+    for z in [1., -1.]:
+        direction = ROOT.std.array("double", 3)()
+        direction[2] = z
+        material_map.materialUpTo(direction, material_map.rMax())
+    if n_checked != material_map.nAngleBins() * material_map.nPhiBins():
+        sys.exit("Material map has {} bins, {} found in the scan".format(
+            material_map.nAngleBins() * material_map.nPhiBins(), n_checked))
+    print("Material map read back, {} bins agree with the scan".format(n_checked))
@@ -0,0 +1,36 @@
+# Compare the hits of the fused cellID transformation to the hits of the chain of algorithms it replaces.
+# usage: python checkTransformCellIDs.py <file written by transformCellIDs.py>
+# Both collections have to contain one hit per cell, with the same cells and energies.
+import sys
+from collections import Counter
+
+from podio.root_io import Reader
+from numpy import testing
+
+
+def cell_energies(hits):
+    """Energy per cellID, every cellID has to appear once"""
+    counts = Counter(hit.getCellID() for hit in hits)
+    repeated = [cellId for cellId, count in counts.items() if count > 1]
+    assert not repeated, "cells with more than one hit: {}".format(repeated)
+    return {hit.getCellID(): hit.getEnergy() for hit in hits}
+
+
+if __name__ == "__main__":
+    reader = Reader(sys.argv[1])
+    n_events = 0
+    n_cells = 0
+    for event in reader.get("events"):
+        n_hits = len(event.get("caloHits"))
+        fused = cell_energies(event.get("caloMergedHits"))
+        chain = cell_energies(event.get("caloChainMergedHits"))
+        assert len(fused) == len(chain), "{} cells from the fused transformation, {} from the chain".format(
+            len(fused), len(chain))
+        assert fused.keys() == chain.keys(), "different cells from the fused transformation and from the chain"
+        assert 0 < len(fused) < n_hits, "{} hits are not merged into fewer cells: {}".format(n_hits, len(fused))
+        for cellId, energy in fused.items():
+            testing.assert_allclose(energy, chain[cellId], rtol=1e-6, err_msg="energy in cell {}".format(cellId))
+        n_events += 1
+        n_cells += len(fused)
+    assert n_events > 0, "no events in " + sys.argv[1]
+    print("Transformed hits of {} events in {} cells agree with the chain of algorithms".format(n_events, n_cells))
@@ -0,0 +1,39 @@
+# Compare hit collections of the same events hit by hit, e.g. the output of an algorithm with the serial loop
+# and with the cellIDs transformed in parallel chunks.
+# usage: python compareCellIDs.py <file> <collection>:<collection to compare with> [...] [--min-hits N]
+# The collections have to contain the same hits in the same order, with the same cellIDs and energies.
+import argparse
+
+from podio.root_io import Reader
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("filename", help="file with both collections in every event")
+    parser.add_argument("pairs", nargs="+", help="names of the collections to compare, separated by a colon")
+    parser.add_argument("--min-hits", type=int, default=0,
+                        help="minimal number of hits of the largest event, so the chunks are really used")
+    args = parser.parse_args()
+
+    pairs = [pair.split(":") for pair in args.pairs]
+    reader = Reader(args.filename)
+    n_events = 0
+    n_hits = 0
+    max_hits = 0
+    for event in reader.get("events"):
+        for name, other_name in pairs:
+            hits = event.get(name)
+            other_hits = event.get(other_name)
+            assert len(hits) == len(other_hits), "event {}: {} hits in {}, {} in {}".format(
+                n_events, len(hits), name, len(other_hits), other_name)
+            for iHit, (hit, other_hit) in enumerate(zip(hits, other_hits)):
+                assert hit.getCellID() == other_hit.getCellID(), "event {}, hit {}: cellID {} in {}, {} in {}".format(
+                    n_events, iHit, hit.getCellID(), name, other_hit.getCellID(), other_name)
+                assert hit.getEnergy() == other_hit.getEnergy(), "event {}, hit {}: different energy in {} and {}".format(
+                    n_events, iHit, name, other_name)
+            n_hits += len(hits)
+            max_hits = max(max_hits, len(hits))
+        n_events += 1
+    assert n_events > 0, "no events in " + args.filename
+    assert max_hits > args.min_hits, "at most {} hits in an event, expected more than {}".format(max_hits, args.min_hits)
+    print("{} collections of {} events with {} hits are identical hit by hit".format(len(pairs), n_events, n_hits))
@@ -0,0 +1,19 @@
+"""Compare the 'materials' trees of two material scans entry by entry,
+e.g. of a scan with several threads and of the serial scan.
+"""
+import argparse
+import sys
+
+from mergeMaterialScans import compare
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("scan", help="output file of the scan")
+    parser.add_argument("reference", help="output file of the reference scan")
+    args = parser.parse_args()
+
+    difference = compare(args.scan, args.reference)
+    if difference:
+        sys.exit("Scan {} differs from {}: {}".format(args.scan, args.reference, difference))
+    print("Scan {} is identical to {}".format(args.scan, args.reference))
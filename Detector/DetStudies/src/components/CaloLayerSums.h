@@ -0,0 +1,110 @@
+#ifndef DETSTUDIES_CALOLAYERSUMS_H
+#define DETSTUDIES_CALOLAYERSUMS_H
+
+// DD4hep
+#include "DDSegmentation/BitFieldCoder.h"
+
+// STD
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace det {
+/// Energy of one event in the layers of a sampling calorimeter, see SamplingFractionInLayers
+struct SamplingLayerSums {
+  explicit SamplingLayerSums(size_t aNumLayers) : layers(aNumLayers, 0.), activeLayers(aNumLayers, 0.) {}
+  /// Energy in the calorimeter, from the first calorimeter layer on
+  double total = 0.;
+  /// Energy in the active material of the calorimeter
+  double active = 0.;
+  /// Energy per layer
+  std::vector<double> layers;
+  /// Energy in the active material per layer
+  std::vector<double> activeLayers;
+};
+
+/**  Sum the energy of the hits per layer and in the active material.
+ *   @param[in] aHits hits of the event.
+ *   @param[in] aLayerField field of the layer.
+ *   @param[in] aActiveField field of the material type.
+ *   @param[in] aActiveValue value of the material type of the active material.
+ *   @param[in] aNumLayers number of layers.
+ *   @param[in] aFirstLayerId first layer of the calorimeter, the layers before are outside of it.
+ *   @return energy sums, throws std::out_of_range for a hit outside of the layers.
+ */
+template <typename Hits>
+SamplingLayerSums sumSamplingLayers(const Hits& aHits, const dd4hep::DDSegmentation::BitFieldElement& aLayerField,
+                                    const dd4hep::DDSegmentation::BitFieldElement& aActiveField,
+                                    dd4hep::DDSegmentation::long64 aActiveValue, size_t aNumLayers,
+                                    size_t aFirstLayerId) {
+  SamplingLayerSums sums(aNumLayers);
+  for (const auto& hit : aHits) {
+    const dd4hep::DDSegmentation::CellID cellId = hit.getCellID();
+    const double energy = hit.getEnergy();
+    const auto layer = aLayerField.value(cellId);
+    if (layer < 0 || size_t(layer) >= aNumLayers) {
+      throw std::out_of_range("Layer " + std::to_string(layer) + " is outside of the " + std::to_string(aNumLayers) +
+                              " calorimeter layers");
+    }
+    sums.layers[layer] += energy;
+    // check if energy was deposited in the calorimeter (active/passive material)
+    if (size_t(layer) >= aFirstLayerId) {
+      sums.total += energy;
+      // active material of calorimeter
+      if (aActiveField.value(cellId) == aActiveValue) {
+        sums.active += energy;
+        sums.activeLayers[layer] += energy;
+      }
+    }
+  }
+  return sums;
+}
+
+/// Energy of one event in the calorimeter layers and in the cryostat, see EnergyInCaloLayers
+struct CaloLayerSums {
+  explicit CaloLayerSums(size_t aNumLayers) : layers(aNumLayers, 0.) {}
+  /// Energy per layer
+  std::vector<double> layers;
+  /// Energy in the whole cryostat, its front, back, sides, LAr bath front and LAr bath back
+  std::array<double, 6> cryo{};
+};
+
+/**  Sum the energy of the hits per calorimeter layer and per part of the cryostat.
+ *   @param[in] aHits hits of the event.
+ *   @param[in] aCryoField field that is 0 in the calorimeter and not 0 in the cryostat.
+ *   @param[in] aLayerField field of the calorimeter layer.
+ *   @param[in] aTypeField field of the cryostat part, from 1 to 5.
+ *   @param[in] aNumLayers number of calorimeter layers.
+ *   @return energy sums, throws std::out_of_range for a hit outside of the layers or in an unknown cryostat part.
+ */
+template <typename Hits>
+CaloLayerSums sumCaloLayers(const Hits& aHits, const dd4hep::DDSegmentation::BitFieldElement& aCryoField,
+                            const dd4hep::DDSegmentation::BitFieldElement& aLayerField,
+                            const dd4hep::DDSegmentation::BitFieldElement& aTypeField, size_t aNumLayers) {
+  CaloLayerSums sums(aNumLayers);
+  for (const auto& hit : aHits) {
+    const dd4hep::DDSegmentation::CellID cellId = hit.getCellID();
+    const double energy = hit.getEnergy();
+    if (aCryoField.value(cellId) == 0) {
+      const auto layer = aLayerField.value(cellId);
+      if (layer < 0 || size_t(layer) >= aNumLayers) {
+        throw std::out_of_range("Layer " + std::to_string(layer) + " is outside of the " +
+                                std::to_string(aNumLayers) + " calorimeter layers");
+      }
+      sums.layers[layer] += energy;
+    } else {
+      const auto cryoType = aTypeField.value(cellId);
+      if (cryoType < 0 || size_t(cryoType) >= sums.cryo.size()) {
+        throw std::out_of_range("Unknown cryostat part " + std::to_string(cryoType));
+      }
+      sums.cryo[0] += energy;
+      sums.cryo[cryoType] += energy;
+    }
+  }
+  return sums;
+}
+}
+
+#endif /* DETSTUDIES_CALOLAYERSUMS_H */
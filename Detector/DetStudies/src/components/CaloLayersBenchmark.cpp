@@ -0,0 +1,181 @@
+#include "CaloLayersBenchmark.h"
+#include "CaloLayerSums.h"
+
+// datamodel
+#include "edm4hep/SimCalorimeterHitCollection.h"
+
+// DD4hep
+#include "DD4hep/Detector.h"
+#include "DD4hep/Readout.h"
+
+// STD
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+DECLARE_COMPONENT(CaloLayersBenchmark)
+
+namespace {
+/// Time per event of the summation repeated for all events, in ns
+template <typename Sum>
+double timePerEvent(unsigned aNumEvents, Sum&& aSum) {
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned iEvent = 0; iEvent < aNumEvents; ++iEvent) {
+    aSum();
+  }
+  const std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+  return duration.count() / std::max(aNumEvents, 1u);
+}
+
+/// Whether the summation rejects the hits with std::out_of_range
+template <typename Sum>
+bool rejects(Sum&& aSum) {
+  try {
+    aSum();
+  } catch (const std::out_of_range&) {
+    return true;
+  }
+  return false;
+}
+}
+
+CaloLayersBenchmark::CaloLayersBenchmark(const std::string& name, ISvcLocator* svcLoc)
+    : Service(name, svcLoc), m_geoSvc("GeoSvc", name) {}
+
+StatusCode CaloLayersBenchmark::initialize() {
+  if (Service::initialize().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  if (!m_geoSvc) {
+    error() << "Unable to find Geometry Service." << endmsg;
+    return StatusCode::FAILURE;
+  }
+  auto detector = m_geoSvc->getDetector();
+  if (detector->readouts().find(m_readoutName) == detector->readouts().end()) {
+    error() << "Readout <<" << m_readoutName << ">> does not exist." << endmsg;
+    return StatusCode::FAILURE;
+  }
+  const auto* decoder = detector->readout(m_readoutName).idSpec().decoder();
+
+  const dd4hep::DDSegmentation::BitFieldElement* layerField = nullptr;
+  const dd4hep::DDSegmentation::BitFieldElement* activeField = nullptr;
+  const dd4hep::DDSegmentation::BitFieldElement* cryoField = nullptr;
+  const dd4hep::DDSegmentation::BitFieldElement* typeField = nullptr;
+  edm4hep::SimCalorimeterHitCollection hits;
+  try {
+    layerField = &(*decoder)[m_layerFieldName.value()];
+    activeField = &(*decoder)[m_activeFieldName.value()];
+    cryoField = &(*decoder)[m_cryoFieldName.value()];
+    typeField = &(*decoder)[m_typeFieldName.value()];
+    // hits with random values of all fields, in the given layers and every second one in the active material,
+    // every tenth hit is in the front of the cryostat
+    dd4hep::DDSegmentation::CellID fieldsMask = 0;
+    for (size_t itField = 0; itField < decoder->size(); itField++) {
+      fieldsMask |= (*decoder)[itField].mask();
+    }
+    std::mt19937_64 generator(m_seed);
+    for (unsigned iHit = 0; iHit < m_nHits; ++iHit) {
+      dd4hep::DDSegmentation::CellID cellId = generator() & fieldsMask;
+      layerField->set(cellId, generator() % m_numLayers);
+      activeField->set(cellId, iHit % 2 ? m_activeFieldValue.value() : int(m_activeFieldValue == 0));
+      cryoField->set(cellId, iHit % 10 == 0);
+      if (iHit % 10 == 0) {
+        typeField->set(cellId, 1);
+      }
+      auto hit = hits.create();
+      hit.setCellID(cellId);
+      hit.setEnergy(std::generate_canonical<double, 32>(generator));
+    }
+  } catch (const std::runtime_error& e) {
+    error() << "Unable to create the hits: " << e.what() << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  // sums of all events: per layer and in the active material per layer of SamplingFractionInLayers,
+  // per calorimeter layer and per cryostat part of EnergyInCaloLayers
+  std::vector<double> byNameLayers(m_numLayers, 0.), byNameActive(m_numLayers, 0.), byNameCalo(m_numLayers, 0.);
+  std::vector<double> resolvedLayers(m_numLayers, 0.), resolvedActive(m_numLayers, 0.), resolvedCalo(m_numLayers, 0.);
+  std::array<double, 6> byNameCryo{}, resolvedCryo{};
+  const double byName = timePerEvent(m_nEvents, [&]() {
+    auto eventDecoder = detector->readout(m_readoutName).idSpec().decoder();
+    std::vector<double> sumLayers(m_numLayers, 0.), sumActive(m_numLayers, 0.), sumCalo(m_numLayers, 0.);
+    std::array<double, 6> sumCryo{};
+    for (const auto& hit : hits) {
+      const auto layer = eventDecoder->get(hit.getCellID(), m_layerFieldName);
+      sumLayers.at(layer) += hit.getEnergy();
+      if (eventDecoder->get(hit.getCellID(), m_activeFieldName) == m_activeFieldValue) {
+        sumActive.at(layer) += hit.getEnergy();
+      }
+      if (eventDecoder->get(hit.getCellID(), m_cryoFieldName) == 0) {
+        sumCalo.at(layer) += hit.getEnergy();
+      } else {
+        sumCryo[0] += hit.getEnergy();
+        sumCryo.at(eventDecoder->get(hit.getCellID(), m_typeFieldName)) += hit.getEnergy();
+      }
+    }
+    for (unsigned i = 0; i < m_numLayers; i++) {
+      byNameLayers[i] += sumLayers[i];
+      byNameActive[i] += sumActive[i];
+      byNameCalo[i] += sumCalo[i];
+    }
+    for (size_t i = 0; i < sumCryo.size(); i++) {
+      byNameCryo[i] += sumCryo[i];
+    }
+  });
+  // the sums of the algorithms
+  const double resolved = timePerEvent(m_nEvents, [&]() {
+    const auto sampling = det::sumSamplingLayers(hits, *layerField, *activeField, m_activeFieldValue, m_numLayers, 0);
+    const auto calo = det::sumCaloLayers(hits, *cryoField, *layerField, *typeField, m_numLayers);
+    for (unsigned i = 0; i < m_numLayers; i++) {
+      resolvedLayers[i] += sampling.layers[i];
+      resolvedActive[i] += sampling.activeLayers[i];
+      resolvedCalo[i] += calo.layers[i];
+    }
+    for (size_t i = 0; i < calo.cryo.size(); i++) {
+      resolvedCryo[i] += calo.cryo[i];
+    }
+  });
+  if (byNameLayers != resolvedLayers || byNameActive != resolvedActive || byNameCalo != resolvedCalo ||
+      byNameCryo != resolvedCryo) {
+    error() << "Sums with the resolved fields differ from the sums with the fields looked up by name" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  info() << "Energy in " << m_numLayers << " layers of " << m_nEvents << " events with " << hits.size()
+         << " hits: " << byName << " ns/event by name, " << resolved << " ns/event resolved" << endmsg;
+
+  // hits outside of the layers and in unknown cryostat parts have to be rejected
+  if (unsigned(layerField->maxValue()) >= m_numLayers) {
+    auto hit = hits.create();
+    dd4hep::DDSegmentation::CellID cellId = 0;
+    layerField->set(cellId, m_numLayers);
+    hit.setCellID(cellId);
+    const bool rejected =
+        rejects([&]() { det::sumSamplingLayers(hits, *layerField, *activeField, m_activeFieldValue, m_numLayers, 0); }) &&
+        rejects([&]() { det::sumCaloLayers(hits, *cryoField, *layerField, *typeField, m_numLayers); });
+    if (!rejected) {
+      error() << "Hit in layer " << m_numLayers << " is not rejected" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    // back inside of the layers
+    layerField->set(cellId, 0);
+    hit.setCellID(cellId);
+  }
+  if (typeField->maxValue() >= int(resolvedCryo.size())) {
+    auto hit = hits.create();
+    dd4hep::DDSegmentation::CellID cellId = 0;
+    cryoField->set(cellId, 1);
+    typeField->set(cellId, resolvedCryo.size());
+    hit.setCellID(cellId);
+    if (!rejects([&]() { det::sumCaloLayers(hits, *cryoField, *layerField, *typeField, m_numLayers); })) {
+      error() << "Hit in cryostat part " << resolvedCryo.size() << " is not rejected" << endmsg;
+      return StatusCode::FAILURE;
+    }
+  }
+  info() << "Calorimeter layers benchmark finished with identical sums" << endmsg;
+  return StatusCode::SUCCESS;
+}
+
+StatusCode CaloLayersBenchmark::finalize() { return Service::finalize(); }
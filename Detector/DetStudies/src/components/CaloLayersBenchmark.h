@@ -0,0 +1,60 @@
+#ifndef DETSTUDIES_CALOLAYERSBENCHMARK_H
+#define DETSTUDIES_CALOLAYERSBENCHMARK_H
+
+// Gaudi
+#include "GaudiKernel/Service.h"
+
+// k4FWCore
+#include "k4Interface/IGeoSvc.h"
+
+// STD
+#include <string>
+
+/** @class CaloLayersBenchmark CaloLayersBenchmark.h
+ *
+ *  Service measuring on initialize the time spent per event in the sums of energy per calorimeter layer of
+ *  SamplingFractionInLayers and EnergyInCaloLayers, as in calibration productions of many single-particle events.
+ *  A collection of \b'nHits' hits with random cellIDs of the readout \b'readoutName' is created, with the layer
+ *  field (\b'layerFieldName') in [0, \b'numLayers') and the active field (\b'activeFieldName') set to
+ *  \b'activeFieldValue' for every second hit. Every tenth hit is in the front of the cryostat (\b'cryoFieldName' and
+ *  \b'typeFieldName' set to 1). The energy sums of both algorithms are then computed for \b'nEvents' events, once
+ *  with the decoder retrieved for every event and the fields looked up by name for every hit, and once with the
+ *  functions used by the algorithms (see CaloLayerSums.h). The sums have to be identical, and the functions have to
+ *  reject hits outside of the layers and in unknown cryostat parts.
+ *
+ *  For an example see Detector/DetStudies/tests/options/caloLayersBenchmark.py
+ */
+
+class CaloLayersBenchmark : public Service {
+public:
+  explicit CaloLayersBenchmark(const std::string& name, ISvcLocator* svcLoc);
+
+  virtual StatusCode initialize();
+  virtual StatusCode finalize();
+  virtual ~CaloLayersBenchmark(){};
+
+private:
+  /// Handle to the geometry service from which the readout is retrieved
+  ServiceHandle<IGeoSvc> m_geoSvc;
+  /// Name of the detector readout
+  Gaudi::Property<std::string> m_readoutName{this, "readoutName", "", "Name of the detector readout"};
+  /// Name of the layer field
+  Gaudi::Property<std::string> m_layerFieldName{this, "layerFieldName", "layer", "Identifier of layers"};
+  /// Name of the active field
+  Gaudi::Property<std::string> m_activeFieldName{this, "activeFieldName", "type", "Identifier of active material"};
+  /// Value of the active material
+  Gaudi::Property<int> m_activeFieldValue{this, "activeFieldValue", 0, "Value of identifier for active material"};
+  /// Name of the cryostat field
+  Gaudi::Property<std::string> m_cryoFieldName{this, "cryoFieldName", "cryo", "Identifier of the cryostat"};
+  /// Name of the field of the cryostat parts
+  Gaudi::Property<std::string> m_typeFieldName{this, "typeFieldName", "type", "Identifier of the cryostat parts"};
+  /// Number of layers
+  Gaudi::Property<unsigned> m_numLayers{this, "numLayers", 8, "Number of layers"};
+  /// Number of hits per event
+  Gaudi::Property<unsigned> m_nHits{this, "nHits", 1000, "Number of hits per event"};
+  /// Number of events
+  Gaudi::Property<unsigned> m_nEvents{this, "nEvents", 100000, "Number of events"};
+  /// Seed of the random cellIDs
+  Gaudi::Property<unsigned> m_seed{this, "seed", 1, "Seed of the random cellIDs"};
+};
+#endif /* DETSTUDIES_CALOLAYERSBENCHMARK_H */
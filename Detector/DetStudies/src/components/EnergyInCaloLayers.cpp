@@ -1,7 +1,10 @@
 #include "EnergyInCaloLayers.h"
+#include "CaloLayerSums.h"
 
 // std
+#include <array>
 #include <cstddef>
+#include <stdexcept>
 #include <podio/UserDataCollection.h>
 
 // DD4hep
@@ -42,6 +45,17 @@ StatusCode EnergyInCaloLayers::initialize() {
     return StatusCode::FAILURE;
   }
 
+  // Resolve the fields once instead of looking them up by name for every hit
+  auto decoder = m_geoSvc->getDetector()->readout(m_readoutName).idSpec().decoder();
+  try {
+    m_cryoField = &(*decoder)["cryo"];
+    m_layerField = &(*decoder)["layer"];
+    m_typeField = &(*decoder)["type"];
+  } catch (const std::runtime_error& e) {
+    error() << "Unable to find the fields in the readout <<" << m_readoutName << ">>: " << e.what() << endmsg;
+    return StatusCode::FAILURE;
+  }
+
   // Check if number of layers matches number of sampling fractions
   if (m_samplingFractions.size() != m_numLayers) {
     error() << "Number of sampling fractions does not match number of calorimeter layers!" << endmsg;
@@ -61,8 +75,6 @@ StatusCode EnergyInCaloLayers::initialize() {
 
 
 StatusCode EnergyInCaloLayers::execute(const EventContext&) const {
-  auto decoder = m_geoSvc->getDetector()->readout(m_readoutName).idSpec().decoder();
-
   // Initialize output variables
   auto* energyInLayerColl = m_energyInLayer.createAndPut();
   energyInLayerColl->vec().assign(m_numLayers, 0.);
@@ -92,23 +104,22 @@ StatusCode EnergyInCaloLayers::execute(const EventContext&) const {
 
   // Get the energy deposited in the calorimeter layers and in the cryostat and its parts
   const auto deposits = m_deposits.get();
-  for (const auto& hit: *deposits) {
-    dd4hep::DDSegmentation::CellID cellID = hit.getCellID();
-    size_t cryoID = decoder->get(cellID, "cryo");
-    if (cryoID == 0) {
-      size_t layerID = decoder->get(cellID, "layer");
-      energyInLayerColl->vec().at(layerID) += hit.getEnergy();
-    } else {
-      size_t cryoTypeID = decoder->get(cellID, "type");
-      energyInCryoColl->vec().at(0) += hit.getEnergy();
-      energyInCryoColl->vec().at(cryoTypeID) += hit.getEnergy();
-    }
+  det::CaloLayerSums sums(m_numLayers);
+  try {
+    sums = det::sumCaloLayers(*deposits, *m_cryoField, *m_layerField, *m_typeField, m_numLayers);
+  } catch (const std::out_of_range& e) {
+    error() << e.what() << endmsg;
+    return StatusCode::FAILURE;
   }
+  std::vector<double>& energyInLayer = sums.layers;
+  const std::array<double, 6>& energyInCryo = sums.cryo;
 
   // Calibrate energy in the calorimeter layers
-  for (size_t i = 0; i < energyInLayerColl->size(); ++i) {
-    energyInLayerColl->vec().at(i) /= m_samplingFractions[i];
+  for (size_t i = 0; i < energyInLayer.size(); ++i) {
+    energyInLayer[i] /= m_samplingFractions[i];
   }
+  energyInLayerColl->vec().assign(energyInLayer.begin(), energyInLayer.end());
+  energyInCryoColl->vec().assign(energyInCryo.begin(), energyInCryo.end());
 
   // Energy deposited in the whole calorimeter
   double energyInCalo = 0.;
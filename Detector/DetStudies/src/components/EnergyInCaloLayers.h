@@ -13,6 +13,12 @@
 #include "edm4hep/MCParticleCollection.h"
 #include "podio/UserDataCollection.h"
 
+// DD4hep
+namespace dd4hep {
+namespace DDSegmentation {
+class BitFieldElement;
+}
+}
 
 /** @class EnergyInCaloLayers EnergyInCaloLayers.h
  *
@@ -23,6 +29,10 @@
  *  detector XML files. Additionally, for the downstream correction, the thickness of the back cryostat needs to be
  *  enlarged to be unrealistically large (at least one meter) to capture all energy deposited behind the calorimeter.
  *
+ *  The fields "cryo", "layer" and "type" are resolved in the readout at initialize, the energy of every event is
+ *  summed by det::sumCaloLayers before the output vectors are filled. Hits outside of the layers or in
+ *  unknown cryostat parts fail the event.
+ *
  *  Based on work done by Anna Zaborowska and Jana Faltova.
  *
  *  @author Juraj Smiesko
@@ -67,6 +77,12 @@ private:
       this, "samplingFractions", {}, "Values of sampling fraction per layer"};
   /// Name of the detector readout
   Gaudi::Property<std::string> m_readoutName{this, "readoutName", "", "Name of the readout"};
+  /// Cryostat field of the readout, resolved at initialize
+  const dd4hep::DDSegmentation::BitFieldElement* m_cryoField = nullptr;
+  /// Layer field of the readout, resolved at initialize
+  const dd4hep::DDSegmentation::BitFieldElement* m_layerField = nullptr;
+  /// Cryostat part field of the readout, resolved at initialize
+  const dd4hep::DDSegmentation::BitFieldElement* m_typeField = nullptr;
 };
 
 #endif /* DETSTUDIES_ENERGYINCALOLAYERS_H */
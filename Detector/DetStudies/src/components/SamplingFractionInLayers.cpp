@@ -1,4 +1,5 @@
 #include "SamplingFractionInLayers.h"
+#include "CaloLayerSums.h"
 
 // FCCSW
 #include "k4Interface/IGeoSvc.h"
@@ -14,6 +15,9 @@
 #include "DD4hep/Detector.h"
 #include "DD4hep/Readout.h"
 
+// STL
+#include <stdexcept>
+
 DECLARE_COMPONENT(SamplingFractionInLayers)
 
 SamplingFractionInLayers::SamplingFractionInLayers(const std::string& aName, ISvcLocator* aSvcLoc)
@@ -36,6 +40,15 @@ StatusCode SamplingFractionInLayers::initialize() {
     error() << "Readout <<" << m_readoutName << ">> does not exist." << endmsg;
     return StatusCode::FAILURE;
   }
+  // resolve the fields once instead of looking them up by name for every hit
+  auto decoder = m_geoSvc->getDetector()->readout(m_readoutName).idSpec().decoder();
+  try {
+    m_layerField = &(*decoder)[m_layerFieldName.value()];
+    m_activeField = &(*decoder)[m_activeFieldName.value()];
+  } catch (const std::runtime_error& e) {
+    error() << "Unable to find the fields in the readout <<" << m_readoutName << ">>: " << e.what() << endmsg;
+    return StatusCode::FAILURE;
+  }
   // create histograms
   for (uint i = 0; i < m_numLayers; i++) {
     m_totalEnLayers.push_back(new TH1F(("ecal_totalEnergy_layer" + std::to_string(i)).c_str(),
@@ -78,30 +91,20 @@ StatusCode SamplingFractionInLayers::initialize() {
 }
 
 StatusCode SamplingFractionInLayers::execute(const EventContext&) const {
-  auto decoder = m_geoSvc->getDetector()->readout(m_readoutName).idSpec().decoder();
-  double sumE = 0.;
-  std::vector<double> sumElayers;
-  double sumEactive = 0.;
-  std::vector<double> sumEactiveLayers;
-  sumElayers.assign(m_numLayers, 0);
-  sumEactiveLayers.assign(m_numLayers, 0);
-
   const auto deposits = m_deposits.get();
-  for (const auto& hit : *deposits) {
-    dd4hep::DDSegmentation::CellID cID = hit.getCellID();
-    auto id = decoder->get(cID, m_layerFieldName);
-    sumElayers[id] += hit.getEnergy();
-    // check if energy was deposited in the calorimeter (active/passive material)
-    if (id >= m_firstLayerId) {
-      sumE += hit.getEnergy();
-      // active material of calorimeter
-      auto activeField = decoder->get(cID, m_activeFieldName);
-      if (activeField == m_activeFieldValue) {
-        sumEactive += hit.getEnergy();
-        sumEactiveLayers[id] += hit.getEnergy();
-      }
-    }
+  det::SamplingLayerSums sums(m_numLayers);
+  try {
+    sums = det::sumSamplingLayers(*deposits, *m_layerField, *m_activeField, m_activeFieldValue, m_numLayers,
+                                  m_firstLayerId);
+  } catch (const std::out_of_range& e) {
+    error() << e.what() << endmsg;
+    return StatusCode::FAILURE;
   }
+  const double sumE = sums.total;
+  const double sumEactive = sums.active;
+  const std::vector<double>& sumElayers = sums.layers;
+  const std::vector<double>& sumEactiveLayers = sums.activeLayers;
+
   // Fill histograms
   m_totalEnergy->Fill(sumE);
   m_totalActiveEnergy->Fill(sumEactive);
@@ -14,6 +14,13 @@ namespace edm4hep {
 class SimCalorimeterHitCollection;
 }
 
+// DD4hep
+namespace dd4hep {
+namespace DDSegmentation {
+class BitFieldElement;
+}
+}
+
 class TH1F;
 class ITHistSvc;
 /** @class SamplingFractionInLayers SamplingFractionInLayers.h
@@ -22,6 +29,8 @@ class ITHistSvc;
  *  Passive material needs to be marked as sensitive. It needs to be divided into layers (cells) as active material.
  *  Sampling fraction is calculated for each layer as the ratio of energy deposited in active material to energy
  *  deposited in the layer (also in passive material).
+ *  The layer and active fields are resolved in the readout at initialize, the energy of every event is summed
+ *  by det::sumSamplingLayers before the histograms are filled. Hits outside of the layers fail the event.
  *
  *  @author Anna Zaborowska
  */
@@ -62,6 +71,10 @@ private:
   Gaudi::Property<uint> m_firstLayerId{this, "firstLayerId", 0, "ID of first layer"};
   /// Name of the detector readout
   Gaudi::Property<std::string> m_readoutName{this, "readoutName", "", "Name of the detector readout"};
+  /// Layer field of the readout, resolved at initialize
+  const dd4hep::DDSegmentation::BitFieldElement* m_layerField = nullptr;
+  /// Active field of the readout, resolved at initialize
+  const dd4hep::DDSegmentation::BitFieldElement* m_activeField = nullptr;
   // Maximum energy for the axis range
   Gaudi::Property<double> m_energy{this, "energyAxis", 500, "Maximum energy for axis range"};
   // Histograms of total deposited energy within layer
@@ -0,0 +1,37 @@
+# Time per event of the energy sums per calorimeter layer of SamplingFractionInLayers and EnergyInCaloLayers,
+# with the fields looked up by name for every hit and with the functions used by the algorithms,
+# which also have to reject hits outside of the layers and in unknown cryostat parts
+import os
+from Gaudi.Configuration import INFO
+
+from Configurables import ApplicationMgr
+ApplicationMgr().EvtSel = 'NONE'
+ApplicationMgr().EvtMax = 1
+ApplicationMgr().OutputLevel = INFO
+
+# DD4hep geometry service
+from Configurables import GeoSvc
+geoservice = GeoSvc("GeoSvc")
+path_to_detectors = os.environ.get("FCCDETECTORS", "")
+detectors_to_use = [
+    'Detector/DetFCChhBaseline1/compact/FCChh_DectEmptyMaster.xml',
+    'Detector/DetFCChhECalInclined/compact/FCChh_ECalBarrel_calibration.xml',
+]
+geoservice.detectors = [os.path.join(path_to_detectors, det)
+                        for det in detectors_to_use]
+geoservice.OutputLevel = INFO
+ApplicationMgr().ExtSvc += [geoservice]
+
+# single-electron events leave about a thousand hits in the barrel
+from Configurables import CaloLayersBenchmark
+benchmark = CaloLayersBenchmark("CaloLayersBenchmark",
+                                readoutName = "ECalBarrelEta",
+                                layerFieldName = "layer",
+                                activeFieldName = "type",
+                                activeFieldValue = 0,
+                                cryoFieldName = "cryo",
+                                typeFieldName = "type",
+                                numLayers = 8,
+                                nHits = 1000,
+                                nEvents = 100000)
+ApplicationMgr().ExtSvc += [benchmark]
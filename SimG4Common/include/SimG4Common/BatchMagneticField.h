@@ -0,0 +1,45 @@
+#ifndef SIMG4COMMON_BATCHMAGNETICFIELD_H
+#define SIMG4COMMON_BATCHMAGNETICFIELD_H
+
+// Geant 4
+#include "G4MagneticField.hh"
+
+// STD
+#include <cstddef>
+
+/** @class sim::BatchMagneticField SimG4Common/SimG4Common/BatchMagneticField.h BatchMagneticField.h
+*
+*  Magnetic field which can be evaluated in many points at once.
+*  Points and results are passed as separate x, y and z arrays (structure of
+*  arrays), as needed by field scanners, validation jobs and fast simulation
+*  propagators. Fields override GetFieldValues with a loop the compiler can
+*  inline, the default implementation calls GetFieldValue point by point.
+*  The evaluation is const, so disjoint ranges of points can be evaluated
+*  concurrently from several threads.
+*/
+
+namespace sim {
+  class BatchMagneticField : public G4MagneticField {
+    public:
+    // Destructor
+    virtual ~BatchMagneticField() {}
+
+    /// Get the value of the magnetic field in several points
+    /// @param[in] n number of points
+    /// @param[in] x, y, z coordinates of the points
+    /// @param[out] bX, bY, bZ components of the field in the points
+    virtual void GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                                double* bX, double* bY, double* bZ) const;
+  };
+
+  /// Get the value of any magnetic field in several points, using the batch
+  /// evaluation if the field provides it
+  /// @param[in] field the evaluated field
+  /// @param[in] n number of points
+  /// @param[in] x, y, z coordinates of the points
+  /// @param[out] bX, bY, bZ components of the field in the points
+  void getFieldValues(const G4MagneticField& field, size_t n, const double* x, const double* y, const double* z,
+                      double* bX, double* bY, double* bZ);
+}
+
+#endif /* SIMG4COMMON_BATCHMAGNETICFIELD_H */
@@ -4,6 +4,9 @@
 // Geant 4
 #include "G4MagneticField.hh"
 
+// k4SimGeant4
+#include "SimG4Common/BatchMagneticField.h"
+
 /** @class sim::ConstantField SimG4Common/SimG4Common/ConstantField.h ConstantField.h
 *
 *  Constant magnetic field inside the cylinder.
@@ -12,7 +15,7 @@
 */
 
 namespace sim {
-class ConstantField : public G4MagneticField {
+class ConstantField : public BatchMagneticField {
 public:
   /// Default constructor
   ConstantField();
@@ -26,6 +29,13 @@ public:
   /// @param[out] bField the return value
   virtual void GetFieldValue(const G4double point[4], double* bField) const final;
 
+  /// Get the value of the magnetic field in several points
+  /// @param[in] n number of points
+  /// @param[in] x, y, z coordinates of the points
+  /// @param[out] bX, bY, bZ components of the field in the points
+  virtual void GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                              double* bX, double* bY, double* bZ) const final;
+
   /// Set the x component of the field
   void setBx(double value) { m_bX = value; }
   /// Set the y component of the field
@@ -0,0 +1,53 @@
+#ifndef SIMG4COMMON_COUNTINGFIELD_H
+#define SIMG4COMMON_COUNTINGFIELD_H
+
+// Geant 4
+#include "G4MagneticField.hh"
+
+// k4SimGeant4
+#include "SimG4Common/BatchMagneticField.h"
+
+// STD
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/** @class sim::CountingField SimG4Common/SimG4Common/CountingField.h CountingField.h
+*
+*  Magnetic field counting the number of evaluations of the wrapped field,
+*  used to benchmark the cost of the field propagation.
+*/
+
+namespace sim {
+  class CountingField : public BatchMagneticField {
+    public:
+    // Constructor
+    /// @param[in] field the counted field (ownership is transferred)
+    explicit CountingField(G4MagneticField* field);
+    // Destructor
+    virtual ~CountingField() {}
+
+    /// Get the value of the magnetic field value at position
+    /// @param[in] point the position where the field is to be returned
+    /// @param[out] bField the return value
+    virtual void GetFieldValue(const G4double point[4], double* bField) const final;
+
+    /// Get the value of the magnetic field in several points
+    /// @param[in] n number of points
+    /// @param[in] x, y, z coordinates of the points
+    /// @param[out] bX, bY, bZ components of the field in the points
+    virtual void GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                                double* bX, double* bY, double* bZ) const final;
+
+    /// Number of field evaluations so far
+    uint64_t calls() const { return m_calls.load(std::memory_order_relaxed); }
+
+  private:
+    /// The counted field
+    std::unique_ptr<G4MagneticField> m_field;
+    /// Number of field evaluations
+    mutable std::atomic<uint64_t> m_calls{0};
+  };
+}
+
+#endif /* SIMG4COMMON_COUNTINGFIELD_H */
@@ -0,0 +1,67 @@
+#ifndef SIMG4COMMON_FIELDCOMPARISON_H
+#define SIMG4COMMON_FIELDCOMPARISON_H
+
+// Geant 4
+#include "G4MagneticField.hh"
+
+// STD
+#include <array>
+#include <cstddef>
+
+/** Comparison of two magnetic fields.
+ *
+ *  Fields are evaluated in the centres of the bins of a regular 3D grid spanning
+ *  the box (the same way MagFieldScanner probes the field) and the maximal and
+ *  RMS difference of every field component is reported. Field values obtained
+ *  in arbitrary points can be compared with FieldDifferenceAccumulator.
+ */
+
+namespace sim {
+  /// Differences between two fields, in Geant4 units
+  struct FieldDifference {
+    /// Number of evaluated points
+    size_t nPoints = 0;
+    /// Maximal absolute difference of Bx, By and Bz
+    std::array<double, 3> maxDiff = {0., 0., 0.};
+    /// RMS of the difference of Bx, By and Bz
+    std::array<double, 3> rmsDiff = {0., 0., 0.};
+    /// Maximal magnitude of the difference vector
+    double maxDiffMag = 0.;
+    /// RMS of the magnitude of the difference vector
+    double rmsDiffMag = 0.;
+  };
+
+  /// Accumulates the differences of field values evaluated in the same points
+  class FieldDifferenceAccumulator {
+    public:
+    /// Add the field values in several points
+    /// @param[in] n number of points
+    /// @param[in] bField components of the field, bField[c][i] is component c in point i
+    /// @param[in] bFieldRef components of the reference field
+    void add(size_t n, const double* const bField[3], const double* const bFieldRef[3]);
+    /// Differences of all points added so far
+    FieldDifference result() const;
+
+    private:
+    /// Differences without the RMS
+    FieldDifference m_difference;
+    /// Sums of the squared differences of Bx, By and Bz
+    std::array<double, 3> m_sumSquares = {0., 0., 0.};
+    /// Sum of the squared magnitudes of the difference vector
+    double m_sumSquaresMag = 0.;
+  };
+
+  /// Compare field to the reference on a regular grid inside the box
+  /// @param[in] field the field to be checked
+  /// @param[in] reference the reference field
+  /// @param[in] boxMin lower corner of the box
+  /// @param[in] boxMax upper corner of the box
+  /// @param[in] nBins number of bins along every axis
+  FieldDifference compareFieldsOnGrid(const G4MagneticField& field,
+                                      const G4MagneticField& reference,
+                                      const std::array<double, 3>& boxMin,
+                                      const std::array<double, 3>& boxMax,
+                                      const std::array<size_t, 3>& nBins);
+}
+
+#endif /* SIMG4COMMON_FIELDCOMPARISON_H */
@@ -0,0 +1,71 @@
+#ifndef SIMG4COMMON_FIELDSETUP_H
+#define SIMG4COMMON_FIELDSETUP_H
+
+// STD
+#include <string>
+
+class G4ChordFinder;
+class G4FieldManager;
+class G4MagIntegratorStepper;
+class G4MagneticField;
+
+/** Construction of the Geant4 field propagation objects shared by the field
+ *  tools and the field region tools.
+ *
+ *  Steppers: ClassicalRK4, NystromRK4, HelixImplicitEuler, HelixSimpleRunge,
+ *  HelixExplicitEuler, ExactHelix, DormandPrince745, BogackiShampine23 and
+ *  BogackiShampine45.
+ *  Integration drivers:
+ *  * MagIntDriver: G4MagInt_Driver, works with every stepper
+ *  * InterpolationDriver: G4InterpolationDriver, uses the dense output of the
+ *    DormandPrince745 stepper to find the chord intersections without new steps
+ *  * FSALDriver: G4FSALIntegrationDriver with the "first same as last" version
+ *    of the DormandPrince745 stepper, saves one field evaluation per step
+ */
+
+namespace sim {
+  /// Parameters of the field propagation, zero leaves the Geant4 default
+  struct FieldPropagationParameters {
+    /// Name of the integration stepper
+    std::string stepper = "NystromRK4";
+    /// Name of the integration driver
+    std::string driver = "MagIntDriver";
+    /// Lower limit of the step size
+    double minStep = 0.;
+    /// Maximal miss distance of the chord
+    double deltaChord = 0.;
+    /// Acceptable position error in an integration step
+    double deltaOneStep = 0.;
+    /// Accuracy of the boundary intersection
+    double deltaIntersection = 0.;
+    /// Minimal relative error of an integration step
+    double minEpsilon = 0.;
+    /// Maximal relative error of an integration step
+    double maxEpsilon = 0.;
+  };
+
+  /// Create the integration stepper of the equation of motion in the magnetic field
+  /// @param[in] name name of the stepper, e.g. "ClassicalRK4", "NystromRK4" or "ExactHelix"
+  /// @param[in] field the magnetic field
+  /// @returns the stepper (ownership is transferred to the caller) or nullptr if the name is not known
+  G4MagIntegratorStepper* createStepper(const std::string& name, G4MagneticField* field);
+
+  /// Create the chord finder with the stepper and the integration driver
+  /// @param[in] field the magnetic field
+  /// @param[in] parameters names of the stepper and driver and the minimal step
+  /// @returns the chord finder (ownership is transferred to the caller)
+  /// @throws std::invalid_argument if the stepper or driver is not known, or they can't be combined
+  G4ChordFinder* createChordFinder(G4MagneticField* field, const FieldPropagationParameters& parameters);
+
+  /// Set the field, a new chord finder and the accuracy parameters of the field manager
+  /// @param[in] fieldManager the configured field manager
+  /// @param[in] field the magnetic field
+  /// @param[in] parameters the propagation parameters
+  /// @returns the chord finder (ownership is transferred to the caller)
+  /// @throws std::invalid_argument if the stepper or driver is not known, or they can't be combined
+  G4ChordFinder* setupFieldManager(G4FieldManager& fieldManager,
+                                   G4MagneticField* field,
+                                   const FieldPropagationParameters& parameters);
+}
+
+#endif /* SIMG4COMMON_FIELDSETUP_H */
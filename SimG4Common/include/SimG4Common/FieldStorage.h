@@ -0,0 +1,93 @@
+#ifndef SIMG4COMMON_FIELDSTORAGE_H
+#define SIMG4COMMON_FIELDSTORAGE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/** Storage types of the field map values.
+ *
+ *  Field maps can keep their nodes as double, float or as 16-bit integers
+ *  quantized with a per-component scale (value = stored * scale).
+ *  Single precision halves, quantization quarters the memory and cache
+ *  footprint of the map.
+ */
+
+namespace sim {
+  /// Identifiers of the supported storage types
+  enum class FieldStorageType : uint32_t { Double = 0, Float = 1, Int16 = 2 };
+
+  template <typename T>
+  struct FieldStorageTraits;
+
+  template <>
+  struct FieldStorageTraits<double> {
+    static constexpr FieldStorageType type = FieldStorageType::Double;
+    static constexpr bool quantized = false;
+  };
+
+  template <>
+  struct FieldStorageTraits<float> {
+    static constexpr FieldStorageType type = FieldStorageType::Float;
+    static constexpr bool quantized = false;
+  };
+
+  template <>
+  struct FieldStorageTraits<int16_t> {
+    static constexpr FieldStorageType type = FieldStorageType::Int16;
+    static constexpr bool quantized = true;
+    static constexpr double maxStored = 32767.;
+  };
+
+  /// Scale needed to store values up to the maximal absolute value
+  template <typename T>
+  double fieldStorageScale(double maxAbsValue) {
+    if constexpr (FieldStorageTraits<T>::quantized) {
+      return maxAbsValue > 0. ? maxAbsValue / FieldStorageTraits<T>::maxStored : 1.;
+    } else {
+      return 1.;
+    }
+  }
+
+  /// Convert the value into the storage type
+  template <typename T>
+  T encodeFieldValue(double value, double scale) {
+    if constexpr (FieldStorageTraits<T>::quantized) {
+      const double maxStored = FieldStorageTraits<T>::maxStored;
+      return static_cast<T>(std::lround(std::clamp(value / scale, -maxStored, maxStored)));
+    } else {
+      return static_cast<T>(value);
+    }
+  }
+
+  /// Size in bytes of one stored value
+  inline size_t fieldStorageSize(FieldStorageType type) {
+    switch (type) {
+      case FieldStorageType::Float:
+        return sizeof(float);
+      case FieldStorageType::Int16:
+        return sizeof(int16_t);
+      default:
+        return sizeof(double);
+    }
+  }
+
+  /// Convert the storage type name ("double", "float" or "int16") into the identifier
+  /// @returns false if the name is not recognized
+  inline bool parseFieldStorageType(const std::string& name, FieldStorageType& type) {
+    if (name == "double") {
+      type = FieldStorageType::Double;
+    } else if (name == "float") {
+      type = FieldStorageType::Float;
+    } else if (name == "int16") {
+      type = FieldStorageType::Int16;
+    } else {
+      return false;
+    }
+    return true;
+  }
+}
+
+#endif /* SIMG4COMMON_FIELDSTORAGE_H */
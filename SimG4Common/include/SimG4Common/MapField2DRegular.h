@@ -3,18 +3,25 @@
 
 // Geant 4
 #include "G4MagneticField.hh"
+
+// k4SimGeant4
+#include "SimG4Common/BatchMagneticField.h"
+#include <cstdint>
 #include <vector>
 
 /** @class sim::MapField2DRegular SimG4Common/SimG4Common/MapField2DRegular.h MapField2DRegular.h
 *
 *  Magnetic field from the COMSOL field map.
 *  The Radially symmetric regularly spaced map is expected.
+*  Field values are stored as StorageT: double, float or int16_t (quantized
+*  with per-component scale), see SimG4Common/FieldStorage.h.
 *
 *  @author Juraj Smiesko
 */
 
 namespace sim {
-  class MapField2DRegular : public G4MagneticField {
+  template <typename StorageT = double>
+  class MapField2DRegular : public BatchMagneticField {
     public:
     // Constructor
     explicit MapField2DRegular(const std::vector<double>& bR,
@@ -29,11 +36,18 @@ namespace sim {
     /// @param[out] bField the return value
     virtual void GetFieldValue(const G4double point[4], double* bField) const final;
 
+    /// Get the value of the magnetic field in several points
+    /// @param[in] n number of points
+    /// @param[in] x, y, z coordinates of the points
+    /// @param[out] bX, bY, bZ components of the field in the points
+    virtual void GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                                double* bX, double* bY, double* bZ) const final;
+
   private:
-    /// Br component of the field
-    std::vector<std::vector<double>> m_fieldR;
-    /// Bz component of the field
-    std::vector<std::vector<double>> m_fieldZ;
+    /// Field nodes, (Br, Bz) pairs with z index running fastest
+    std::vector<StorageT> m_field;
+    /// Scale of the stored values of the field components
+    double m_scale[2] = {1., 1.};
     /// Extend of the field in r direction
     double m_minR, m_maxR, m_widthR;
     /// Extend of the field in z direction
@@ -41,6 +55,10 @@ namespace sim {
     /// Number of datapoints in every direction
     size_t m_nR, m_nZ;
   };
+
+  extern template class MapField2DRegular<double>;
+  extern template class MapField2DRegular<float>;
+  extern template class MapField2DRegular<int16_t>;
 }
 
 #endif /* SIMG4COMMON_MAPFIELD2DREGULAR_H */
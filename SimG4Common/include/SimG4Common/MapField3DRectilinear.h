@@ -0,0 +1,97 @@
+#ifndef SIMG4COMMON_MAPFIELD3DRECTILINEAR_H
+#define SIMG4COMMON_MAPFIELD3DRECTILINEAR_H
+
+// Geant 4
+#include "G4MagneticField.hh"
+
+// k4SimGeant4
+#include "SimG4Common/BatchMagneticField.h"
+
+// STD
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/** @class sim::MapField3DRectilinear SimG4Common/SimG4Common/MapField3DRectilinear.h MapField3DRectilinear.h
+*
+*  Magnetic field from the field map on a rectilinear grid: nodes along every
+*  axis can be spaced non-uniformly, e.g. dense near the coil and sparse outside.
+*  Field is interpolated trilinearly. Field values are stored as StorageT, see
+*  SimG4Common/FieldStorage.h.
+*/
+
+namespace sim {
+  /** Nodes along one axis of the rectilinear grid.
+   *
+   *  Cells are found with a lookup table of uniform bins not wider than the
+   *  smallest cell, so at most one extra comparison is needed. Binary search is
+   *  used if the table would be too large.
+   */
+  class RectilinearAxis {
+    public:
+    RectilinearAxis() = default;
+    /// @param[in] nodes positions of the nodes, sorted in ascending order
+    explicit RectilinearAxis(std::vector<double> nodes);
+
+    /// Positions of the nodes
+    const std::vector<double>& nodes() const { return m_nodes; }
+    /// Find the cell containing the coordinate inside the axis range
+    /// @param[in] x the coordinate
+    /// @param[out] local position inside the cell, from 0 to 1
+    /// @returns index of the lower node of the cell
+    size_t findCell(double x, double& local) const;
+
+  private:
+    /// Positions of the nodes
+    std::vector<double> m_nodes;
+    /// Inverse width of the bins of the lookup table
+    double m_invBinWidth = 0.;
+    /// Cell containing the lower edge of every bin of the lookup table
+    std::vector<uint32_t> m_table;
+  };
+
+  template <typename StorageT = double>
+  class MapField3DRectilinear : public BatchMagneticField {
+    public:
+    // Constructor
+    explicit MapField3DRectilinear(const std::vector<double>& bX,
+                                   const std::vector<double>& bY,
+                                   const std::vector<double>& bZ,
+                                   const std::vector<double>& posX,
+                                   const std::vector<double>& posY,
+                                   const std::vector<double>& posZ);
+    // Destructor
+    virtual ~MapField3DRectilinear() {}
+
+    /// Get the value of the magnetic field value at position
+    /// @param[in] point the position where the field is to be returned
+    /// @param[out] bField the return value
+    virtual void GetFieldValue(const G4double point[4], double* bField) const final;
+
+    /// Get the value of the magnetic field in several points
+    /// @param[in] n number of points
+    /// @param[in] x, y, z coordinates of the points
+    /// @param[out] bX, bY, bZ components of the field in the points
+    virtual void GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                                double* bX, double* bY, double* bZ) const final;
+
+    /// Position of the first node
+    std::array<double, 3> lowerCorner() const;
+    /// Position of the last node
+    std::array<double, 3> upperCorner() const;
+
+  private:
+    /// Nodes along x, y and z
+    std::array<RectilinearAxis, 3> m_axes;
+    /// Field nodes, (Bx, By, Bz) triplets with z index running fastest
+    std::vector<StorageT> m_field;
+    /// Scale of the stored values of the field components
+    double m_scale[3] = {1., 1., 1.};
+  };
+
+  extern template class MapField3DRectilinear<double>;
+  extern template class MapField3DRectilinear<float>;
+  extern template class MapField3DRectilinear<int16_t>;
+}
+
+#endif /* SIMG4COMMON_MAPFIELD3DRECTILINEAR_H */
@@ -3,18 +3,31 @@
 
 // Geant 4
 #include "G4MagneticField.hh"
+
+// k4SimGeant4
+#include "SimG4Common/BatchMagneticField.h"
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
+namespace sim {
+  class SharedFieldMap;
+}
+
 /** @class sim::MapField3DRegular SimG4Common/SimG4Common/MapField3DRegular.h MapField3DRegular.h
 *
 *  Magnetic field from the field map.
 *  Regularly spaced 3D map is expected.
+*  Field values are stored as StorageT: double, float or int16_t (quantized
+*  with per-component scale), see SimG4Common/FieldStorage.h.
 *
 *  @author Juraj Smiesko
 */
 
 namespace sim {
-  class MapField3DRegular : public G4MagneticField {
+  template <typename StorageT = double>
+  class MapField3DRegular : public BatchMagneticField {
     public:
     // Constructor
     explicit MapField3DRegular(const std::vector<double>& bX,
@@ -23,6 +36,17 @@ namespace sim {
                                const std::vector<double>& posX,
                                const std::vector<double>& posY,
                                const std::vector<double>& posZ);
+    /// Constructor of the empty grid, to be filled node by node with setNode
+    /// @param[in] shape number of nodes along x, y and z
+    /// @param[in] lowerCorner position of the first node
+    /// @param[in] upperCorner position of the last node
+    /// @param[in] maxAbsValues maximal absolute values of Bx, By and Bz, needed to quantize them
+    explicit MapField3DRegular(const std::array<size_t, 3>& shape,
+                               const std::array<double, 3>& lowerCorner,
+                               const std::array<double, 3>& upperCorner,
+                               const std::array<double, 3>& maxAbsValues);
+    /// Constructor using the nodes placed in the shared memory segment
+    explicit MapField3DRegular(std::shared_ptr<const SharedFieldMap> sharedMap);
     // Destructor
     virtual ~MapField3DRegular() {}
 
@@ -31,13 +55,42 @@ namespace sim {
     /// @param[out] bField the return value
     virtual void GetFieldValue(const G4double point[4], double* bField) const final;
 
+    /// Get the value of the magnetic field in several points
+    /// @param[in] n number of points
+    /// @param[in] x, y, z coordinates of the points
+    /// @param[out] bX, bY, bZ components of the field in the points
+    virtual void GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                                double* bX, double* bY, double* bZ) const final;
+
+    /// Copy the map into the shared memory segment (segment is not published)
+    /// @param[in] sharedMap segment opened by the producer
+    void writeShared(SharedFieldMap& sharedMap) const;
+
+    /// Number of nodes along x, y and z
+    std::array<size_t, 3> shape() const { return {m_nX, m_nY, m_nZ}; }
+    /// Position of the first node
+    std::array<double, 3> lowerCorner() const { return {m_minX, m_minY, m_minZ}; }
+    /// Position of the last node
+    std::array<double, 3> upperCorner() const { return {m_maxX, m_maxY, m_maxZ}; }
+    /// Set the field in the node of the map created with the empty grid,
+    /// different nodes can be set concurrently
+    /// @param[in] i, j, k indices of the node along x, y and z
+    /// @param[in] bField the field in the node
+    void setNode(size_t i, size_t j, size_t k, const double* bField);
+    /// Field value in the node
+    /// @param[in] i, j, k indices of the node along x, y and z
+    /// @param[out] bField the field in the node
+    void nodeValue(size_t i, size_t j, size_t k, double* bField) const;
+
   private:
-    /// Bx component of the field
-    std::vector<std::vector<std::vector<double>>> m_fieldX;
-    /// By component of the field
-    std::vector<std::vector<std::vector<double>>> m_fieldY;
-    /// Bz component of the field
-    std::vector<std::vector<std::vector<double>>> m_fieldZ;
+    /// Field nodes owned by the map, empty if the map lives in shared memory
+    std::vector<StorageT> m_nodes;
+    /// Shared memory segment holding the field nodes
+    std::shared_ptr<const SharedFieldMap> m_sharedMap;
+    /// Field nodes, (Bx, By, Bz) triplets with z index running fastest
+    const StorageT* m_field = nullptr;
+    /// Scale of the stored values of the field components
+    double m_scale[3] = {1., 1., 1.};
     /// Extend of the field in x direction
     double m_minX, m_maxX, m_widthX;
     /// Extend of the field in y direction
@@ -47,5 +100,9 @@ namespace sim {
     /// Number of datapoints in every direction
     size_t m_nX, m_nY, m_nZ;
   };
+
+  extern template class MapField3DRegular<double>;
+  extern template class MapField3DRegular<float>;
+  extern template class MapField3DRegular<int16_t>;
 }
 #endif /* SIMG4COMMON_MAPFIELD3DREGULAR_H */
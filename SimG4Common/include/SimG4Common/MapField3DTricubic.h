@@ -0,0 +1,67 @@
+#ifndef SIMG4COMMON_MAPFIELD3DTRICUBIC_H
+#define SIMG4COMMON_MAPFIELD3DTRICUBIC_H
+
+// Geant 4
+#include "G4MagneticField.hh"
+
+// k4SimGeant4
+#include "SimG4Common/BatchMagneticField.h"
+#include "SimG4Common/MapField3DRegular.h"
+
+// STD
+#include <array>
+#include <vector>
+
+/** @class sim::MapField3DTricubic SimG4Common/SimG4Common/MapField3DTricubic.h MapField3DTricubic.h
+*
+*  Magnetic field from the regular 3D field map with tricubic interpolation
+*  (F. Lekien, J. Marsden, Int. J. Numer. Meth. Engng 63 (2005) 455).
+*
+*  Unlike the trilinear interpolation the field has continuous first derivatives
+*  across the cell boundaries, which lets the Runge-Kutta steppers take longer
+*  steps. Derivatives in the nodes are estimated with finite differences and the
+*  64 polynomial coefficients of every cell and field component are computed
+*  when the map is loaded, i.e. 192 doubles are kept per cell.
+*/
+
+namespace sim {
+  class MapField3DTricubic : public BatchMagneticField {
+    public:
+    // Constructor
+    /// @param[in] map regular map providing the node values
+    template <typename StorageT>
+    explicit MapField3DTricubic(const MapField3DRegular<StorageT>& map);
+    // Destructor
+    virtual ~MapField3DTricubic() {}
+
+    /// Get the value of the magnetic field value at position
+    /// @param[in] point the position where the field is to be returned
+    /// @param[out] bField the return value
+    virtual void GetFieldValue(const G4double point[4], double* bField) const final;
+
+    /// Get the value of the magnetic field in several points
+    /// @param[in] n number of points
+    /// @param[in] x, y, z coordinates of the points
+    /// @param[out] bX, bY, bZ components of the field in the points
+    virtual void GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                                double* bX, double* bY, double* bZ) const final;
+
+  private:
+    /// Polynomial coefficients, 3 components x 64 coefficients per cell, z index running fastest
+    std::vector<double> m_coefficients;
+    /// Position of the first node
+    std::array<double, 3> m_min;
+    /// Position of the last node
+    std::array<double, 3> m_max;
+    /// Number of cells along every axis
+    std::array<size_t, 3> m_nCells;
+    /// Inverse of the cell size along every axis
+    std::array<double, 3> m_invCellSize;
+  };
+
+  extern template MapField3DTricubic::MapField3DTricubic(const MapField3DRegular<double>&);
+  extern template MapField3DTricubic::MapField3DTricubic(const MapField3DRegular<float>&);
+  extern template MapField3DTricubic::MapField3DTricubic(const MapField3DRegular<int16_t>&);
+}
+
+#endif /* SIMG4COMMON_MAPFIELD3DTRICUBIC_H */
@@ -0,0 +1,110 @@
+#ifndef SIMG4COMMON_MATERIALMAP_H
+#define SIMG4COMMON_MATERIALMAP_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** @class sim::MaterialMap SimG4Common/SimG4Common/MaterialMap.h MaterialMap.h
+*
+*  Lookup table of the material budget seen from the origin, produced by the
+*  material scan (MaterialScan_2D_genericAngle with mapFilename set).
+*
+*  Directions are binned in the polar angle (eta, theta in degrees, theta in
+*  radians or cos(theta)) and in phi in [-pi, pi). For every bin the cumulative
+*  number of radiation lengths X0 and nuclear interaction lengths lambda along
+*  the ray through the bin centre are stored at nRadii checkpoints, spaced
+*  equally in the distance from the origin from 0 to rMax. The material between
+*  two distances is obtained in constant time by interpolating the cumulative
+*  values linearly between the checkpoints.
+*
+*  File format (little endian):
+*    char[8] "k4MATMP1", uint32 angle definition, uint32 nAngleBins,
+*    uint32 nPhiBins, uint32 nRadii, double angleMin, double angleMax,
+*    double rMax (mm), float32 (X0, lambda) for every checkpoint, checkpoints
+*    running fastest, then phi bins, then angle bins.
+*/
+
+namespace sim {
+  class MaterialMap {
+    public:
+    /// Definitions of the polar angle binning, stored in the file
+    enum class AngleDefinition : uint32_t { Eta = 0, Theta = 1, ThetaRad = 2, CosTheta = 3 };
+
+    /// Material budget along the ray
+    struct Budget {
+      /// Number of radiation lengths
+      double nX0 = 0.;
+      /// Number of nuclear interaction lengths
+      double nLambda = 0.;
+    };
+
+    /// Constructor of the empty map, to be filled bin by bin with setBin
+    /// @param[in] angleDefinition definition of the polar angle
+    /// @param[in] nAngleBins, angleMin, angleMax binning in the polar angle
+    /// @param[in] nPhiBins number of bins in phi, in [-pi, pi)
+    /// @param[in] nRadii number of checkpoints along the ray (at least 2)
+    /// @param[in] rMax distance of the last checkpoint from the origin in mm
+    explicit MaterialMap(AngleDefinition angleDefinition, size_t nAngleBins, double angleMin, double angleMax,
+                         size_t nPhiBins, size_t nRadii, double rMax);
+
+    /// Read the map from the file
+    /// @throws std::runtime_error if the file can't be read
+    static MaterialMap read(const std::string& fileName);
+
+    /// Write the map into the file
+    /// @throws std::runtime_error if the file can't be written
+    void write(const std::string& fileName) const;
+
+    /// Set the cumulative material budget of the bin
+    /// @param[in] iAngle, iPhi indices of the bin
+    /// @param[in] nX0, nLambda cumulative values at all checkpoints
+    void setBin(size_t iAngle, size_t iPhi, const double* nX0, const double* nLambda);
+
+    /// Material budget along the direction between two distances from the origin
+    /// @param[in] direction direction of the ray, does not need to be normalized
+    /// @param[in] r1, r2 distances from the origin in mm, clamped to [0, rMax]
+    Budget materialBetween(const std::array<double, 3>& direction, double r1, double r2) const;
+
+    /// Material budget along the direction from the origin to the distance
+    /// @param[in] direction direction of the ray, does not need to be normalized
+    /// @param[in] r distance from the origin in mm, clamped to [0, rMax]
+    Budget materialUpTo(const std::array<double, 3>& direction, double r) const;
+
+    /// Index of the polar angle bin of the direction, clamped to the map
+    size_t angleBin(const std::array<double, 3>& direction) const;
+    /// Index of the phi bin of the direction
+    size_t phiBin(const std::array<double, 3>& direction) const;
+
+    AngleDefinition angleDefinition() const { return m_angleDefinition; }
+    size_t nAngleBins() const { return m_nAngleBins; }
+    size_t nPhiBins() const { return m_nPhiBins; }
+    size_t nRadii() const { return m_nRadii; }
+    double angleMin() const { return m_angleMin; }
+    double angleMax() const { return m_angleMax; }
+    double rMax() const { return m_rMax; }
+
+    private:
+    /// Cumulative budget at the distance within the bin
+    Budget cumulative(size_t iAngle, size_t iPhi, double r) const;
+
+    /// Definition of the polar angle
+    AngleDefinition m_angleDefinition;
+    /// Binning in the polar angle
+    size_t m_nAngleBins;
+    double m_angleMin;
+    double m_angleMax;
+    /// Number of bins in phi
+    size_t m_nPhiBins;
+    /// Number of checkpoints along the ray
+    size_t m_nRadii;
+    /// Distance of the last checkpoint from the origin
+    double m_rMax;
+    /// Cumulative (X0, lambda) pairs, checkpoints running fastest
+    std::vector<float> m_values;
+  };
+}
+
+#endif /* SIMG4COMMON_MATERIALMAP_H */
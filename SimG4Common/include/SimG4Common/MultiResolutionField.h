@@ -0,0 +1,47 @@
+#ifndef SIMG4COMMON_MULTIRESOLUTIONFIELD_H
+#define SIMG4COMMON_MULTIRESOLUTIONFIELD_H
+
+// Geant 4
+#include "G4MagneticField.hh"
+
+// STD
+#include <array>
+#include <memory>
+
+/** @class sim::MultiResolutionField SimG4Common/SimG4Common/MultiResolutionField.h MultiResolutionField.h
+*
+*  Nested field maps: fine inner map is used inside its box, coarse outer map
+*  everywhere else.
+*/
+
+namespace sim {
+  class MultiResolutionField : public G4MagneticField {
+    public:
+    // Constructor
+    /// @param[in] inner the fine field (ownership is transferred)
+    /// @param[in] innerMin lower corner of the box of the inner field
+    /// @param[in] innerMax upper corner of the box of the inner field
+    /// @param[in] outer the coarse field (ownership is transferred)
+    MultiResolutionField(G4MagneticField* inner,
+                         const std::array<double, 3>& innerMin,
+                         const std::array<double, 3>& innerMax,
+                         G4MagneticField* outer);
+    // Destructor
+    virtual ~MultiResolutionField() {}
+
+    /// Get the value of the magnetic field value at position
+    /// @param[in] point the position where the field is to be returned
+    /// @param[out] bField the return value
+    virtual void GetFieldValue(const G4double point[4], double* bField) const final;
+
+  private:
+    /// The fine field
+    std::unique_ptr<G4MagneticField> m_inner;
+    /// Box of the inner field
+    std::array<double, 3> m_innerMin, m_innerMax;
+    /// The coarse field
+    std::unique_ptr<G4MagneticField> m_outer;
+  };
+}
+
+#endif /* SIMG4COMMON_MULTIRESOLUTIONFIELD_H */
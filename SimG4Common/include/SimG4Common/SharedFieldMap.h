@@ -0,0 +1,134 @@
+#ifndef SIMG4COMMON_SHAREDFIELDMAP_H
+#define SIMG4COMMON_SHAREDFIELDMAP_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/** @class sim::SharedFieldMap SimG4Common/SimG4Common/SharedFieldMap.h SharedFieldMap.h
+*
+*  Field map nodes placed in a named POSIX shared memory segment or in a memory
+*  mapped file, so that several simulation processes running on the same node
+*  can use one copy of the map.
+*
+*  The first process which opens the segment becomes its producer, loads the map,
+*  fills the payload and publishes it. All other processes become consumers and
+*  wait until the map is published, after that they map it read-only.
+*  The segment is tagged with a key describing the map configuration (input file,
+*  cuts, ...), attaching to a segment with a different key is refused.
+*
+*  The producer records its process ID in the header as soon as it creates the
+*  segment. A consumer stops waiting once this process does not exist anymore
+*  and removes the segment left behind, so the producer and the consumers have
+*  to share the PID namespace.
+*
+*  Shared memory segments outlive the processes, remove them with
+*  `rm /dev/shm/<name>` once they are not needed anymore.
+*/
+
+namespace sim {
+  class SharedFieldMap {
+    public:
+    /// Where the map is placed
+    enum class Backend { SharedMemory, File };
+    /// Role of this process with respect to the segment
+    enum class Role { Producer, Consumer };
+    /// Publication state of the segment
+    enum State : uint32_t { Empty = 0, Ready = 1, Failed = 2 };
+
+    /// Layout of the segment header, payload follows right after it
+    struct Header {
+      /// Identification of the segment format
+      uint64_t magic;
+      /// Version of the segment format
+      uint32_t version;
+      /// Publication state, written last by the producer
+      std::atomic<uint32_t> state;
+      /// Process ID of the producer, written when the segment is created
+      std::atomic<int32_t> producer;
+      /// Key describing the map configuration
+      uint64_t key;
+      /// Size of the payload in bytes
+      uint64_t payloadSize;
+      /// Map specific shape description (e.g. number of nodes per axis)
+      uint64_t shape[8];
+      /// Map specific parameters (e.g. extent of the map)
+      double params[16];
+    };
+
+    /// Open the segment, creating it if it does not exist yet
+    /// @param[in] name name of the shared memory segment or path of the file
+    /// @param[in] backend shared memory or memory mapped file
+    /// @param[in] key key describing the map configuration
+    static std::shared_ptr<SharedFieldMap> open(const std::string& name, Backend backend, uint64_t key);
+
+    /// Compute the configuration key from its textual description
+    static uint64_t makeKey(const std::string& description);
+
+    // Destructor
+    ~SharedFieldMap();
+
+    SharedFieldMap(const SharedFieldMap&) = delete;
+    SharedFieldMap& operator=(const SharedFieldMap&) = delete;
+
+    /// Role of this process
+    Role role() const { return m_role; }
+    /// Name of the segment
+    const std::string& name() const { return m_name; }
+
+    /// Producer: size the segment and map it writable
+    /// @param[in] payloadSize size of the payload in bytes
+    /// @returns header to be filled before publishing
+    Header& allocate(size_t payloadSize);
+    /// Producer: mark the segment as ready to be used by consumers
+    void publish();
+    /// Producer: mark the segment as unusable and remove it
+    void abandon();
+
+    /// Consumer: wait until the producer publishes the map
+    /// @param[in] timeout maximum waiting time in seconds
+    /// @returns true if the map can be used, false if the producer failed, died or the timeout passed
+    bool waitUntilReady(double timeout);
+
+    /// Header of the mapped segment
+    const Header& header() const { return *m_header; }
+    /// Payload of the mapped segment (writable only for the producer)
+    void* payload();
+    const void* payload() const;
+
+    private:
+    SharedFieldMap(const std::string& name, Backend backend, uint64_t key, int fd, Role role);
+    /// Producer: write the header with the process ID into the new segment
+    void claim();
+    /// Consumer: whether the producer process does not exist anymore
+    bool producerDied() const;
+    /// Whether the name still refers to the segment opened by this process
+    bool isLinked() const;
+    /// Map the whole segment into memory
+    void map(size_t size, bool writable);
+    /// Unmap the segment
+    void unmap();
+    /// Remove the segment
+    void unlink();
+
+    /// Name of the segment
+    std::string m_name;
+    /// Backend used for the segment
+    Backend m_backend;
+    /// Configuration key
+    uint64_t m_key;
+    /// File descriptor of the segment
+    int m_fd;
+    /// Role of this process
+    Role m_role;
+    /// Start of the mapped memory
+    void* m_address = nullptr;
+    /// Size of the mapped memory
+    size_t m_size = 0;
+    /// Header in the mapped memory
+    Header* m_header = nullptr;
+  };
+}
+
+#endif /* SIMG4COMMON_SHAREDFIELDMAP_H */
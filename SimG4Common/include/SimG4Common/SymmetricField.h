@@ -0,0 +1,66 @@
+#ifndef SIMG4COMMON_SYMMETRICFIELD_H
+#define SIMG4COMMON_SYMMETRICFIELD_H
+
+// Geant 4
+#include "G4MagneticField.hh"
+
+// STD
+#include <array>
+#include <memory>
+#include <vector>
+
+/** @class sim::SymmetricField SimG4Common/SimG4Common/SymmetricField.h SymmetricField.h
+*
+*  Magnetic field defined by its values in the fundamental domain only.
+*
+*  Queries outside of the fundamental domain are mapped into it and the field
+*  components are transformed back:
+*   - mirror symmetry along an axis: negative coordinate is reflected and the
+*     field components are multiplied by the parity of the mirror (for the
+*     solenoid: x-mirror (-1, 1, 1), y-mirror (1, -1, 1), z-mirror (-1, -1, 1)),
+*   - N-fold symmetry in phi: the point is rotated into the sector
+*     0 <= phi < 2pi/N and the transverse field is rotated back.
+*  Mirrors are applied first, the phi symmetry last.
+*/
+
+namespace sim {
+  class SymmetricField : public G4MagneticField {
+    public:
+    /// Parities of the field components (Bx, By, Bz)
+    using Parity = std::array<double, 3>;
+
+    // Constructor
+    /// @param[in] field field in the fundamental domain (ownership is transferred)
+    explicit SymmetricField(G4MagneticField* field);
+    // Destructor
+    virtual ~SymmetricField() {}
+
+    /// Add mirror symmetry along the axis
+    /// @param[in] axis 0 for x, 1 for y, 2 for z
+    /// @param[in] parity multiplication factors of the field components in the mirrored half
+    void setMirror(size_t axis, const Parity& parity);
+    /// Set the N-fold rotational symmetry around z axis (N < 2 turns it off)
+    void setPhiSymmetry(unsigned order);
+
+    /// Get the value of the magnetic field value at position
+    /// @param[in] point the position where the field is to be returned
+    /// @param[out] bField the return value
+    virtual void GetFieldValue(const G4double point[4], double* bField) const final;
+
+  private:
+    /// Field in the fundamental domain
+    std::unique_ptr<G4MagneticField> m_field;
+    /// Mirror symmetry turned on along x, y, z
+    std::array<bool, 3> m_mirror = {false, false, false};
+    /// Parities of the field components for every mirror
+    std::array<Parity, 3> m_parity;
+    /// Order of the phi symmetry
+    unsigned m_phiOrder = 1;
+    /// Opening angle of the phi sector
+    double m_sectorAngle;
+    /// Cosine and sine of the rotation to every sector
+    std::vector<double> m_sectorCos, m_sectorSin;
+  };
+}
+
+#endif /* SIMG4COMMON_SYMMETRICFIELD_H */
@@ -0,0 +1,32 @@
+#include "SimG4Common/BatchMagneticField.h"
+
+namespace {
+  /// Evaluate the field point by point
+  void evaluatePointwise(const G4MagneticField& field, size_t n, const double* x, const double* y, const double* z,
+                         double* bX, double* bY, double* bZ) {
+    for (size_t i = 0; i < n; ++i) {
+      const double point[4] = {x[i], y[i], z[i], 0.};
+      double bField[3] = {0., 0., 0.};
+      field.GetFieldValue(point, bField);
+      bX[i] = bField[0];
+      bY[i] = bField[1];
+      bZ[i] = bField[2];
+    }
+  }
+}
+
+namespace sim {
+  void BatchMagneticField::GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                                          double* bX, double* bY, double* bZ) const {
+    evaluatePointwise(*this, n, x, y, z, bX, bY, bZ);
+  }
+
+  void getFieldValues(const G4MagneticField& field, size_t n, const double* x, const double* y, const double* z,
+                      double* bX, double* bY, double* bZ) {
+    if (const auto* batchField = dynamic_cast<const BatchMagneticField*>(&field)) {
+      batchField->GetFieldValues(n, x, y, z, bX, bY, bZ);
+    } else {
+      evaluatePointwise(field, n, x, y, z, bX, bY, bZ);
+    }
+  }
+}
@@ -10,7 +10,7 @@ ConstantField::ConstantField(double bX, double bY, double bZ, double rMax, doubl
     : m_bX(bX), m_bY(bY), m_bZ(bZ), m_rMax(rMax), m_zMax(zMax) {}
 
 void ConstantField::GetFieldValue(const G4double point[4], double* bField) const {
-  if (std::sqrt(point[0] * point[0] + point[1] * point[1]) < m_rMax && std::abs(point[2]) < m_zMax) {
+  if (point[0] * point[0] + point[1] * point[1] < m_rMax * m_rMax && std::abs(point[2]) < m_zMax) {
     bField[0] = m_bX;
     bField[1] = m_bY;
     bField[2] = m_bZ;
@@ -18,4 +18,15 @@ void ConstantField::GetFieldValue(const G4double point[4], double* bField) const
     bField[0] = bField[1] = bField[2] = 0;
   }
 }
+
+void ConstantField::GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                                   double* bX, double* bY, double* bZ) const {
+  const double rMax2 = m_rMax * m_rMax;
+  for (size_t i = 0; i < n; ++i) {
+    const bool inside = x[i] * x[i] + y[i] * y[i] < rMax2 && std::abs(z[i]) < m_zMax;
+    bX[i] = inside ? m_bX : 0.;
+    bY[i] = inside ? m_bY : 0.;
+    bZ[i] = inside ? m_bZ : 0.;
+  }
+}
 }
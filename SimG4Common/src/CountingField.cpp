@@ -0,0 +1,16 @@
+#include "SimG4Common/CountingField.h"
+
+namespace sim {
+  CountingField::CountingField(G4MagneticField* field) : m_field(field) {}
+
+  void CountingField::GetFieldValue(const G4double point[4], double* bField) const {
+    m_calls.fetch_add(1, std::memory_order_relaxed);
+    m_field->GetFieldValue(point, bField);
+  }
+
+  void CountingField::GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                                     double* bX, double* bY, double* bZ) const {
+    m_calls.fetch_add(n, std::memory_order_relaxed);
+    getFieldValues(*m_field, n, x, y, z, bX, bY, bZ);
+  }
+}
@@ -0,0 +1,70 @@
+#include "SimG4Common/FieldComparison.h"
+#include "SimG4Common/BatchMagneticField.h"
+
+// STD
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace sim {
+  FieldDifference compareFieldsOnGrid(const G4MagneticField& field,
+                                      const G4MagneticField& reference,
+                                      const std::array<double, 3>& boxMin,
+                                      const std::array<double, 3>& boxMax,
+                                      const std::array<size_t, 3>& nBins) {
+    std::array<double, 3> binWidth;
+    for (size_t a = 0; a < 3; ++a) {
+      binWidth[a] = (boxMax[a] - boxMin[a]) / nBins[a];
+    }
+
+    FieldDifferenceAccumulator accumulator;
+    // Both fields are evaluated one row along z at a time
+    const size_t nRow = nBins[2];
+    std::vector<double> x(nRow), y(nRow), z(nRow);
+    std::vector<double> bField(3 * nRow), bFieldRef(3 * nRow);
+    const double* const rowField[3] = {&bField[0], &bField[nRow], &bField[2 * nRow]};
+    const double* const rowFieldRef[3] = {&bFieldRef[0], &bFieldRef[nRow], &bFieldRef[2 * nRow]};
+    for (size_t k = 0; k < nRow; ++k) {
+      z[k] = boxMin[2] + (k + 0.5) * binWidth[2];
+    }
+    for (size_t i = 0; i < nBins[0]; ++i) {
+      for (size_t j = 0; j < nBins[1]; ++j) {
+        std::fill(x.begin(), x.end(), boxMin[0] + (i + 0.5) * binWidth[0]);
+        std::fill(y.begin(), y.end(), boxMin[1] + (j + 0.5) * binWidth[1]);
+        getFieldValues(field, nRow, x.data(), y.data(), z.data(),
+                       &bField[0], &bField[nRow], &bField[2 * nRow]);
+        getFieldValues(reference, nRow, x.data(), y.data(), z.data(),
+                       &bFieldRef[0], &bFieldRef[nRow], &bFieldRef[2 * nRow]);
+        accumulator.add(nRow, rowField, rowFieldRef);
+      }
+    }
+
+    return accumulator.result();
+  }
+
+  void FieldDifferenceAccumulator::add(size_t n, const double* const bField[3], const double* const bFieldRef[3]) {
+    for (size_t i = 0; i < n; ++i) {
+      double diffMag2 = 0.;
+      for (size_t c = 0; c < 3; ++c) {
+        const double diff = bField[c][i] - bFieldRef[c][i];
+        m_difference.maxDiff[c] = std::max(m_difference.maxDiff[c], std::fabs(diff));
+        m_sumSquares[c] += diff * diff;
+        diffMag2 += diff * diff;
+      }
+      m_difference.maxDiffMag = std::max(m_difference.maxDiffMag, std::sqrt(diffMag2));
+      m_sumSquaresMag += diffMag2;
+      m_difference.nPoints++;
+    }
+  }
+
+  FieldDifference FieldDifferenceAccumulator::result() const {
+    FieldDifference result = m_difference;
+    if (result.nPoints > 0) {
+      for (size_t c = 0; c < 3; ++c) {
+        result.rmsDiff[c] = std::sqrt(m_sumSquares[c] / result.nPoints);
+      }
+      result.rmsDiffMag = std::sqrt(m_sumSquaresMag / result.nPoints);
+    }
+    return result;
+  }
+}
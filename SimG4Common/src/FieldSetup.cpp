@@ -0,0 +1,90 @@
+#include "SimG4Common/FieldSetup.h"
+
+// Geant 4
+#include "G4BogackiShampine23.hh"
+#include "G4BogackiShampine45.hh"
+#include "G4ChordFinder.hh"
+#include "G4ClassicalRK4.hh"
+#include "G4DormandPrince745.hh"
+#include "G4ExactHelixStepper.hh"
+#include "G4FSALDormandPrince745.hh"
+#include "G4FSALIntegrationDriver.hh"
+#include "G4FieldManager.hh"
+#include "G4HelixExplicitEuler.hh"
+#include "G4HelixImplicitEuler.hh"
+#include "G4HelixSimpleRunge.hh"
+#include "G4InterpolationDriver.hh"
+#include "G4MagIntegratorStepper.hh"
+#include "G4Mag_UsualEqRhs.hh"
+#include "G4MagneticField.hh"
+#include "G4NystromRK4.hh"
+
+// STD
+#include <stdexcept>
+
+namespace sim {
+  G4MagIntegratorStepper* createStepper(const std::string& name, G4MagneticField* field) {
+    if (name == "HelixImplicitEuler") {
+      return new G4HelixImplicitEuler(new G4Mag_UsualEqRhs(field));
+    } else if (name == "HelixSimpleRunge") {
+      return new G4HelixSimpleRunge(new G4Mag_UsualEqRhs(field));
+    } else if (name == "HelixExplicitEuler") {
+      return new G4HelixExplicitEuler(new G4Mag_UsualEqRhs(field));
+    } else if (name == "NystromRK4") {
+      return new G4NystromRK4(new G4Mag_UsualEqRhs(field));
+    } else if (name == "ClassicalRK4") {
+      return new G4ClassicalRK4(new G4Mag_UsualEqRhs(field));
+    } else if (name == "ExactHelix") {
+      return new G4ExactHelixStepper(new G4Mag_UsualEqRhs(field));
+    } else if (name == "DormandPrince745") {
+      return new G4DormandPrince745(new G4Mag_UsualEqRhs(field));
+    } else if (name == "BogackiShampine23") {
+      return new G4BogackiShampine23(new G4Mag_UsualEqRhs(field));
+    } else if (name == "BogackiShampine45") {
+      return new G4BogackiShampine45(new G4Mag_UsualEqRhs(field));
+    }
+    return nullptr;
+  }
+
+  G4ChordFinder* createChordFinder(G4MagneticField* field, const FieldPropagationParameters& parameters) {
+    if (parameters.driver == "MagIntDriver") {
+      G4MagIntegratorStepper* stepper = createStepper(parameters.stepper, field);
+      if (!stepper) {
+        throw std::invalid_argument("Stepper " + parameters.stepper + " not available!");
+      }
+      // G4ChordFinder wraps the stepper into G4MagInt_Driver
+      return new G4ChordFinder(field, parameters.minStep, stepper);
+    }
+
+    // The drivers below are templated on the stepper type
+    if (parameters.stepper != "DormandPrince745") {
+      throw std::invalid_argument("Driver " + parameters.driver + " is available only with the DormandPrince745 stepper!");
+    }
+    if (parameters.driver == "InterpolationDriver") {
+      auto stepper = new G4DormandPrince745(new G4Mag_UsualEqRhs(field));
+      return new G4ChordFinder(new G4InterpolationDriver<G4DormandPrince745>(
+          parameters.minStep, stepper, stepper->GetNumberOfVariables()));
+    } else if (parameters.driver == "FSALDriver") {
+      auto stepper = new G4FSALDormandPrince745(new G4Mag_UsualEqRhs(field));
+      return new G4ChordFinder(new G4FSALIntegrationDriver<G4FSALDormandPrince745>(
+          parameters.minStep, stepper, stepper->GetNumberOfVariables()));
+    }
+    throw std::invalid_argument("Driver " + parameters.driver + " not available!");
+  }
+
+  G4ChordFinder* setupFieldManager(G4FieldManager& fieldManager,
+                                   G4MagneticField* field,
+                                   const FieldPropagationParameters& parameters) {
+    G4ChordFinder* chordFinder = createChordFinder(field, parameters);
+    fieldManager.SetDetectorField(field);
+    fieldManager.SetChordFinder(chordFinder);
+
+    if (parameters.deltaChord > 0) chordFinder->SetDeltaChord(parameters.deltaChord);
+    if (parameters.deltaOneStep > 0) fieldManager.SetDeltaOneStep(parameters.deltaOneStep);
+    if (parameters.deltaIntersection > 0) fieldManager.SetDeltaIntersection(parameters.deltaIntersection);
+    if (parameters.minEpsilon > 0) fieldManager.SetMinimumEpsilonStep(parameters.minEpsilon);
+    if (parameters.maxEpsilon > 0) fieldManager.SetMaximumEpsilonStep(parameters.maxEpsilon);
+
+    return chordFinder;
+  }
+}
@@ -1,4 +1,5 @@
 #include "SimG4Common/MapField2DRegular.h"
+#include "SimG4Common/FieldStorage.h"
 
 // Geant 4
 #include "G4SystemOfUnits.hh"
@@ -14,10 +15,11 @@
 
 
 namespace sim {
-  MapField2DRegular::MapField2DRegular(const std::vector<double>& bR,
-                                       const std::vector<double>& bZ,
-                                       const std::vector<double>& posR,
-                                       const std::vector<double>& posZ) {
+  template <typename StorageT>
+  MapField2DRegular<StorageT>::MapField2DRegular(const std::vector<double>& bR,
+                                                 const std::vector<double>& bZ,
+                                                 const std::vector<double>& posR,
+                                                 const std::vector<double>& posZ) {
     // Finding the extend of the map
     m_maxR = *std::max_element(posR.begin(), posR.end());
     m_minR = *std::min_element(posR.begin(), posR.end());
@@ -65,32 +67,31 @@ namespace sim {
     std::cout << "n pos Z: " << m_nZ << "\n";
     */
 
-    // Preparing the map with all zeroes
-    m_fieldR.resize(m_nR);
-    m_fieldZ.resize(m_nR);
-    for (size_t i = 0; i < m_nR; ++i) {
-      m_fieldR[i].resize(m_nZ, 0.);
-      m_fieldZ[i].resize(m_nZ, 0.);
+    // Scale of the stored values
+    const std::vector<double>* components[2] = {&bR, &bZ};
+    for (size_t c = 0; c < 2; ++c) {
+      double maxAbsValue = 0.;
+      for (double value : *components[c]) {
+        maxAbsValue = std::max(maxAbsValue, std::fabs(value));
+      }
+      m_scale[c] = fieldStorageScale<StorageT>(maxAbsValue);
     }
 
+    // Preparing the map with all zeroes
+    m_field.resize(2 * m_nR * m_nZ, 0);
+
     // Filling the map
     for (size_t index = 0; index < posR.size(); ++index) {
       size_t i = (posR.at(index) - m_minR) * (m_nR - 1) / m_widthR;
       size_t j = (posZ.at(index) - m_minZ) * (m_nZ - 1) / m_widthZ;
-      m_fieldR[i][j] = bR.at(index);
-      m_fieldZ[i][j] = bZ.at(index);
-      /*
-      std::cout << "i, j: " << i << ", " << j << "\n"
-                << "index: " << index << "\n"
-                << "r, z: " << posR.at(index) << ", "
-                            << posZ.at(index) << "\n"
-                << "bR: " << bR.at(index) << "\n"
-                << "bZ: " << bZ.at(index) << "\n";
-      */
+      StorageT* node = &m_field[2 * (i * m_nZ + j)];
+      node[0] = encodeFieldValue<StorageT>(bR.at(index), m_scale[0]);
+      node[1] = encodeFieldValue<StorageT>(bZ.at(index), m_scale[1]);
     }
   }
 
-  void MapField2DRegular::GetFieldValue(const G4double point[4], double* bField) const {
+  template <typename StorageT>
+  void MapField2DRegular<StorageT>::GetFieldValue(const G4double point[4], double* bField) const {
     double x = point[0];
     double y = point[1];
     double z = point[2];
@@ -108,20 +109,39 @@ namespace sim {
       double localR = std::modf(fractionR * (m_nR - 1), &indexRDbl);
       double localZ = std::modf(fractionZ * (m_nZ - 1), &indexZDbl);
 
-      int indexR = static_cast<int>(indexRDbl);
-      int indexZ = static_cast<int>(indexZDbl);
+      size_t indexR = static_cast<size_t>(indexRDbl);
+      size_t indexZ = static_cast<size_t>(indexZDbl);
+
+      // Points on the upper boundary belong to the last cell
+      if (indexR == m_nR - 1) {
+        indexR -= 1;
+        localR = 1.;
+      }
+      if (indexZ == m_nZ - 1) {
+        indexZ -= 1;
+        localZ = 1.;
+      }
+
+      const size_t strideZ = 2;
+      const size_t strideR = 2 * m_nZ;
+      const StorageT* node = &m_field[indexR * strideR + indexZ * strideZ];
 
       double bFieldR =
-        m_fieldR[indexR  ][indexZ  ] * (1-localR) * (1-localZ) +
-        m_fieldR[indexR  ][indexZ+1] * (1-localR) *    localZ  +
-        m_fieldR[indexR+1][indexZ  ] *    localR  * (1-localZ) +
-        m_fieldR[indexR+1][indexZ+1] *    localR  *    localZ;
+        node[0                    ] * (1-localR) * (1-localZ) +
+        node[0           + strideZ] * (1-localR) *    localZ  +
+        node[0 + strideR          ] *    localR  * (1-localZ) +
+        node[0 + strideR + strideZ] *    localR  *    localZ;
 
       double bFieldZ =
-        m_fieldZ[indexR  ][indexZ  ] * (1-localR) * (1-localZ) +
-        m_fieldZ[indexR  ][indexZ+1] * (1-localR) *    localZ  +
-        m_fieldZ[indexR+1][indexZ  ] *    localR  * (1-localZ) +
-        m_fieldZ[indexR+1][indexZ+1] *    localR  *    localZ;
+        node[1                    ] * (1-localR) * (1-localZ) +
+        node[1           + strideZ] * (1-localR) *    localZ  +
+        node[1 + strideR          ] *    localR  * (1-localZ) +
+        node[1 + strideR + strideZ] *    localR  *    localZ;
+
+      if constexpr (FieldStorageTraits<StorageT>::quantized) {
+        bFieldR *= m_scale[0];
+        bFieldZ *= m_scale[1];
+      }
 
       double phi;
       if (x == 0. && y == 0.) {
@@ -140,28 +160,27 @@ namespace sim {
       bField[1] = bFieldR * std::sin(phi);
       bField[2] = bFieldZ;
 
-      /*
-      std::cout << "---------------------------\n";
-      std::cout << "x: " << x << "\n";
-      std::cout << "y: " << y << "\n";
-      std::cout << "z: " << z << "\n";
-      std::cout << "r: " << r << "\n";
-      std::cout << "phi: " << phi << "\n";
-      std::cout << "fractionR: " << fractionR << "\n";
-      std::cout << "fractionZ: " << fractionZ << "\n";
-      std::cout << "Local r,z: " << localR << " " << localZ << "\n";
-      std::cout << "Index r,z: " << indexR << " " << indexZ << "\n";
-      std::cout << "Br, Bz: " << m_fieldR[indexR][indexZ] << " " << m_fieldZ[indexR][indexZ] << "\n";
-      std::cout << "Br+1, Bz: " << m_fieldR[indexR+1][indexZ] << " " << m_fieldZ[indexR+1][indexZ] << "\n";
-      std::cout << "Br, Bz+1: " << m_fieldR[indexR][indexZ+1] << " " << m_fieldZ[indexR][indexZ+1] << "\n";
-      std::cout << "Br+1, Bz+1: " << m_fieldR[indexR+1][indexZ+1] << " " << m_fieldZ[indexR+1][indexZ+1] << "\n";
-      std::cout << "Br, Bz: " << bFieldR << " " << bFieldZ << "\n";
-      std::cout << "Bx, By, Bz: " << bField[0] << ", " << bField[1] << ", " << bField[2] << "\n";
-      */
     } else {
       bField[0] = 0.;
       bField[1] = 0.;
       bField[2] = 0.;
     }
   }
+
+  template <typename StorageT>
+  void MapField2DRegular<StorageT>::GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                                                   double* bX, double* bY, double* bZ) const {
+    for (size_t i = 0; i < n; ++i) {
+      const double point[4] = {x[i], y[i], z[i], 0.};
+      double bField[3];
+      GetFieldValue(point, bField);
+      bX[i] = bField[0];
+      bY[i] = bField[1];
+      bZ[i] = bField[2];
+    }
+  }
+
+  template class MapField2DRegular<double>;
+  template class MapField2DRegular<float>;
+  template class MapField2DRegular<int16_t>;
 }
@@ -0,0 +1,173 @@
+#include "SimG4Common/MapField3DRectilinear.h"
+#include "SimG4Common/FieldStorage.h"
+
+// STD
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+  /// Maximal number of bins of the lookup table of one axis
+  const size_t kMaxTableSize = 1 << 20;
+
+  /// Sorted unique positions of the nodes
+  std::vector<double> uniqueNodes(const std::vector<double>& positions) {
+    std::vector<double> nodes(positions);
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+    return nodes;
+  }
+
+  /// Index of the node at the position
+  size_t nodeIndex(const std::vector<double>& nodes, double position) {
+    return std::lower_bound(nodes.begin(), nodes.end(), position) - nodes.begin();
+  }
+}
+
+namespace sim {
+  RectilinearAxis::RectilinearAxis(std::vector<double> nodes) : m_nodes(std::move(nodes)) {
+    if (m_nodes.size() < 2) {
+      throw std::runtime_error("Rectilinear field map needs at least two nodes along every axis");
+    }
+
+    double minSpacing = m_nodes.back() - m_nodes.front();
+    for (size_t i = 0; i + 1 < m_nodes.size(); ++i) {
+      minSpacing = std::min(minSpacing, m_nodes[i + 1] - m_nodes[i]);
+    }
+    const double nBins = std::ceil((m_nodes.back() - m_nodes.front()) / minSpacing) + 1;
+    if (nBins > kMaxTableSize) {
+      return;
+    }
+
+    m_invBinWidth = 1. / minSpacing;
+    m_table.resize(nBins);
+    for (size_t bin = 0; bin < m_table.size(); ++bin) {
+      const double edge = m_nodes.front() + bin * minSpacing;
+      size_t cell = std::upper_bound(m_nodes.begin(), m_nodes.end(), edge) - m_nodes.begin();
+      cell = cell > 0 ? cell - 1 : 0;
+      m_table[bin] = std::min(cell, m_nodes.size() - 2);
+    }
+  }
+
+  size_t RectilinearAxis::findCell(double x, double& local) const {
+    const size_t lastCell = m_nodes.size() - 2;
+    size_t cell;
+    if (!m_table.empty()) {
+      const size_t bin = std::min<size_t>((x - m_nodes.front()) * m_invBinWidth, m_table.size() - 1);
+      cell = m_table[bin];
+      while (cell < lastCell && x >= m_nodes[cell + 1]) {
+        ++cell;
+      }
+    } else {
+      cell = std::upper_bound(m_nodes.begin(), m_nodes.end(), x) - m_nodes.begin();
+      cell = std::min(cell > 0 ? cell - 1 : 0, lastCell);
+    }
+    local = (x - m_nodes[cell]) / (m_nodes[cell + 1] - m_nodes[cell]);
+    return cell;
+  }
+
+  template <typename StorageT>
+  MapField3DRectilinear<StorageT>::MapField3DRectilinear(const std::vector<double>& bX,
+                                                         const std::vector<double>& bY,
+                                                         const std::vector<double>& bZ,
+                                                         const std::vector<double>& posX,
+                                                         const std::vector<double>& posY,
+                                                         const std::vector<double>& posZ) {
+    const std::vector<double>* positions[3] = {&posX, &posY, &posZ};
+    for (size_t a = 0; a < 3; ++a) {
+      m_axes[a] = RectilinearAxis(uniqueNodes(*positions[a]));
+    }
+    const size_t nY = m_axes[1].nodes().size();
+    const size_t nZ = m_axes[2].nodes().size();
+
+    // Scale of the stored values
+    const std::vector<double>* components[3] = {&bX, &bY, &bZ};
+    for (size_t c = 0; c < 3; ++c) {
+      double maxAbsValue = 0.;
+      for (double value : *components[c]) {
+        maxAbsValue = std::max(maxAbsValue, std::fabs(value));
+      }
+      m_scale[c] = fieldStorageScale<StorageT>(maxAbsValue);
+    }
+
+    // Preparing the map with all zeroes
+    m_field.resize(3 * m_axes[0].nodes().size() * nY * nZ, 0);
+
+    // Filling the map
+    for (size_t index = 0; index < posX.size(); ++index) {
+      const size_t i = nodeIndex(m_axes[0].nodes(), posX[index]);
+      const size_t j = nodeIndex(m_axes[1].nodes(), posY[index]);
+      const size_t k = nodeIndex(m_axes[2].nodes(), posZ[index]);
+      StorageT* node = &m_field[3 * ((i * nY + j) * nZ + k)];
+      for (size_t c = 0; c < 3; ++c) {
+        node[c] = encodeFieldValue<StorageT>((*components[c])[index], m_scale[c]);
+      }
+    }
+  }
+
+  template <typename StorageT>
+  std::array<double, 3> MapField3DRectilinear<StorageT>::lowerCorner() const {
+    return {m_axes[0].nodes().front(), m_axes[1].nodes().front(), m_axes[2].nodes().front()};
+  }
+
+  template <typename StorageT>
+  std::array<double, 3> MapField3DRectilinear<StorageT>::upperCorner() const {
+    return {m_axes[0].nodes().back(), m_axes[1].nodes().back(), m_axes[2].nodes().back()};
+  }
+
+  template <typename StorageT>
+  void MapField3DRectilinear<StorageT>::GetFieldValue(const G4double point[4], double* bField) const {
+    size_t index[3];
+    double local[3];
+    for (size_t a = 0; a < 3; ++a) {
+      const std::vector<double>& nodes = m_axes[a].nodes();
+      if (!(point[a] >= nodes.front() && point[a] <= nodes.back())) {
+        bField[0] = 0.;
+        bField[1] = 0.;
+        bField[2] = 0.;
+        return;
+      }
+      index[a] = m_axes[a].findCell(point[a], local[a]);
+    }
+
+    const size_t strideZ = 3;
+    const size_t strideY = 3 * m_axes[2].nodes().size();
+    const size_t strideX = strideY * m_axes[1].nodes().size();
+    const StorageT* node = &m_field[index[0] * strideX + index[1] * strideY + index[2] * strideZ];
+    const double localX = local[0];
+    const double localY = local[1];
+    const double localZ = local[2];
+
+    for (size_t c = 0; c < 3; ++c) {
+      bField[c] =
+        node[c                              ] * (1-localX) * (1-localY) * (1-localZ) +
+        node[c                     + strideZ] * (1-localX) * (1-localY) *    localZ  +
+        node[c           + strideY          ] * (1-localX) *    localY  * (1-localZ) +
+        node[c           + strideY + strideZ] * (1-localX) *    localY  *    localZ  +
+        node[c + strideX                    ] *    localX  * (1-localY) * (1-localZ) +
+        node[c + strideX           + strideZ] *    localX  * (1-localY) *    localZ  +
+        node[c + strideX + strideY          ] *    localX  *    localY  * (1-localZ) +
+        node[c + strideX + strideY + strideZ] *    localX  *    localY  *    localZ;
+      if constexpr (FieldStorageTraits<StorageT>::quantized) {
+        bField[c] *= m_scale[c];
+      }
+    }
+  }
+
+  template <typename StorageT>
+  void MapField3DRectilinear<StorageT>::GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                                                       double* bX, double* bY, double* bZ) const {
+    for (size_t i = 0; i < n; ++i) {
+      const double point[4] = {x[i], y[i], z[i], 0.};
+      double bField[3];
+      GetFieldValue(point, bField);
+      bX[i] = bField[0];
+      bY[i] = bField[1];
+      bZ[i] = bField[2];
+    }
+  }
+
+  template class MapField3DRectilinear<double>;
+  template class MapField3DRectilinear<float>;
+  template class MapField3DRectilinear<int16_t>;
+}
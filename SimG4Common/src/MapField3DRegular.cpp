@@ -1,8 +1,11 @@
 #include "SimG4Common/MapField3DRegular.h"
+#include "SimG4Common/FieldStorage.h"
+#include "SimG4Common/SharedFieldMap.h"
 
 // Geant 4
 #include "G4SystemOfUnits.hh"
 #include <algorithm>
+#include <stdexcept>
 
 /**
  * Field map loaded from 6 std::vectors.
@@ -14,12 +17,13 @@
 
 
 namespace sim {
-  MapField3DRegular::MapField3DRegular(const std::vector<double>& bX,
-                                       const std::vector<double>& bY,
-                                       const std::vector<double>& bZ,
-                                       const std::vector<double>& posX,
-                                       const std::vector<double>& posY,
-                                       const std::vector<double>& posZ) {
+  template <typename StorageT>
+  MapField3DRegular<StorageT>::MapField3DRegular(const std::vector<double>& bX,
+                                                 const std::vector<double>& bY,
+                                                 const std::vector<double>& bZ,
+                                                 const std::vector<double>& posX,
+                                                 const std::vector<double>& posY,
+                                                 const std::vector<double>& posZ) {
     // Finding the extend of the map
     m_maxX = *std::max_element(posX.begin(), posX.end());
     m_minX = *std::min_element(posX.begin(), posX.end());
@@ -85,43 +89,118 @@ namespace sim {
     std::cout << "n pos Z: " << m_nZ << "\n";
     */
 
-    // Preparing the map with all zeroes
-    m_fieldX.resize(m_nX);
-    m_fieldY.resize(m_nX);
-    m_fieldZ.resize(m_nX);
-    for (size_t i = 0; i < m_nX; ++i) {
-      m_fieldX[i].resize(m_nY);
-      m_fieldY[i].resize(m_nY);
-      m_fieldZ[i].resize(m_nY);
-      for (size_t j = 0; j < m_nY; ++j) {
-        m_fieldX[i][j].resize(m_nZ, 0.);
-        m_fieldY[i][j].resize(m_nZ, 0.);
-        m_fieldZ[i][j].resize(m_nZ, 0.);
+    // Scale of the stored values
+    const std::vector<double>* components[3] = {&bX, &bY, &bZ};
+    for (size_t c = 0; c < 3; ++c) {
+      double maxAbsValue = 0.;
+      for (double value : *components[c]) {
+        maxAbsValue = std::max(maxAbsValue, std::fabs(value));
       }
+      m_scale[c] = fieldStorageScale<StorageT>(maxAbsValue);
     }
 
+    // Preparing the map with all zeroes
+    m_nodes.resize(3 * m_nX * m_nY * m_nZ, 0);
+
     // Filling the map
     for (size_t index = 0; index < posX.size(); ++index) {
       size_t i = (posX.at(index) - m_minX) * (m_nX - 1) / m_widthX;
       size_t j = (posY.at(index) - m_minY) * (m_nY - 1) / m_widthY;
       size_t k = (posZ.at(index) - m_minZ) * (m_nZ - 1) / m_widthZ;
-      m_fieldX[i][j][k] = bX.at(index);
-      m_fieldY[i][j][k] = bY.at(index);
-      m_fieldZ[i][j][k] = bZ.at(index);
-      /*
-      std::cout << "i, j, k: " << i << ", " << j << ", " << k << "\n"
-                << "index: " << index << "\n"
-                << "x, y, z: " << posX.at(index) << ", "
-                               << posY.at(index) << ", "
-                               << posZ.at(index) << "\n"
-                << "bX: " << bX.at(index) << "\n"
-                << "bY: " << bY.at(index) << "\n"
-                << "bZ: " << bZ.at(index) << "\n";
-      */
+      StorageT* node = &m_nodes[3 * ((i * m_nY + j) * m_nZ + k)];
+      node[0] = encodeFieldValue<StorageT>(bX.at(index), m_scale[0]);
+      node[1] = encodeFieldValue<StorageT>(bY.at(index), m_scale[1]);
+      node[2] = encodeFieldValue<StorageT>(bZ.at(index), m_scale[2]);
+    }
+    m_field = m_nodes.data();
+  }
+
+  template <typename StorageT>
+  MapField3DRegular<StorageT>::MapField3DRegular(const std::array<size_t, 3>& shape,
+                                                 const std::array<double, 3>& lowerCorner,
+                                                 const std::array<double, 3>& upperCorner,
+                                                 const std::array<double, 3>& maxAbsValues)
+      : m_minX(lowerCorner[0]), m_maxX(upperCorner[0]), m_widthX(upperCorner[0] - lowerCorner[0]),
+        m_minY(lowerCorner[1]), m_maxY(upperCorner[1]), m_widthY(upperCorner[1] - lowerCorner[1]),
+        m_minZ(lowerCorner[2]), m_maxZ(upperCorner[2]), m_widthZ(upperCorner[2] - lowerCorner[2]),
+        m_nX(shape[0]), m_nY(shape[1]), m_nZ(shape[2]) {
+    for (size_t c = 0; c < 3; ++c) {
+      m_scale[c] = fieldStorageScale<StorageT>(maxAbsValues[c]);
+    }
+    m_nodes.resize(3 * m_nX * m_nY * m_nZ, 0);
+    m_field = m_nodes.data();
+  }
+
+  template <typename StorageT>
+  MapField3DRegular<StorageT>::MapField3DRegular(std::shared_ptr<const SharedFieldMap> sharedMap)
+      : m_sharedMap(std::move(sharedMap)) {
+    const SharedFieldMap::Header& header = m_sharedMap->header();
+    m_nX = header.shape[0];
+    m_nY = header.shape[1];
+    m_nZ = header.shape[2];
+    m_minX = header.params[0];
+    m_maxX = header.params[1];
+    m_minY = header.params[2];
+    m_maxY = header.params[3];
+    m_minZ = header.params[4];
+    m_maxZ = header.params[5];
+    m_widthX = m_maxX - m_minX;
+    m_widthY = m_maxY - m_minY;
+    m_widthZ = m_maxZ - m_minZ;
+    m_scale[0] = header.params[6];
+    m_scale[1] = header.params[7];
+    m_scale[2] = header.params[8];
+
+    if (header.shape[3] != static_cast<uint64_t>(FieldStorageTraits<StorageT>::type)) {
+      throw std::runtime_error("Shared field map '" + m_sharedMap->name() + "' has different storage type");
+    }
+    if (header.payloadSize != 3 * m_nX * m_nY * m_nZ * sizeof(StorageT)) {
+      throw std::runtime_error("Shared field map '" + m_sharedMap->name() + "' has unexpected size");
+    }
+    m_field = static_cast<const StorageT*>(m_sharedMap->payload());
+  }
+
+  template <typename StorageT>
+  void MapField3DRegular<StorageT>::writeShared(SharedFieldMap& sharedMap) const {
+    const size_t nValues = 3 * m_nX * m_nY * m_nZ;
+    SharedFieldMap::Header& header = sharedMap.allocate(nValues * sizeof(StorageT));
+    header.shape[0] = m_nX;
+    header.shape[1] = m_nY;
+    header.shape[2] = m_nZ;
+    header.shape[3] = static_cast<uint64_t>(FieldStorageTraits<StorageT>::type);
+    header.params[0] = m_minX;
+    header.params[1] = m_maxX;
+    header.params[2] = m_minY;
+    header.params[3] = m_maxY;
+    header.params[4] = m_minZ;
+    header.params[5] = m_maxZ;
+    header.params[6] = m_scale[0];
+    header.params[7] = m_scale[1];
+    header.params[8] = m_scale[2];
+    std::copy(m_field, m_field + nValues, static_cast<StorageT*>(sharedMap.payload()));
+  }
+
+  template <typename StorageT>
+  void MapField3DRegular<StorageT>::setNode(size_t i, size_t j, size_t k, const double* bField) {
+    StorageT* node = &m_nodes[3 * ((i * m_nY + j) * m_nZ + k)];
+    for (size_t c = 0; c < 3; ++c) {
+      node[c] = encodeFieldValue<StorageT>(bField[c], m_scale[c]);
     }
   }
 
-  void MapField3DRegular::GetFieldValue(const G4double point[4], double* bField) const {
+  template <typename StorageT>
+  void MapField3DRegular<StorageT>::nodeValue(size_t i, size_t j, size_t k, double* bField) const {
+    const StorageT* node = m_field + 3 * ((i * m_nY + j) * m_nZ + k);
+    for (size_t c = 0; c < 3; ++c) {
+      bField[c] = node[c];
+      if constexpr (FieldStorageTraits<StorageT>::quantized) {
+        bField[c] *= m_scale[c];
+      }
+    }
+  }
+
+  template <typename StorageT>
+  void MapField3DRegular<StorageT>::GetFieldValue(const G4double point[4], double* bField) const {
     double x = point[0];
     double y = point[1];
     double z = point[2];
@@ -139,58 +218,43 @@ namespace sim {
       double localY = std::modf(fractionY * (m_nY - 1), &indexYDbl);
       double localZ = std::modf(fractionZ * (m_nZ - 1), &indexZDbl);
 
-      int indexX = static_cast<int>(indexXDbl);
-      int indexY = static_cast<int>(indexYDbl);
-      int indexZ = static_cast<int>(indexZDbl);
-
-      /*
-      std::cout << "---------------------------\n";
-      std::cout << "x: " << x << "\n";
-      std::cout << "y: " << y << "\n";
-      std::cout << "z: " << z << "\n";
-      std::cout << "fractionX: " << fractionX << "\n";
-      std::cout << "fractionY: " << fractionY << "\n";
-      std::cout << "fractionZ: " << fractionZ << "\n";
-      std::cout << "Local x,y,z: " << localX << " " << localY << " " << localZ << "\n";
-      std::cout << "Index x,y,z: " << indexX << " " << indexY << " " << indexZ << "\n";
-      std::cout << "Bx, By, Bz: " << m_fieldX[indexX][indexY][indexZ] << " " << m_fieldY[indexX][indexY][indexZ] << " " << m_fieldZ[indexX][indexY][indexZ] << "\n";
-      std::cout << "Bx, By, Bz (x+1): " << m_fieldX[indexX+1][indexY][indexZ] << " " << m_fieldY[indexX+1][indexY][indexZ] << " " << m_fieldZ[indexX+1][indexY][indexZ] << "\n";
-      std::cout << "Bx, By, Bz (y+1): " << m_fieldX[indexX][indexY+1][indexZ] << " " << m_fieldY[indexX][indexY+1][indexZ] << " " << m_fieldZ[indexX][indexY+1][indexZ] << "\n";
-      std::cout << "Bx, By, Bz (z+1): " << m_fieldX[indexX][indexY][indexZ+1] << " " << m_fieldY[indexX][indexY][indexZ+1] << " " << m_fieldZ[indexX][indexY][indexZ+1] << "\n";
-      std::cout << "Bx, By, Bz (all+1): " << m_fieldX[indexX+1][indexY+1][indexZ+1] << " " << m_fieldY[indexX+1][indexY+1][indexZ+1] << " " << m_fieldZ[indexX+1][indexY+1][indexZ+1] << "\n";
-      */
-
-      bField[0] =
-        m_fieldX[indexX  ][indexY  ][indexZ  ] * (1-localX) * (1-localY) * (1-localZ) +
-        m_fieldX[indexX  ][indexY  ][indexZ+1] * (1-localX) * (1-localY) *    localZ  +
-        m_fieldX[indexX  ][indexY+1][indexZ  ] * (1-localX) *    localY  * (1-localZ) +
-        m_fieldX[indexX  ][indexY+1][indexZ+1] * (1-localX) *    localY  *    localZ  +
-        m_fieldX[indexX+1][indexY  ][indexZ  ] *    localX  * (1-localY) * (1-localZ) +
-        m_fieldX[indexX+1][indexY  ][indexZ+1] *    localX  * (1-localY) *    localZ  +
-        m_fieldX[indexX+1][indexY+1][indexZ  ] *    localX  *    localY  * (1-localZ) +
-        m_fieldX[indexX+1][indexY+1][indexZ+1] *    localX  *    localY  *    localZ;
-
-      bField[1] =
-        m_fieldY[indexX  ][indexY  ][indexZ  ] * (1-localX) * (1-localY) * (1-localZ) +
-        m_fieldY[indexX  ][indexY  ][indexZ+1] * (1-localX) * (1-localY) *    localZ  +
-        m_fieldY[indexX  ][indexY+1][indexZ  ] * (1-localX) *    localY  * (1-localZ) +
-        m_fieldY[indexX  ][indexY+1][indexZ+1] * (1-localX) *    localY  *    localZ  +
-        m_fieldY[indexX+1][indexY  ][indexZ  ] *    localX  * (1-localY) * (1-localZ) +
-        m_fieldY[indexX+1][indexY  ][indexZ+1] *    localX  * (1-localY) *    localZ  +
-        m_fieldY[indexX+1][indexY+1][indexZ  ] *    localX  *    localY  * (1-localZ) +
-        m_fieldY[indexX+1][indexY+1][indexZ+1] *    localX  *    localY  *    localZ;
-
-      bField[2] =
-        m_fieldZ[indexX  ][indexY  ][indexZ  ] * (1-localX) * (1-localY) * (1-localZ) +
-        m_fieldZ[indexX  ][indexY  ][indexZ+1] * (1-localX) * (1-localY) *    localZ  +
-        m_fieldZ[indexX  ][indexY+1][indexZ  ] * (1-localX) *    localY  * (1-localZ) +
-        m_fieldZ[indexX  ][indexY+1][indexZ+1] * (1-localX) *    localY  *    localZ  +
-        m_fieldZ[indexX+1][indexY  ][indexZ  ] *    localX  * (1-localY) * (1-localZ) +
-        m_fieldZ[indexX+1][indexY  ][indexZ+1] *    localX  * (1-localY) *    localZ  +
-        m_fieldZ[indexX+1][indexY+1][indexZ  ] *    localX  *    localY  * (1-localZ) +
-        m_fieldZ[indexX+1][indexY+1][indexZ+1] *    localX  *    localY  *    localZ;
-
-      // std::cout << "Bx, By, Bz: " << bField[0] << " " << bField[1] << " " << bField[2] << "\n";
+      size_t indexX = static_cast<size_t>(indexXDbl);
+      size_t indexY = static_cast<size_t>(indexYDbl);
+      size_t indexZ = static_cast<size_t>(indexZDbl);
+
+      // Points on the upper boundary belong to the last cell
+      if (indexX == m_nX - 1) {
+        indexX -= 1;
+        localX = 1.;
+      }
+      if (indexY == m_nY - 1) {
+        indexY -= 1;
+        localY = 1.;
+      }
+      if (indexZ == m_nZ - 1) {
+        indexZ -= 1;
+        localZ = 1.;
+      }
+
+      const size_t strideZ = 3;
+      const size_t strideY = 3 * m_nZ;
+      const size_t strideX = 3 * m_nY * m_nZ;
+      const StorageT* node = m_field + indexX * strideX + indexY * strideY + indexZ * strideZ;
+
+      for (size_t c = 0; c < 3; ++c) {
+        bField[c] =
+          node[c                              ] * (1-localX) * (1-localY) * (1-localZ) +
+          node[c                     + strideZ] * (1-localX) * (1-localY) *    localZ  +
+          node[c           + strideY          ] * (1-localX) *    localY  * (1-localZ) +
+          node[c           + strideY + strideZ] * (1-localX) *    localY  *    localZ  +
+          node[c + strideX                    ] *    localX  * (1-localY) * (1-localZ) +
+          node[c + strideX           + strideZ] *    localX  * (1-localY) *    localZ  +
+          node[c + strideX + strideY          ] *    localX  *    localY  * (1-localZ) +
+          node[c + strideX + strideY + strideZ] *    localX  *    localY  *    localZ;
+        if constexpr (FieldStorageTraits<StorageT>::quantized) {
+          bField[c] *= m_scale[c];
+        }
+      }
 
     } else {
       bField[0] = 0.;
@@ -198,4 +262,22 @@ namespace sim {
       bField[2] = 0.;
     }
   }
+
+  template <typename StorageT>
+  void MapField3DRegular<StorageT>::GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                                                   double* bX, double* bY, double* bZ) const {
+    // GetFieldValue is final, the call is resolved statically and inlined into the loop
+    for (size_t i = 0; i < n; ++i) {
+      const double point[4] = {x[i], y[i], z[i], 0.};
+      double bField[3];
+      GetFieldValue(point, bField);
+      bX[i] = bField[0];
+      bY[i] = bField[1];
+      bZ[i] = bField[2];
+    }
+  }
+
+  template class MapField3DRegular<double>;
+  template class MapField3DRegular<float>;
+  template class MapField3DRegular<int16_t>;
 }
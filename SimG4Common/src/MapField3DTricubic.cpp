@@ -0,0 +1,157 @@
+#include "SimG4Common/MapField3DTricubic.h"
+
+// STD
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+  /// Hermite basis: coefficients of the cubic polynomial from (f(0), f(1), f'(0), f'(1))
+  const double kHermite[4][4] = {{1., 0., 0., 0.},
+                                 {0., 0., 1., 0.},
+                                 {-3., 3., -2., -1.},
+                                 {2., -2., 1., 1.}};
+}
+
+namespace sim {
+  template <typename StorageT>
+  MapField3DTricubic::MapField3DTricubic(const MapField3DRegular<StorageT>& map)
+      : m_min(map.lowerCorner()), m_max(map.upperCorner()) {
+    const std::array<size_t, 3> nNodes = map.shape();
+    for (size_t a = 0; a < 3; ++a) {
+      if (nNodes[a] < 2) {
+        throw std::runtime_error("Tricubic interpolation needs at least two nodes along every axis");
+      }
+      m_nCells[a] = nNodes[a] - 1;
+      m_invCellSize[a] = m_nCells[a] / (m_max[a] - m_min[a]);
+    }
+    const size_t strides[3] = {3 * nNodes[1] * nNodes[2], 3 * nNodes[2], 3};
+    const size_t nValues = 3 * nNodes[0] * nNodes[1] * nNodes[2];
+
+    // Field and its derivatives (in units of the cell size) in the nodes,
+    // bits 0, 1, 2 of the index select derivative along x, y, z
+    std::array<std::vector<double>, 8> derivatives;
+    derivatives[0].resize(nValues);
+    for (size_t i = 0; i < nNodes[0]; ++i) {
+      for (size_t j = 0; j < nNodes[1]; ++j) {
+        for (size_t k = 0; k < nNodes[2]; ++k) {
+          map.nodeValue(i, j, k, &derivatives[0][i * strides[0] + j * strides[1] + k * strides[2]]);
+        }
+      }
+    }
+    for (size_t mask = 1; mask < 8; ++mask) {
+      // Differentiate the already known lower derivative along the highest axis of the mask
+      const size_t axis = mask >= 4 ? 2 : (mask >= 2 ? 1 : 0);
+      const std::vector<double>& source = derivatives[mask & ~(1u << axis)];
+      std::vector<double>& target = derivatives[mask];
+      target.resize(nValues);
+      for (size_t index = 0; index < nValues; ++index) {
+        const size_t node = (index / strides[axis]) % nNodes[axis];
+        const size_t stride = strides[axis];
+        if (node == 0) {
+          target[index] = source[index + stride] - source[index];
+        } else if (node == nNodes[axis] - 1) {
+          target[index] = source[index] - source[index - stride];
+        } else {
+          target[index] = 0.5 * (source[index + stride] - source[index - stride]);
+        }
+      }
+    }
+
+    // Coefficients of every cell: Kronecker product of the 1D Hermite bases
+    m_coefficients.resize(m_nCells[0] * m_nCells[1] * m_nCells[2] * 3 * 64);
+    double* coefficients = m_coefficients.data();
+    for (size_t i = 0; i < m_nCells[0]; ++i) {
+      for (size_t j = 0; j < m_nCells[1]; ++j) {
+        for (size_t k = 0; k < m_nCells[2]; ++k) {
+          const size_t corner = i * strides[0] + j * strides[1] + k * strides[2];
+          for (size_t c = 0; c < 3; ++c, coefficients += 64) {
+            // Corner values: index p = 2 * derivative + corner along every axis
+            double values[4][4][4];
+            for (size_t p = 0; p < 4; ++p) {
+              for (size_t q = 0; q < 4; ++q) {
+                for (size_t r = 0; r < 4; ++r) {
+                  const size_t mask = (p >> 1) | ((q >> 1) << 1) | ((r >> 1) << 2);
+                  const size_t node = corner + (p & 1) * strides[0] + (q & 1) * strides[1] + (r & 1) * strides[2];
+                  values[p][q][r] = derivatives[mask][node + c];
+                }
+              }
+            }
+            double tmpX[4][4][4] = {};
+            double tmpY[4][4][4] = {};
+            for (size_t l = 0; l < 4; ++l)
+              for (size_t p = 0; p < 4; ++p)
+                for (size_t q = 0; q < 4; ++q)
+                  for (size_t r = 0; r < 4; ++r)
+                    tmpX[l][q][r] += kHermite[l][p] * values[p][q][r];
+            for (size_t l = 0; l < 4; ++l)
+              for (size_t m = 0; m < 4; ++m)
+                for (size_t q = 0; q < 4; ++q)
+                  for (size_t r = 0; r < 4; ++r)
+                    tmpY[l][m][r] += kHermite[m][q] * tmpX[l][q][r];
+            for (size_t l = 0; l < 4; ++l)
+              for (size_t m = 0; m < 4; ++m)
+                for (size_t n = 0; n < 4; ++n) {
+                  double sum = 0.;
+                  for (size_t r = 0; r < 4; ++r) {
+                    sum += kHermite[n][r] * tmpY[l][m][r];
+                  }
+                  coefficients[16 * l + 4 * m + n] = sum;
+                }
+          }
+        }
+      }
+    }
+  }
+
+  void MapField3DTricubic::GetFieldValue(const G4double point[4], double* bField) const {
+    size_t cell[3];
+    double local[3];
+    for (size_t a = 0; a < 3; ++a) {
+      if (!(point[a] >= m_min[a] && point[a] <= m_max[a])) {
+        bField[0] = 0.;
+        bField[1] = 0.;
+        bField[2] = 0.;
+        return;
+      }
+      double indexDbl;
+      local[a] = std::modf((point[a] - m_min[a]) * m_invCellSize[a], &indexDbl);
+      cell[a] = static_cast<size_t>(indexDbl);
+      // Points on the upper boundary belong to the last cell
+      if (cell[a] >= m_nCells[a]) {
+        cell[a] = m_nCells[a] - 1;
+        local[a] = 1.;
+      }
+    }
+
+    const double* coefficients =
+        &m_coefficients[((cell[0] * m_nCells[1] + cell[1]) * m_nCells[2] + cell[2]) * 3 * 64];
+    for (size_t c = 0; c < 3; ++c, coefficients += 64) {
+      double value = 0.;
+      for (int l = 3; l >= 0; --l) {
+        double valueY = 0.;
+        for (int m = 3; m >= 0; --m) {
+          const double* a = coefficients + 16 * l + 4 * m;
+          valueY = valueY * local[1] + (((a[3] * local[2] + a[2]) * local[2] + a[1]) * local[2] + a[0]);
+        }
+        value = value * local[0] + valueY;
+      }
+      bField[c] = value;
+    }
+  }
+
+  void MapField3DTricubic::GetFieldValues(size_t n, const double* x, const double* y, const double* z,
+                                          double* bX, double* bY, double* bZ) const {
+    for (size_t i = 0; i < n; ++i) {
+      const double point[4] = {x[i], y[i], z[i], 0.};
+      double bField[3];
+      GetFieldValue(point, bField);
+      bX[i] = bField[0];
+      bY[i] = bField[1];
+      bZ[i] = bField[2];
+    }
+  }
+
+  template MapField3DTricubic::MapField3DTricubic(const MapField3DRegular<double>&);
+  template MapField3DTricubic::MapField3DTricubic(const MapField3DRegular<float>&);
+  template MapField3DTricubic::MapField3DTricubic(const MapField3DRegular<int16_t>&);
+}
@@ -0,0 +1,154 @@
+#include "SimG4Common/MaterialMap.h"
+
+// STD
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+  const char kMagic[8] = {'k', '4', 'M', 'A', 'T', 'M', 'P', '1'};
+
+  template <typename T>
+  void writeValue(std::ofstream& outFile, T value) {
+    outFile.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  T readValue(std::ifstream& inFile) {
+    T value;
+    inFile.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return value;
+  }
+}
+
+namespace sim {
+  MaterialMap::MaterialMap(AngleDefinition angleDefinition, size_t nAngleBins, double angleMin, double angleMax,
+                           size_t nPhiBins, size_t nRadii, double rMax)
+      : m_angleDefinition(angleDefinition), m_nAngleBins(nAngleBins), m_angleMin(angleMin), m_angleMax(angleMax),
+        m_nPhiBins(nPhiBins), m_nRadii(nRadii), m_rMax(rMax) {
+    if (nAngleBins == 0 || nPhiBins == 0 || angleMax <= angleMin) {
+      throw std::invalid_argument("Material map needs at least one bin in the polar angle and phi");
+    }
+    if (nRadii < 2 || rMax <= 0.) {
+      throw std::invalid_argument("Material map needs at least two checkpoints and positive rMax");
+    }
+    m_values.resize(2 * m_nAngleBins * m_nPhiBins * m_nRadii, 0.f);
+  }
+
+  MaterialMap MaterialMap::read(const std::string& fileName) {
+    std::ifstream inFile(fileName, std::ios::binary);
+    if (!inFile) {
+      throw std::runtime_error("Unable to open material map file: " + fileName);
+    }
+    char magic[8];
+    inFile.read(magic, sizeof(magic));
+    if (!inFile || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+      throw std::runtime_error("File " + fileName + " is not a material map");
+    }
+    const auto angleDefinition = static_cast<AngleDefinition>(readValue<uint32_t>(inFile));
+    const size_t nAngleBins = readValue<uint32_t>(inFile);
+    const size_t nPhiBins = readValue<uint32_t>(inFile);
+    const size_t nRadii = readValue<uint32_t>(inFile);
+    const double angleMin = readValue<double>(inFile);
+    const double angleMax = readValue<double>(inFile);
+    const double rMax = readValue<double>(inFile);
+    if (!inFile || angleDefinition > AngleDefinition::CosTheta) {
+      throw std::runtime_error("Material map file " + fileName + " has corrupted header");
+    }
+
+    MaterialMap map(angleDefinition, nAngleBins, angleMin, angleMax, nPhiBins, nRadii, rMax);
+    inFile.read(reinterpret_cast<char*>(map.m_values.data()), map.m_values.size() * sizeof(float));
+    if (!inFile) {
+      throw std::runtime_error("Material map file " + fileName + " is truncated");
+    }
+    return map;
+  }
+
+  void MaterialMap::write(const std::string& fileName) const {
+    std::ofstream outFile(fileName, std::ios::binary | std::ios::trunc);
+    if (!outFile) {
+      throw std::runtime_error("Unable to create material map file: " + fileName);
+    }
+    outFile.write(kMagic, sizeof(kMagic));
+    writeValue<uint32_t>(outFile, static_cast<uint32_t>(m_angleDefinition));
+    writeValue<uint32_t>(outFile, m_nAngleBins);
+    writeValue<uint32_t>(outFile, m_nPhiBins);
+    writeValue<uint32_t>(outFile, m_nRadii);
+    writeValue<double>(outFile, m_angleMin);
+    writeValue<double>(outFile, m_angleMax);
+    writeValue<double>(outFile, m_rMax);
+    outFile.write(reinterpret_cast<const char*>(m_values.data()), m_values.size() * sizeof(float));
+    if (!outFile) {
+      throw std::runtime_error("Unable to write material map file: " + fileName);
+    }
+  }
+
+  void MaterialMap::setBin(size_t iAngle, size_t iPhi, const double* nX0, const double* nLambda) {
+    float* values = &m_values[2 * (iAngle * m_nPhiBins + iPhi) * m_nRadii];
+    for (size_t iRadius = 0; iRadius < m_nRadii; ++iRadius) {
+      values[2 * iRadius] = nX0[iRadius];
+      values[2 * iRadius + 1] = nLambda[iRadius];
+    }
+  }
+
+  MaterialMap::Budget MaterialMap::materialBetween(const std::array<double, 3>& direction, double r1,
+                                                   double r2) const {
+    const size_t iAngle = angleBin(direction);
+    const size_t iPhi = phiBin(direction);
+    const Budget outer = cumulative(iAngle, iPhi, std::max(r1, r2));
+    const Budget inner = cumulative(iAngle, iPhi, std::min(r1, r2));
+    Budget budget;
+    budget.nX0 = outer.nX0 - inner.nX0;
+    budget.nLambda = outer.nLambda - inner.nLambda;
+    return budget;
+  }
+
+  MaterialMap::Budget MaterialMap::materialUpTo(const std::array<double, 3>& direction, double r) const {
+    return cumulative(angleBin(direction), phiBin(direction), r);
+  }
+
+  size_t MaterialMap::angleBin(const std::array<double, 3>& direction) const {
+    const double rho = std::hypot(direction[0], direction[1]);
+    double angle = 0.;
+    switch (m_angleDefinition) {
+      case AngleDefinition::Eta:
+        angle = std::asinh(direction[2] / rho);
+        break;
+      case AngleDefinition::Theta:
+        angle = std::atan2(rho, direction[2]) * 180. / M_PI;
+        break;
+      case AngleDefinition::ThetaRad:
+        angle = std::atan2(rho, direction[2]);
+        break;
+      case AngleDefinition::CosTheta:
+        angle = direction[2] / std::hypot(rho, direction[2]);
+        break;
+    }
+    const double position = (angle - m_angleMin) / (m_angleMax - m_angleMin) * m_nAngleBins;
+    // below the range, or NaN for a null direction
+    if (!(position > 0.)) {
+      return 0;
+    }
+    // clamp before the conversion, the position is infinite for eta along the z axis
+    return std::min(position, double(m_nAngleBins - 1));
+  }
+
+  size_t MaterialMap::phiBin(const std::array<double, 3>& direction) const {
+    const double phi = std::atan2(direction[1], direction[0]);
+    const double position = (phi + M_PI) / (2 * M_PI) * m_nPhiBins;
+    return std::min<size_t>(std::max(position, 0.), m_nPhiBins - 1);
+  }
+
+  MaterialMap::Budget MaterialMap::cumulative(size_t iAngle, size_t iPhi, double r) const {
+    const float* values = &m_values[2 * (iAngle * m_nPhiBins + iPhi) * m_nRadii];
+    const double position = std::clamp(r / m_rMax, 0., 1.) * (m_nRadii - 1);
+    const size_t iRadius = std::min<size_t>(position, m_nRadii - 2);
+    const double fraction = position - iRadius;
+    Budget budget;
+    budget.nX0 = (1. - fraction) * values[2 * iRadius] + fraction * values[2 * iRadius + 2];
+    budget.nLambda = (1. - fraction) * values[2 * iRadius + 1] + fraction * values[2 * iRadius + 3];
+    return budget;
+  }
+}
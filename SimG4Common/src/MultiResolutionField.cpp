@@ -0,0 +1,19 @@
+#include "SimG4Common/MultiResolutionField.h"
+
+namespace sim {
+  MultiResolutionField::MultiResolutionField(G4MagneticField* inner,
+                                             const std::array<double, 3>& innerMin,
+                                             const std::array<double, 3>& innerMax,
+                                             G4MagneticField* outer)
+      : m_inner(inner), m_innerMin(innerMin), m_innerMax(innerMax), m_outer(outer) {}
+
+  void MultiResolutionField::GetFieldValue(const G4double point[4], double* bField) const {
+    if (point[0] >= m_innerMin[0] && point[0] <= m_innerMax[0] &&
+        point[1] >= m_innerMin[1] && point[1] <= m_innerMax[1] &&
+        point[2] >= m_innerMin[2] && point[2] <= m_innerMax[2]) {
+      m_inner->GetFieldValue(point, bField);
+    } else {
+      m_outer->GetFieldValue(point, bField);
+    }
+  }
+}
@@ -0,0 +1,239 @@
+#include "SimG4Common/SharedFieldMap.h"
+
+// STD
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+// POSIX
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  const uint64_t kMagic = 0x4b34534d41504631;  // "k4SMAPF1"
+  const uint32_t kVersion = 2;
+
+  std::string systemError(const std::string& what, const std::string& name) {
+    return what + " '" + name + "': " + std::strerror(errno);
+  }
+}
+
+namespace sim {
+  std::shared_ptr<SharedFieldMap> SharedFieldMap::open(const std::string& name, Backend backend, uint64_t key) {
+    const int createFlags = O_RDWR | O_CREAT | O_EXCL;
+    int fd = -1;
+    if (backend == Backend::SharedMemory) {
+      fd = shm_open(name.c_str(), createFlags, 0644);
+    } else {
+      fd = ::open(name.c_str(), createFlags, 0644);
+    }
+    if (fd >= 0) {
+      std::shared_ptr<SharedFieldMap> producer(new SharedFieldMap(name, backend, key, fd, Role::Producer));
+      producer->claim();
+      return producer;
+    }
+    if (errno != EEXIST) {
+      throw std::runtime_error(systemError("Can't create shared field map", name));
+    }
+
+    if (backend == Backend::SharedMemory) {
+      fd = shm_open(name.c_str(), O_RDONLY, 0);
+    } else {
+      fd = ::open(name.c_str(), O_RDONLY);
+    }
+    if (fd < 0) {
+      throw std::runtime_error(systemError("Can't open shared field map", name));
+    }
+    return std::shared_ptr<SharedFieldMap>(new SharedFieldMap(name, backend, key, fd, Role::Consumer));
+  }
+
+  uint64_t SharedFieldMap::makeKey(const std::string& description) {
+    // FNV-1a, stable across builds, so that map files can be reused
+    uint64_t hash = 0xcbf29ce484222325;
+    for (unsigned char c : description) {
+      hash ^= c;
+      hash *= 0x100000001b3;
+    }
+    return hash;
+  }
+
+  SharedFieldMap::SharedFieldMap(const std::string& name, Backend backend, uint64_t key, int fd, Role role)
+      : m_name(name), m_backend(backend), m_key(key), m_fd(fd), m_role(role) {}
+
+  SharedFieldMap::~SharedFieldMap() {
+    unmap();
+    if (m_fd >= 0) {
+      close(m_fd);
+    }
+  }
+
+  void SharedFieldMap::claim() {
+    // the header is written right away, so that the waiting consumers can check if the producer is still running
+    if (ftruncate(m_fd, sizeof(Header)) != 0) {
+      const std::string message = systemError("Can't resize shared field map", m_name);
+      unlink();
+      throw std::runtime_error(message);
+    }
+    map(sizeof(Header), true);
+    m_header->producer.store(getpid(), std::memory_order_relaxed);
+  }
+
+  SharedFieldMap::Header& SharedFieldMap::allocate(size_t payloadSize) {
+    if (m_role != Role::Producer) {
+      throw std::logic_error("Only the producer can allocate the shared field map '" + m_name + "'");
+    }
+    const size_t size = sizeof(Header) + payloadSize;
+    if (ftruncate(m_fd, size) != 0) {
+      throw std::runtime_error(systemError("Can't resize shared field map", m_name));
+    }
+    map(size, true);
+    m_header->magic = kMagic;
+    m_header->version = kVersion;
+    m_header->key = m_key;
+    m_header->payloadSize = payloadSize;
+    return *m_header;
+  }
+
+  void SharedFieldMap::publish() {
+    if (m_role != Role::Producer || !m_header) {
+      throw std::logic_error("Shared field map '" + m_name + "' was not allocated by this process");
+    }
+    if (m_backend == Backend::File) {
+      msync(m_address, m_size, MS_SYNC);
+    }
+    m_header->state.store(State::Ready, std::memory_order_release);
+  }
+
+  void SharedFieldMap::abandon() {
+    if (m_role != Role::Producer) {
+      return;
+    }
+    if (!m_header) {
+      // let the waiting consumers know, that there will be no map
+      if (ftruncate(m_fd, sizeof(Header)) == 0) {
+        map(sizeof(Header), true);
+      }
+    }
+    if (m_header) {
+      m_header->state.store(State::Failed, std::memory_order_release);
+    }
+    unlink();
+  }
+
+  bool SharedFieldMap::waitUntilReady(double timeout) {
+    if (m_role != Role::Consumer) {
+      return m_header && m_header->state.load(std::memory_order_acquire) == State::Ready;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    while (true) {
+      struct stat status;
+      if (fstat(m_fd, &status) != 0) {
+        throw std::runtime_error(systemError("Can't inspect shared field map", m_name));
+      }
+      if (static_cast<size_t>(status.st_size) >= sizeof(Header)) {
+        if (!m_header) {
+          map(sizeof(Header), false);
+        }
+        const uint32_t state = m_header->state.load(std::memory_order_acquire);
+        if (state == State::Failed) {
+          return false;
+        }
+        if (state == State::Empty && producerDied()) {
+          // nobody will publish the map, remove the segment unless a new producer has replaced it already
+          if (isLinked()) {
+            unlink();
+          }
+          return false;
+        }
+        if (state == State::Ready) {
+          if (m_header->magic != kMagic || m_header->version != kVersion) {
+            throw std::runtime_error("Segment '" + m_name + "' does not contain a field map");
+          }
+          if (m_header->key != m_key) {
+            throw std::runtime_error("Shared field map '" + m_name +
+                                     "' was created with a different configuration, remove it first");
+          }
+          const size_t size = sizeof(Header) + m_header->payloadSize;
+          unmap();
+          map(size, false);
+          return true;
+        }
+      }
+
+      const std::chrono::duration<double> waited = std::chrono::steady_clock::now() - start;
+      if (waited.count() > timeout) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+  }
+
+  bool SharedFieldMap::producerDied() const {
+    // 0 until the producer has written the header
+    const pid_t producer = m_header->producer.load(std::memory_order_relaxed);
+    return producer > 0 && kill(producer, 0) != 0 && errno == ESRCH;
+  }
+
+  bool SharedFieldMap::isLinked() const {
+    int fd = -1;
+    if (m_backend == Backend::SharedMemory) {
+      fd = shm_open(m_name.c_str(), O_RDONLY, 0);
+    } else {
+      fd = ::open(m_name.c_str(), O_RDONLY);
+    }
+    if (fd < 0) {
+      return false;
+    }
+    struct stat linked, own;
+    const bool same = fstat(fd, &linked) == 0 && fstat(m_fd, &own) == 0 && linked.st_dev == own.st_dev &&
+                      linked.st_ino == own.st_ino;
+    close(fd);
+    return same;
+  }
+
+  void* SharedFieldMap::payload() {
+    if (m_role != Role::Producer) {
+      throw std::logic_error("Shared field map '" + m_name + "' is mapped read-only");
+    }
+    return static_cast<char*>(m_address) + sizeof(Header);
+  }
+
+  const void* SharedFieldMap::payload() const {
+    return static_cast<const char*>(m_address) + sizeof(Header);
+  }
+
+  void SharedFieldMap::map(size_t size, bool writable) {
+    unmap();
+    const int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* address = mmap(nullptr, size, protection, MAP_SHARED, m_fd, 0);
+    if (address == MAP_FAILED) {
+      throw std::runtime_error(systemError("Can't map shared field map", m_name));
+    }
+    m_address = address;
+    m_size = size;
+    m_header = static_cast<Header*>(address);
+  }
+
+  void SharedFieldMap::unmap() {
+    if (m_address) {
+      munmap(m_address, m_size);
+    }
+    m_address = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+  }
+
+  void SharedFieldMap::unlink() {
+    if (m_backend == Backend::SharedMemory) {
+      shm_unlink(m_name.c_str());
+    } else {
+      ::unlink(m_name.c_str());
+    }
+  }
+}
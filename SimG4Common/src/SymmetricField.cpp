@@ -0,0 +1,77 @@
+#include "SimG4Common/SymmetricField.h"
+
+// Geant 4
+#include "G4SystemOfUnits.hh"
+
+// STD
+#include <cmath>
+#include <stdexcept>
+
+namespace sim {
+  SymmetricField::SymmetricField(G4MagneticField* field)
+      : m_field(field), m_sectorAngle(twopi) {
+    for (auto& parity : m_parity) {
+      parity = {1., 1., 1.};
+    }
+  }
+
+  void SymmetricField::setMirror(size_t axis, const Parity& parity) {
+    if (axis > 2) {
+      throw std::invalid_argument("Mirror axis has to be 0 (x), 1 (y) or 2 (z)");
+    }
+    m_mirror[axis] = true;
+    m_parity[axis] = parity;
+  }
+
+  void SymmetricField::setPhiSymmetry(unsigned order) {
+    m_phiOrder = order < 2 ? 1 : order;
+    m_sectorAngle = twopi / m_phiOrder;
+    m_sectorCos.resize(m_phiOrder);
+    m_sectorSin.resize(m_phiOrder);
+    for (unsigned k = 0; k < m_phiOrder; ++k) {
+      m_sectorCos[k] = std::cos(k * m_sectorAngle);
+      m_sectorSin[k] = std::sin(k * m_sectorAngle);
+    }
+  }
+
+  void SymmetricField::GetFieldValue(const G4double point[4], double* bField) const {
+    double localPoint[4] = {point[0], point[1], point[2], point[3]};
+    double factor[3] = {1., 1., 1.};
+    for (size_t a = 0; a < 3; ++a) {
+      if (m_mirror[a] && localPoint[a] < 0.) {
+        localPoint[a] = -localPoint[a];
+        for (size_t c = 0; c < 3; ++c) {
+          factor[c] *= m_parity[a][c];
+        }
+      }
+    }
+
+    // Rotate the point into the first sector
+    unsigned sector = 0;
+    if (m_phiOrder > 1) {
+      double phi = std::atan2(localPoint[1], localPoint[0]);
+      if (phi < 0.) {
+        phi += twopi;
+      }
+      sector = static_cast<unsigned>(phi / m_sectorAngle) % m_phiOrder;
+      const double x = localPoint[0];
+      const double y = localPoint[1];
+      localPoint[0] = x * m_sectorCos[sector] + y * m_sectorSin[sector];
+      localPoint[1] = -x * m_sectorSin[sector] + y * m_sectorCos[sector];
+    }
+
+    m_field->GetFieldValue(localPoint, bField);
+
+    // Rotate the field back
+    if (sector > 0) {
+      const double bx = bField[0];
+      const double by = bField[1];
+      bField[0] = bx * m_sectorCos[sector] - by * m_sectorSin[sector];
+      bField[1] = bx * m_sectorSin[sector] + by * m_sectorCos[sector];
+    }
+
+    for (size_t c = 0; c < 3; ++c) {
+      bField[c] *= factor[c];
+    }
+  }
+}
@@ -3,23 +3,18 @@
 
 // FCCSW
 #include "SimG4Common/ConstantField.h"
+#include "SimG4Common/FieldSetup.h"
+
+// STD
+#include <stdexcept>
 
 // Geant 4
-#include "G4ChordFinder.hh"
 #include "G4FieldManager.hh"
 #include "G4MagneticField.hh"
 #include "G4TransportationManager.hh"
-#include "G4MagIntegratorDriver.hh"
+#include "G4UniformMagField.hh"
 #include "G4VUserPrimaryGeneratorAction.hh"
 
-#include "G4ClassicalRK4.hh"
-#include "G4HelixExplicitEuler.hh"
-#include "G4ExactHelixStepper.hh"
-#include "G4HelixImplicitEuler.hh"
-#include "G4HelixSimpleRunge.hh"
-#include "G4MagIntegratorStepper.hh"
-#include "G4Mag_UsualEqRhs.hh"
-#include "G4NystromRK4.hh"
 #include "G4PropagatorInField.hh"
 
 // Declaration of the Tool
@@ -44,21 +39,39 @@ StatusCode SimG4ConstantMagneticFieldTool::initialize() {
     G4FieldManager* fieldManager = transpManager->GetFieldManager();
     G4PropagatorInField* propagator = transpManager->GetPropagatorInField();
 
+    sim::FieldPropagationParameters parameters;
+    parameters.stepper = m_integratorStepper;
     // The field manager keeps an observing pointer to the field, ownership stays with this tool. (Cleaned up in dtor)
-    m_field =
-        new sim::ConstantField(m_fieldComponentX, m_fieldComponentY, m_fieldComponentZ, m_fieldRadMax, m_fieldZMax);
-    fieldManager->SetDetectorField(m_field);
+    if (m_uniformField) {
+      m_field = new G4UniformMagField(G4ThreeVector(m_fieldComponentX, m_fieldComponentY, m_fieldComponentZ));
+      // The exact helix is the solution in the uniform field, the trajectory is not integrated.
+      // A stepper other than the default one was requested explicitly and is overridden.
+      if (m_integratorStepper.value() != "NystromRK4" && m_integratorStepper.value() != "ExactHelix") {
+        warning() << "IntegratorStepper " << m_integratorStepper.value()
+                  << " is ignored, the uniform field is propagated with the ExactHelix stepper" << endmsg;
+      }
+      parameters.stepper = "ExactHelix";
+      info() << "Uniform magnetic field propagated with the ExactHelix stepper, FieldRMax and FieldZMax are ignored"
+             << endmsg;
+    } else {
+      m_field =
+          new sim::ConstantField(m_fieldComponentX, m_fieldComponentY, m_fieldComponentZ, m_fieldRadMax, m_fieldZMax);
+    }
 
-    G4ChordFinder* chordFinder = 
-    new G4ChordFinder( m_field,  m_minStep, stepper(m_integratorStepper, m_field));
-    fieldManager->SetChordFinder(chordFinder);
+    parameters.driver = m_integrationDriver;
+    parameters.minStep = m_minStep;
+    parameters.deltaChord = m_deltaChord;
+    parameters.deltaOneStep = m_deltaOneStep;
+    parameters.minEpsilon = m_minEps;
+    parameters.maxEpsilon = m_maxEps;
+    try {
+      sim::setupFieldManager(*fieldManager, m_field, parameters);
+    } catch (const std::invalid_argument& e) {
+      error() << e.what() << endmsg;
+      return StatusCode::FAILURE;
+    }
 
     propagator->SetLargestAcceptableStep(m_maxStep);
-
-    if (m_deltaChord > 0) fieldManager->GetChordFinder()->SetDeltaChord(m_deltaChord);
-    if (m_deltaOneStep > 0) fieldManager->SetDeltaOneStep(m_deltaOneStep);
-    if (m_minEps > 0) fieldManager->SetMinimumEpsilonStep(m_minEps);
-    if (m_maxEps > 0) fieldManager->SetMaximumEpsilonStep(m_maxEps);
   }
   return sc;
 }
@@ -69,23 +82,3 @@ StatusCode SimG4ConstantMagneticFieldTool::finalize() {
 }
 
 const G4MagneticField* SimG4ConstantMagneticFieldTool::field() const { return m_field; }
-
-G4MagIntegratorStepper* SimG4ConstantMagneticFieldTool::stepper(const std::string& name, G4MagneticField* field) const {
-  G4Mag_UsualEqRhs* fEquation = new G4Mag_UsualEqRhs(field);
-  if (name == "HelixImplicitEuler")
-    return new G4HelixImplicitEuler(fEquation);
-  else if (name == "HelixSimpleRunge")
-    return new G4HelixSimpleRunge(fEquation);
-  else if (name == "HelixExplicitEuler")
-    return new G4HelixExplicitEuler(fEquation);
-  else if (name == "NystromRK4")
-    return new G4NystromRK4(fEquation);
-  else if (name == "ClassicalRK4")
-    return new G4ClassicalRK4(fEquation);
-  else if (name == "ExactHelix")
-    return new G4ExactHelixStepper(fEquation);
-  else {
-    error() << "Stepper " << name << " not available! returning NystromRK4!" << endmsg;
-    return new G4NystromRK4(fEquation);
-  }
-}
@@ -12,18 +12,19 @@
 
 // Forward declarations:
 // Geant 4 classes
-class G4MagIntegratorStepper;
-
-// FCCSW
-namespace sim {
-class ConstantField;
-}
+class G4MagneticField;
 
 /** @class SimG4ConstantMagneticFieldTool SimG4Components/src/SimG4ConstantMagneticFieldTool.h
 * SimG4ConstantMagneticFieldTool.h
 *
 *  Implementation of ISimG4MagneticFieldTool that generates a constant field
 *
+*  By default the field is constant inside a cylinder (FieldRMax, FieldZMax) and zero outside.
+*  With UniformField the field is uniform everywhere (G4UniformMagField) and propagated with
+*  the exact helix stepper, so that no position check is done in the field evaluation. Its
+*  extent is given by the geometry instead: use SimG4FieldRegion with ConfineGlobalField to
+*  keep the field only in the chosen volumes, or with FieldOff to exclude field-free volumes.
+*
 *  @author Andrea Dell'Acqua
 *  @date   2016-02-22
 */
@@ -46,13 +47,9 @@ public:
   /// @returns pointer to G4MagneticField
   virtual const G4MagneticField* field() const final;
 
-  /// Get the stepper
-  /// @returns pointer to G4MagIntegratorStepper (ownership is transferred to the caller)
-  G4MagIntegratorStepper* stepper(const std::string&, G4MagneticField*) const;
-
 private:
   /// Pointer to the actual Geant 4 magnetic field
-  sim::ConstantField* m_field;
+  G4MagneticField* m_field;
   /// Switch to turn field on or off (default is off). Set with property FieldOn
   Gaudi::Property<bool> m_fieldOn{this, "FieldOn", false, "Switch to turn field off"};
   /// Minimum epsilon (relative error of position / momentum, see G4 doc for more details). Set with property
@@ -70,8 +67,10 @@ private:
   Gaudi::Property<double> m_maxStep{this, "MaximumStep", 1. * m, "Maximum step length in field (see G4 documentation)"};
   /// Lower limit of the step size, see G4 doc for more details. Set with property MaximumStep
   Gaudi::Property<double> m_minStep{this, "MinimumStep", 0.01 * mm, "Minimum step length in field (see G4 documentation)"};
-  /// Name of the integration stepper, defaults to NystromRK4.
+  /// Name of the integration stepper, defaults to NystromRK4, see SimG4Common/FieldSetup.h
   Gaudi::Property<std::string> m_integratorStepper{this, "IntegratorStepper", "NystromRK4", "Integrator stepper name"};
+  /// Name of the integration driver, defaults to MagIntDriver (G4MagInt_Driver), see SimG4Common/FieldSetup.h
+  Gaudi::Property<std::string> m_integrationDriver{this, "IntegrationDriver", "MagIntDriver", "Integration driver name"};
 
   /// Field component in X direction. Set with property FieldComponentX
   Gaudi::Property<double> m_fieldComponentX{this, "FieldComponentX", 0, "Field X component"};
@@ -83,6 +82,9 @@ private:
   Gaudi::Property<double> m_fieldRadMax{this, "FieldRMax", 6 * m, "Field max radius"};
   /// Size of the field along the beam line. Set with property FieldZMax
   Gaudi::Property<double> m_fieldZMax{this, "FieldZMax", 20. * m, "Field max Z"};
+  /// Switch to the uniform field without extent, propagated with ExactHelix whatever the IntegratorStepper.
+  /// Set with property UniformField
+  Gaudi::Property<bool> m_uniformField{this, "UniformField", false, "Uniform field everywhere, extent given by field regions"};
 };
 
 #endif
@@ -2,39 +2,48 @@
 #include "SimG4MagneticFieldFromMapTool.h"
 
 // STD
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
 
 // FCCSW
 #include "SimG4Common/MapField3DRegular.h"
 #include "SimG4Common/MapField2DRegular.h"
+#include "SimG4Common/SharedFieldMap.h"
+#include "SimG4Common/FieldComparison.h"
+#include "SimG4Common/SymmetricField.h"
+#include "SimG4Common/MapField3DTricubic.h"
+#include "SimG4Common/CountingField.h"
+#include "SimG4Common/MapField3DRectilinear.h"
+#include "SimG4Common/MultiResolutionField.h"
+#include "SimG4Common/FieldSetup.h"
 
 // ROOT
 #include "TSystem.h"
+#include "ROOT/RDataFrame.hxx"
 #include "TFile.h"
 #include "TTree.h"
 
 // Geant 4
-#include "G4ChordFinder.hh"
 #include "G4FieldManager.hh"
 #include "G4MagneticField.hh"
 #include "G4TransportationManager.hh"
-#include "G4MagIntegratorDriver.hh"
 #include "G4VUserPrimaryGeneratorAction.hh"
 
-#include "G4ClassicalRK4.hh"
-#include "G4HelixExplicitEuler.hh"
-#include "G4ExactHelixStepper.hh"
-#include "G4HelixImplicitEuler.hh"
-#include "G4HelixSimpleRunge.hh"
-#include "G4MagIntegratorStepper.hh"
-#include "G4Mag_UsualEqRhs.hh"
-#include "G4NystromRK4.hh"
 #include "G4PropagatorInField.hh"
 
 // Declaration of the Tool
 DECLARE_COMPONENT(SimG4MagneticFieldFromMapTool)
 
+namespace {
+  /// Maximal distance of the node from the grid point, in units of the grid step
+  const double kGridTolerance = 1e-3;
+}
+
 SimG4MagneticFieldFromMapTool::SimG4MagneticFieldFromMapTool(const std::string& type, const std::string& name,
                                                              const IInterface* parent)
     : AlgTool(type, name, parent), m_field(nullptr) {
@@ -64,12 +73,80 @@ StatusCode SimG4MagneticFieldFromMapTool::initialize() {
     return StatusCode::FAILURE;
   }
 
+  if (!sim::parseFieldStorageType(m_mapPrecision, m_storageType)) {
+    error() << "Fieldmap precision not recognized: " << m_mapPrecision.value() << endmsg;
+    error() << "    Allowed values: 'double', 'float', 'int16'" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  debug() << "Fieldmap values stored as: " << m_mapPrecision.value() << endmsg;
+
+  if (m_interpolationMode != "linear" && m_interpolationMode != "tricubic") {
+    error() << "Fieldmap interpolation mode not recognized: " << m_interpolationMode.value() << endmsg;
+    error() << "    Allowed values: 'linear', 'tricubic'" << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  if (m_gridType != "regular" && m_gridType != "rectilinear") {
+    error() << "Fieldmap grid type not recognized: " << m_gridType.value() << endmsg;
+    error() << "    Allowed values: 'regular', 'rectilinear'" << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  if (m_interpolationMode == "tricubic" && m_gridType != "regular") {
+    error() << "Tricubic interpolation is available only for the regular fieldmaps!" << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  // The tricubic coefficients (192 doubles per cell) are computed in every process from the loaded nodes
+  if (m_interpolationMode == "tricubic" && (!m_sharedMapName.empty() || !m_sharedMapFile.empty())) {
+    error() << "Tricubic interpolation can't be used with the shared fieldmap, every job would keep its own "
+            << "tricubic coefficients. Use InterpolationMode = 'linear' or remove SharedMapName / SharedMapFile."
+            << endmsg;
+    return StatusCode::FAILURE;
+  }
+  if (m_interpolationMode == "tricubic" && m_storageType != sim::FieldStorageType::Double) {
+    warning() << "Tricubic interpolation keeps its coefficients in double precision, MapPrecision = '"
+              << m_mapPrecision.value() << "' only affects the nodes and does not reduce the memory" << endmsg;
+  }
+
+  for (const auto* parity : {&m_mirrorXParity, &m_mirrorYParity, &m_mirrorZParity}) {
+    if (parity->value().size() != 3) {
+      error() << "Parity of the mirror " << parity->name() << " has to have three components!" << endmsg;
+      return StatusCode::FAILURE;
+    }
+  }
+
   if (m_mapFilePath.value().find(".root") != std::string::npos) {
-    sc = loadRootMap();
+    LoadedMap outerMap;
+    sc = loadRootMap(m_mapFilePath.value(), true, outerMap);
     if (!sc.isSuccess()) {
       return sc;
     }
+    m_field = outerMap.field;
+
+    if (!m_innerMapFilePath.empty()) {
+      if (gSystem->AccessPathName(m_innerMapFilePath.value().c_str())) {
+        error() << "Inner fieldmap file does not exist!" << endmsg;
+        error() << "    " << m_innerMapFilePath.value() << endmsg;
+        return StatusCode::FAILURE;
+      }
+      LoadedMap innerMap;
+      sc = loadRootMap(m_innerMapFilePath.value(), false, innerMap);
+      if (!sc.isSuccess()) {
+        return sc;
+      }
+      m_field = new sim::MultiResolutionField(innerMap.field, innerMap.lowerCorner, innerMap.upperCorner, m_field);
+      info() << "Using inner fieldmap in the box ("
+             << innerMap.lowerCorner[0] << ", " << innerMap.lowerCorner[1] << ", " << innerMap.lowerCorner[2] << ") - ("
+             << innerMap.upperCorner[0] << ", " << innerMap.upperCorner[1] << ", " << innerMap.upperCorner[2] << ") mm"
+             << endmsg;
+    }
   } else if (m_mapFilePath.value().find(".txt") != std::string::npos) {
+    if (m_interpolationMode == "tricubic" || m_gridType != "regular" || !m_innerMapFilePath.empty()) {
+      error() << "Tricubic interpolation, rectilinear grid and inner fieldmap are available only for the 3D fieldmaps!"
+              << endmsg;
+      return StatusCode::FAILURE;
+    }
     sc = loadComsolMap();
     if (!sc.isSuccess()) {
       return sc;
@@ -81,25 +158,35 @@ StatusCode SimG4MagneticFieldFromMapTool::initialize() {
     return StatusCode::FAILURE;
   }
 
+  applySymmetry();
+
+  if (m_countFieldCalls) {
+    m_countingField = new sim::CountingField(m_field);
+    m_field = m_countingField;
+  }
+
   G4TransportationManager* transpManager = G4TransportationManager::GetTransportationManager();
   G4FieldManager* fieldManager = transpManager->GetFieldManager();
   G4PropagatorInField* propagator = transpManager->GetPropagatorInField();
 
-  fieldManager->SetDetectorField(m_field);
 
-  G4ChordFinder* chordFinder = new G4ChordFinder(m_field,
-                                                 m_minStep,
-                                                 stepper(m_integratorStepper,
-                                                         m_field));
-  fieldManager->SetChordFinder(chordFinder);
+  sim::FieldPropagationParameters parameters;
+  parameters.stepper = m_integratorStepper;
+  parameters.driver = m_integrationDriver;
+  parameters.minStep = m_minStep;
+  parameters.deltaChord = m_deltaChord;
+  parameters.deltaOneStep = m_deltaOneStep;
+  parameters.minEpsilon = m_minEps;
+  parameters.maxEpsilon = m_maxEps;
+  try {
+    sim::setupFieldManager(*fieldManager, m_field, parameters);
+  } catch (const std::invalid_argument& e) {
+    error() << e.what() << endmsg;
+    return StatusCode::FAILURE;
+  }
 
   propagator->SetLargestAcceptableStep(m_maxStep);
 
-  if (m_deltaChord > 0) fieldManager->GetChordFinder()->SetDeltaChord(m_deltaChord);
-  if (m_deltaOneStep > 0) fieldManager->SetDeltaOneStep(m_deltaOneStep);
-  if (m_minEps > 0) fieldManager->SetMinimumEpsilonStep(m_minEps);
-  if (m_maxEps > 0) fieldManager->SetMaximumEpsilonStep(m_maxEps);
-
   if (m_fieldMaxR >= 0) {
     debug() << "Using cut on maximal R of the field from fieldmap: "
             << m_fieldMaxR << " mm" << endmsg;
@@ -125,6 +212,10 @@ StatusCode SimG4MagneticFieldFromMapTool::initialize() {
 
 
 StatusCode SimG4MagneticFieldFromMapTool::finalize() {
+  if (m_countingField) {
+    info() << "Field evaluations: " << m_countingField->calls() << endmsg;
+  }
+
   StatusCode sc = AlgTool::finalize();
 
   return sc;
@@ -136,36 +227,56 @@ const G4MagneticField* SimG4MagneticFieldFromMapTool::field() const {
 }
 
 
-G4MagIntegratorStepper* SimG4MagneticFieldFromMapTool::stepper(const std::string& name, G4MagneticField* field) const {
-  G4Mag_UsualEqRhs* fEquation = new G4Mag_UsualEqRhs(field);
-  if (name == "HelixImplicitEuler")
-    return new G4HelixImplicitEuler(fEquation);
-  else if (name == "HelixSimpleRunge")
-    return new G4HelixSimpleRunge(fEquation);
-  else if (name == "HelixExplicitEuler")
-    return new G4HelixExplicitEuler(fEquation);
-  else if (name == "NystromRK4")
-    return new G4NystromRK4(fEquation);
-  else if (name == "ClassicalRK4")
-    return new G4ClassicalRK4(fEquation);
-  else if (name == "ExactHelix")
-    return new G4ExactHelixStepper(fEquation);
-  else {
-    error() << "Stepper " << name << " not available! returning NystromRK4!" << endmsg;
-    return new G4NystromRK4(fEquation);
+
+StatusCode SimG4MagneticFieldFromMapTool::loadRootMap(const std::string& mapFilePath, bool shareMap,
+                                                      LoadedMap& loadedMap) {
+  if (shareMap && (!m_sharedMapName.empty() || !m_sharedMapFile.empty())) {
+    if (m_gridType != "regular") {
+      warning() << "Only regular fieldmaps can be shared, loading private copy of the map!" << endmsg;
+    } else {
+      StatusCode sc = attachSharedMap(loadedMap);
+      if (!sc.isSuccess()) {
+        return sc;
+      }
+      if (loadedMap.field) {
+        return interpolateMap3D(loadedMap);
+      }
+    }
   }
-}
 
+  if (m_gridType == "regular") {
+    const bool enableMT = m_loadingThreads > 1 && !ROOT::IsImplicitMTEnabled();
+    if (enableMT) {
+      ROOT::EnableImplicitMT(m_loadingThreads);
+    }
+    StatusCode sc = StatusCode::FAILURE;
+    try {
+      sc = loadRegularRootMap(mapFilePath, shareMap, loadedMap);
+    } catch (const std::exception& ex) {
+      error() << "Can't load the fieldmap: " << ex.what() << endmsg;
+      error() << "    " << mapFilePath << endmsg;
+    }
+    if (enableMT) {
+      ROOT::DisableImplicitMT();
+    }
+    if (!sc.isSuccess() && shareMap && m_sharedMap) {
+      m_sharedMap->abandon();
+      m_sharedMap.reset();
+    }
+    return sc;
+  }
 
-StatusCode SimG4MagneticFieldFromMapTool::loadRootMap() {
-  std::unique_ptr<TFile> inFile(TFile::Open(m_mapFilePath.value().c_str(), "READ"));
+  std::unique_ptr<TFile> inFile(TFile::Open(mapFilePath.c_str(), "READ"));
   if (inFile->IsZombie()) {
     error() << "Can't open the file with fieldmap!" << endmsg;
-    error() << "    " << m_mapFilePath.value() << endmsg;
+    error() << "    " << mapFilePath << endmsg;
+    if (m_sharedMap) {
+      m_sharedMap->abandon();
+    }
     return StatusCode::FAILURE;
   } else {
     debug() << "Loading magnetic field map from file: " << endmsg;
-    debug() << "    " << m_mapFilePath.value() << endmsg;
+    debug() << "    " << mapFilePath << endmsg;
   }
 
   TTree *inTree = dynamic_cast<TTree*>(inFile->Get("ntuple"));
@@ -211,21 +322,7 @@ StatusCode SimG4MagneticFieldFromMapTool::loadRootMap() {
 
     double r = std::sqrt(std::pow(x, 2) + std::pow(y, 2));
 
-    if (m_addFieldMaxR.value() > 0 && m_addFieldMaxZ.value() > 0) {
-      if(r < m_addFieldMaxR.value() && std::abs(z) < m_addFieldMaxZ.value()) {
-        bz += m_addFieldBz.value();
-      }
-    } else if (m_addFieldMaxR.value() <= 0 && m_addFieldMaxZ.value() > 0) {
-      if (std::abs(z) < m_addFieldMaxZ.value()) {
-        bz += m_addFieldBz.value();
-      }
-    } else if (m_addFieldMaxR.value() > 0 && m_addFieldMaxZ.value() <= 0) {
-      if (r < m_addFieldMaxR.value()) {
-        bz += m_addFieldBz.value();
-      }
-    } else {
-      bz += m_addFieldBz.value();
-    }
+    bz += additionalFieldBz(r, z);
 
     fieldPositionX.emplace_back(x);
     fieldPositionY.emplace_back(y);
@@ -236,21 +333,430 @@ StatusCode SimG4MagneticFieldFromMapTool::loadRootMap() {
   }
   debug() << "Loaded map with " << fieldPositionX.size() << " nodes."
           << endmsg;
+  cropToFundamentalDomain({&fieldPositionX, &fieldPositionY, &fieldPositionZ},
+                          {&fieldPositionX, &fieldPositionY, &fieldPositionZ,
+                           &fieldComponentX, &fieldComponentY, &fieldComponentZ});
   if (fieldComponentX.size() < 1) {
     error() << "Could not load any mapfield nodes!" << endmsg;
+    error() << "    " << mapFilePath << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  try {
+    switch (m_storageType) {
+      case sim::FieldStorageType::Float:
+        createRectilinearMap<float>(fieldComponentX, fieldComponentY, fieldComponentZ,
+                                    fieldPositionX, fieldPositionY, fieldPositionZ, loadedMap);
+        break;
+      case sim::FieldStorageType::Int16:
+        createRectilinearMap<int16_t>(fieldComponentX, fieldComponentY, fieldComponentZ,
+                                      fieldPositionX, fieldPositionY, fieldPositionZ, loadedMap);
+        break;
+      default:
+        createRectilinearMap<double>(fieldComponentX, fieldComponentY, fieldComponentZ,
+                                     fieldPositionX, fieldPositionY, fieldPositionZ, loadedMap);
+    }
+
+    if (m_validationBins > 0 && m_storageType != sim::FieldStorageType::Double) {
+      auto referenceMap = sim::MapField3DRectilinear<double>(fieldComponentX, fieldComponentY, fieldComponentZ,
+                                                             fieldPositionX, fieldPositionY, fieldPositionZ);
+      validateMapPrecision(*loadedMap.field, referenceMap, loadedMap.lowerCorner, loadedMap.upperCorner);
+    }
+  } catch (const std::exception& ex) {
+    error() << "Can't load the fieldmap: " << ex.what() << endmsg;
+    error() << "    " << mapFilePath << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  return interpolateMap3D(loadedMap);
+}
+
+
+template <typename StorageT>
+void SimG4MagneticFieldFromMapTool::createRectilinearMap(const std::vector<double>& bX,
+                                                         const std::vector<double>& bY,
+                                                         const std::vector<double>& bZ,
+                                                         const std::vector<double>& posX,
+                                                         const std::vector<double>& posY,
+                                                         const std::vector<double>& posZ,
+                                                         LoadedMap& loadedMap) {
+  auto fieldMap = new sim::MapField3DRectilinear<StorageT>(bX, bY, bZ, posX, posY, posZ);
+  loadedMap = {fieldMap, fieldMap->lowerCorner(), fieldMap->upperCorner()};
+}
+
+
+StatusCode SimG4MagneticFieldFromMapTool::loadRegularRootMap(const std::string& mapFilePath, bool shareMap,
+                                                             LoadedMap& loadedMap) {
+  debug() << "Loading magnetic field map from file: " << endmsg;
+  debug() << "    " << mapFilePath << endmsg;
+
+  // Nodes after the unit conversion, cuts and additional field
+  const double fieldMaxR = m_fieldMaxR;
+  const double fieldMaxZ = m_fieldMaxZ;
+  ROOT::RDataFrame frame("ntuple", mapFilePath);
+  ROOT::RDF::RNode nodes =
+      frame.Define("x", [](float x) { return x * millimeter; }, {"X"})
+           .Define("y", [](float y) { return y * millimeter; }, {"Y"})
+           .Define("z", [](float z) { return z * millimeter; }, {"Z"})
+           .Filter([fieldMaxR, fieldMaxZ](double x, double y, double z) {
+                     return !(fieldMaxR > 0 && (std::abs(x) > fieldMaxR || std::abs(y) > fieldMaxR)) &&
+                            !(fieldMaxZ > 0 && std::abs(z) > fieldMaxZ);
+                   }, {"x", "y", "z"})
+           .Define("bx", [](float bx) { return bx * tesla; }, {"Bx"})
+           .Define("by", [](float by) { return by * tesla; }, {"By"})
+           .Define("bz", [this](double x, double y, double z, float bz) {
+                     return bz * tesla + additionalFieldBz(std::sqrt(x * x + y * y), z);
+                   }, {"x", "y", "z", "Bz"});
+
+  // First pass: extent of the map and range of the values
+  const std::array<std::string, 3> positions = {"x", "y", "z"};
+  const std::array<std::string, 3> components = {"bx", "by", "bz"};
+  std::array<ROOT::RDF::RResultPtr<double>, 3> minPosition, maxPosition, maxAbsValue;
+  for (size_t a = 0; a < 3; ++a) {
+    minPosition[a] = nodes.Min<double>(positions[a]);
+    maxPosition[a] = nodes.Max<double>(positions[a]);
+    maxAbsValue[a] = nodes.Define("abs" + components[a], [](double b) { return std::abs(b); }, {components[a]})
+                          .Max<double>("abs" + components[a]);
+  }
+  auto nEntries = nodes.Count();
+  if (*nEntries == 0) {
+    error() << "Could not load any mapfield nodes!" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  debug() << "Loaded map with " << *nEntries << " nodes." << endmsg;
+
+  // Second pass: step of the grid, distance of the first two node layers
+  std::array<ROOT::RDF::RResultPtr<double>, 3> secondPosition;
+  for (size_t a = 0; a < 3; ++a) {
+    const double first = *minPosition[a];
+    secondPosition[a] = nodes.Filter([first](double p) { return p > first; }, {positions[a]}).Min<double>(positions[a]);
+  }
+  RegularGrid grid;
+  for (size_t a = 0; a < 3; ++a) {
+    grid.lowerCorner[a] = *minPosition[a];
+    grid.upperCorner[a] = *maxPosition[a];
+    if (grid.upperCorner[a] <= grid.lowerCorner[a]) {
+      error() << "Fieldmap needs at least two nodes along every axis!" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    grid.step[a] = *secondPosition[a] - grid.lowerCorner[a];
+    grid.shape[a] = std::lround((grid.upperCorner[a] - grid.lowerCorner[a]) / grid.step[a]) + 1;
+    grid.maxAbsValue[a] = *maxAbsValue[a];
   }
 
-  m_field = new sim::MapField3DRegular(fieldComponentX,
-                                       fieldComponentY,
-                                       fieldComponentZ,
-                                       fieldPositionX,
-                                       fieldPositionY,
-                                       fieldPositionZ);
+  // Mirror symmetries: the last node layer at or below zero is kept
+  const std::array<bool, 3> mirror = {m_mirrorX, m_mirrorY, m_mirrorZ};
+  size_t nNodesFull = grid.shape[0] * grid.shape[1] * grid.shape[2];
+  for (size_t a = 0; a < 3; ++a) {
+    if (mirror[a] && grid.lowerCorner[a] < 0.) {
+      const size_t firstKept = std::min<size_t>(std::floor(-grid.lowerCorner[a] / grid.step[a] + kGridTolerance),
+                                                grid.shape[a] - 2);
+      grid.lowerCorner[a] += firstKept * grid.step[a];
+      grid.shape[a] -= firstKept;
+    }
+  }
+  const size_t nNodes = grid.shape[0] * grid.shape[1] * grid.shape[2];
+  if (nNodes < nNodesFull) {
+    info() << "Fieldmap reduced to the fundamental domain of the mirror symmetries: "
+           << nNodes << " out of " << nNodesFull << " nodes kept" << endmsg;
+  }
+
+  // Third pass: filling the grid
+  switch (m_storageType) {
+    case sim::FieldStorageType::Float:
+      return fillRegularMap<float>(nodes, grid, shareMap, loadedMap);
+    case sim::FieldStorageType::Int16:
+      return fillRegularMap<int16_t>(nodes, grid, shareMap, loadedMap);
+    default:
+      return fillRegularMap<double>(nodes, grid, shareMap, loadedMap);
+  }
+}
+
+
+template <typename StorageT>
+StatusCode SimG4MagneticFieldFromMapTool::fillRegularMap(ROOT::RDF::RNode nodes, const RegularGrid& grid,
+                                                         bool shareMap, LoadedMap& loadedMap) {
+  auto fieldMap = std::make_unique<sim::MapField3DRegular<StorageT>>(grid.shape, grid.lowerCorner,
+                                                                      grid.upperCorner, grid.maxAbsValue);
+  std::unique_ptr<sim::MapField3DRegular<double>> referenceMap;
+  if (m_validationBins > 0 && m_storageType != sim::FieldStorageType::Double) {
+    referenceMap = std::make_unique<sim::MapField3DRegular<double>>(grid.shape, grid.lowerCorner,
+                                                                    grid.upperCorner, grid.maxAbsValue);
+  }
+
+  // Nodes are filled concurrently, every node only once
+  const size_t nNodes = grid.shape[0] * grid.shape[1] * grid.shape[2];
+  std::vector<std::atomic<uint8_t>> filled(nNodes);
+  std::atomic<size_t> nOffGrid{0};
+  std::atomic<size_t> nDuplicates{0};
+  nodes.Foreach([&](double x, double y, double z, double bx, double by, double bz) {
+                  const double position[3] = {x, y, z};
+                  size_t index[3];
+                  for (size_t a = 0; a < 3; ++a) {
+                    const double fraction = (position[a] - grid.lowerCorner[a]) / grid.step[a];
+                    const double rounded = std::round(fraction);
+                    if (rounded < 0.) {
+                      // outside of the fundamental domain
+                      return;
+                    }
+                    if (std::abs(fraction - rounded) > kGridTolerance || rounded >= grid.shape[a]) {
+                      nOffGrid++;
+                      return;
+                    }
+                    index[a] = rounded;
+                  }
+                  if (filled[(index[0] * grid.shape[1] + index[1]) * grid.shape[2] + index[2]].exchange(1)) {
+                    nDuplicates++;
+                    return;
+                  }
+                  const double bField[3] = {bx, by, bz};
+                  fieldMap->setNode(index[0], index[1], index[2], bField);
+                  if (referenceMap) {
+                    referenceMap->setNode(index[0], index[1], index[2], bField);
+                  }
+                }, {"x", "y", "z", "bx", "by", "bz"});
+
+  if (nOffGrid > 0) {
+    error() << nOffGrid << " fieldmap nodes do not lie on the regular grid with steps ("
+            << grid.step[0] << ", " << grid.step[1] << ", " << grid.step[2]
+            << ") mm, use GridType = 'rectilinear' for non-uniform maps!" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  if (nDuplicates > 0) {
+    warning() << nDuplicates << " fieldmap nodes are duplicated, the first occurrence is used" << endmsg;
+  }
+
+  const size_t nMissing = std::count(filled.begin(), filled.end(), 0);
+  if (nMissing > 0) {
+    MsgStream& log = m_allowMissingNodes ? warning() : error();
+    log << nMissing << " out of " << nNodes << " nodes of the regular grid are missing in the fieldmap, e.g.:" << endmsg;
+    size_t nReported = 0;
+    for (size_t index = 0; index < nNodes && nReported < 5; ++index) {
+      if (filled[index] == 0) {
+        const size_t i = index / (grid.shape[1] * grid.shape[2]);
+        const size_t j = (index / grid.shape[2]) % grid.shape[1];
+        const size_t k = index % grid.shape[2];
+        log << "    (" << grid.lowerCorner[0] + i * grid.step[0] << ", " << grid.lowerCorner[1] + j * grid.step[1]
+            << ", " << grid.lowerCorner[2] + k * grid.step[2] << ") mm" << endmsg;
+        nReported++;
+      }
+    }
+    if (!m_allowMissingNodes) {
+      error() << "Set AllowMissingNodes = True to use zero field in the missing nodes" << endmsg;
+      return StatusCode::FAILURE;
+    }
+  }
+
+  auto fieldMapPtr = fieldMap.release();
+  loadedMap = {fieldMapPtr, fieldMapPtr->lowerCorner(), fieldMapPtr->upperCorner()};
+  if (shareMap && m_sharedMap) {
+    loadedMap.field = publishSharedMap(fieldMapPtr);
+  }
+
+  if (referenceMap) {
+    validateMapPrecision(*loadedMap.field, *referenceMap, loadedMap.lowerCorner, loadedMap.upperCorner);
+  }
+
+  return interpolateMap3D(loadedMap);
+}
+
+
+double SimG4MagneticFieldFromMapTool::additionalFieldBz(double r, double z) const {
+  if ((m_addFieldMaxR.value() <= 0 || r < m_addFieldMaxR.value()) &&
+      (m_addFieldMaxZ.value() <= 0 || std::abs(z) < m_addFieldMaxZ.value())) {
+    return m_addFieldBz.value();
+  }
+  return 0.;
+}
+
+
+void SimG4MagneticFieldFromMapTool::cropToFundamentalDomain(const std::array<const std::vector<double>*, 3>& positions,
+                                                            const std::vector<std::vector<double>*>& columns) const {
+  const std::array<bool, 3> mirror = {m_mirrorX, m_mirrorY, m_mirrorZ};
+  const size_t nNodes = columns.front()->size();
+  std::vector<bool> keep(nNodes, true);
+
+  for (size_t a = 0; a < 3; ++a) {
+    if (!mirror[a] || !positions[a] || nNodes == 0) {
+      continue;
+    }
+    // The last node layer at or below zero is kept, so that the map can be interpolated up to the mirror plane
+    const std::vector<double>& pos = *positions[a];
+    double threshold = *std::min_element(pos.begin(), pos.end());
+    for (double p : pos) {
+      if (p <= 0. && p > threshold) {
+        threshold = p;
+      }
+    }
+    for (size_t i = 0; i < nNodes; ++i) {
+      if (pos[i] < threshold) {
+        keep[i] = false;
+      }
+    }
+  }
+
+  const size_t nKept = std::count(keep.begin(), keep.end(), true);
+  if (nKept == nNodes) {
+    return;
+  }
+  for (auto* column : columns) {
+    size_t j = 0;
+    for (size_t i = 0; i < nNodes; ++i) {
+      if (keep[i]) {
+        (*column)[j++] = (*column)[i];
+      }
+    }
+    column->resize(nKept);
+    column->shrink_to_fit();
+  }
+  info() << "Fieldmap reduced to the fundamental domain of the mirror symmetries: "
+         << nKept << " out of " << nNodes << " nodes kept" << endmsg;
+}
+
+
+template <typename StorageT>
+G4MagneticField* SimG4MagneticFieldFromMapTool::toTricubic(G4MagneticField* field) const {
+  auto regularMap = dynamic_cast<sim::MapField3DRegular<StorageT>*>(field);
+  if (!regularMap) {
+    return nullptr;
+  }
+  G4MagneticField* tricubicMap = new sim::MapField3DTricubic(*regularMap);
+  delete regularMap;
+  return tricubicMap;
+}
+
+
+StatusCode SimG4MagneticFieldFromMapTool::interpolateMap3D(LoadedMap& loadedMap) const {
+  if (m_interpolationMode != "tricubic") {
+    return StatusCode::SUCCESS;
+  }
+
+  G4MagneticField* tricubicMap = toTricubic<double>(loadedMap.field);
+  if (!tricubicMap) {
+    tricubicMap = toTricubic<float>(loadedMap.field);
+  }
+  if (!tricubicMap) {
+    tricubicMap = toTricubic<int16_t>(loadedMap.field);
+  }
+  if (!tricubicMap) {
+    error() << "Tricubic interpolation is available only for the regular 3D fieldmaps!" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  loadedMap.field = tricubicMap;
+  debug() << "Using tricubic interpolation of the fieldmap" << endmsg;
+
+  return StatusCode::SUCCESS;
+}
+
+
+void SimG4MagneticFieldFromMapTool::applySymmetry() {
+  if (!m_mirrorX && !m_mirrorY && !m_mirrorZ && m_phiSymmetryOrder < 2) {
+    return;
+  }
+
+  auto symmetricField = new sim::SymmetricField(m_field);
+  if (m_mirrorX) {
+    symmetricField->setMirror(0, {m_mirrorXParity.value()[0], m_mirrorXParity.value()[1], m_mirrorXParity.value()[2]});
+  }
+  if (m_mirrorY) {
+    symmetricField->setMirror(1, {m_mirrorYParity.value()[0], m_mirrorYParity.value()[1], m_mirrorYParity.value()[2]});
+  }
+  if (m_mirrorZ) {
+    symmetricField->setMirror(2, {m_mirrorZParity.value()[0], m_mirrorZParity.value()[1], m_mirrorZParity.value()[2]});
+  }
+  if (m_phiSymmetryOrder > 1) {
+    symmetricField->setPhiSymmetry(m_phiSymmetryOrder);
+    debug() << "Using " << m_phiSymmetryOrder << "-fold rotational symmetry of the fieldmap" << endmsg;
+  }
+  m_field = symmetricField;
+}
+
+
+StatusCode SimG4MagneticFieldFromMapTool::attachSharedMap(LoadedMap& loadedMap) {
+  if (!m_sharedMapName.empty() && !m_sharedMapFile.empty()) {
+    error() << "Fieldmap can be shared either through shared memory or through a file, not both!" << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  // Everything which influences the content of the map has to be part of the key
+  std::ostringstream description;
+  description << m_mapFilePath.value() << ";" << m_mapPrecision.value() << ";"
+              << m_fieldMaxR.value() << ";" << m_fieldMaxZ.value() << ";"
+              << m_addFieldBz.value() << ";" << m_addFieldMaxR.value() << ";" << m_addFieldMaxZ.value() << ";"
+              << m_mirrorX.value() << m_mirrorY.value() << m_mirrorZ.value();
+  // a map file rewritten under the same name must not attach to the segment of the old one
+  struct stat mapFileStat;
+  if (stat(m_mapFilePath.value().c_str(), &mapFileStat) == 0) {
+    description << ";" << mapFileStat.st_mtime << ";" << mapFileStat.st_size << ";" << mapFileStat.st_ino;
+  } else {
+    warning() << "Can't stat the fieldmap, a modified map file won't be detected: " << m_mapFilePath.value() << endmsg;
+  }
+  const uint64_t key = sim::SharedFieldMap::makeKey(description.str());
+
+  const bool useShm = !m_sharedMapName.empty();
+  const std::string& name = useShm ? m_sharedMapName.value() : m_sharedMapFile.value();
+  try {
+    m_sharedMap = sim::SharedFieldMap::open(name,
+                                            useShm ? sim::SharedFieldMap::Backend::SharedMemory
+                                                   : sim::SharedFieldMap::Backend::File,
+                                            key);
+    if (m_sharedMap->role() == sim::SharedFieldMap::Role::Producer) {
+      info() << "Loading the fieldmap into the shared segment: " << name << endmsg;
+      return StatusCode::SUCCESS;
+    }
+
+    info() << "Waiting for the shared fieldmap: " << name << endmsg;
+    if (m_sharedMap->waitUntilReady(m_sharedMapTimeout)) {
+      auto attach = [&loadedMap](auto* fieldMap) {
+        loadedMap = {fieldMap, fieldMap->lowerCorner(), fieldMap->upperCorner()};
+      };
+      switch (m_storageType) {
+        case sim::FieldStorageType::Float:
+          attach(new sim::MapField3DRegular<float>(m_sharedMap));
+          break;
+        case sim::FieldStorageType::Int16:
+          attach(new sim::MapField3DRegular<int16_t>(m_sharedMap));
+          break;
+        default:
+          attach(new sim::MapField3DRegular<double>(m_sharedMap));
+      }
+      info() << "Attached to the shared fieldmap: " << name << endmsg;
+      return StatusCode::SUCCESS;
+    }
+  } catch (const std::exception& ex) {
+    error() << ex.what() << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  warning() << "Shared fieldmap " << name << " not available, loading private copy of the map!" << endmsg;
+  m_sharedMap.reset();
 
   return StatusCode::SUCCESS;
 }
 
 
+template <typename StorageT>
+G4MagneticField* SimG4MagneticFieldFromMapTool::publishSharedMap(sim::MapField3DRegular<StorageT>* fieldMap) {
+  try {
+    fieldMap->writeShared(*m_sharedMap);
+    m_sharedMap->publish();
+  } catch (const std::exception& ex) {
+    warning() << ex.what() << endmsg;
+    warning() << "Fieldmap will not be shared!" << endmsg;
+    m_sharedMap->abandon();
+    m_sharedMap.reset();
+    return fieldMap;
+  }
+
+  // Switch to the shared copy and release the private one
+  auto sharedFieldMap = new sim::MapField3DRegular<StorageT>(m_sharedMap);
+  delete fieldMap;
+  debug() << "Fieldmap published in the shared segment: " << m_sharedMap->name() << endmsg;
+
+  return sharedFieldMap;
+}
+
+
 StatusCode SimG4MagneticFieldFromMapTool::loadComsolMap() {
   std::ifstream inFile;
   inFile.open(m_mapFilePath.value());
@@ -263,6 +769,10 @@ StatusCode SimG4MagneticFieldFromMapTool::loadComsolMap() {
   debug() << "Loading magnetic field map from file: " << endmsg;
   debug() << "    " << m_mapFilePath.value() << endmsg;
 
+  if (!m_sharedMapName.empty() || !m_sharedMapFile.empty()) {
+    warning() << "Only 3D fieldmaps can be shared, loading private copy of the 2D map!" << endmsg;
+  }
+
   std::string inLine;
   size_t nLines = 0;
   size_t nLinesExpected;
@@ -316,21 +826,7 @@ StatusCode SimG4MagneticFieldFromMapTool::loadComsolMap() {
       continue;
     }
 
-    if (m_addFieldMaxR.value() > 0 && m_addFieldMaxZ.value() > 0) {
-      if(r < m_addFieldMaxR.value() && std::abs(z) < m_addFieldMaxZ.value()) {
-        Bz += m_addFieldBz.value();
-      }
-    } else if (m_addFieldMaxR.value() <= 0 && m_addFieldMaxZ.value() > 0) {
-      if (std::abs(z) < m_addFieldMaxZ.value()) {
-        Bz += m_addFieldBz.value();
-      }
-    } else if (m_addFieldMaxR.value() > 0 && m_addFieldMaxZ.value() <= 0) {
-      if (r < m_addFieldMaxR.value()) {
-        Bz += m_addFieldBz.value();
-      }
-    } else {
-      Bz += m_addFieldBz.value();
-    }
+    Bz += additionalFieldBz(r, z);
 
     fieldPositionR.emplace_back(r);
     fieldPositionZ.emplace_back(z);
@@ -347,14 +843,68 @@ StatusCode SimG4MagneticFieldFromMapTool::loadComsolMap() {
   inFile.close();
 
   debug() << "Loaded map with " << fieldPositionR.size() << " nodes." << endmsg;
+  if (m_mirrorX || m_mirrorY || m_phiSymmetryOrder > 1) {
+    warning() << "2D fieldmap is radially symmetric, only z mirror symmetry is used to reduce it" << endmsg;
+  }
+  cropToFundamentalDomain({nullptr, nullptr, &fieldPositionZ},
+                          {&fieldPositionR, &fieldPositionZ, &fieldComponentR, &fieldComponentZ});
   if (fieldComponentR.size() < 1) {
     error() << "Could not load any mapfield nodes!" << endmsg;
+    error() << "    " << m_mapFilePath.value() << endmsg;
+    return StatusCode::FAILURE;
   }
 
-  m_field = new sim::MapField2DRegular(fieldComponentR,
-                                       fieldComponentZ,
-                                       fieldPositionR,
-                                       fieldPositionZ);
+  try {
+    switch (m_storageType) {
+      case sim::FieldStorageType::Float:
+        m_field = new sim::MapField2DRegular<float>(fieldComponentR, fieldComponentZ,
+                                                    fieldPositionR, fieldPositionZ);
+        break;
+      case sim::FieldStorageType::Int16:
+        m_field = new sim::MapField2DRegular<int16_t>(fieldComponentR, fieldComponentZ,
+                                                      fieldPositionR, fieldPositionZ);
+        break;
+      default:
+        m_field = new sim::MapField2DRegular<double>(fieldComponentR, fieldComponentZ,
+                                                     fieldPositionR, fieldPositionZ);
+    }
+
+    if (m_validationBins > 0 && m_storageType != sim::FieldStorageType::Double) {
+      auto referenceMap = sim::MapField2DRegular<double>(fieldComponentR,
+                                                         fieldComponentZ,
+                                                         fieldPositionR,
+                                                         fieldPositionZ);
+      const double maxR = *std::max_element(fieldPositionR.begin(), fieldPositionR.end());
+      const auto rangeZ = std::minmax_element(fieldPositionZ.begin(), fieldPositionZ.end());
+      validateMapPrecision(*m_field, referenceMap,
+                           {-maxR, -maxR, *rangeZ.first},
+                           {maxR, maxR, *rangeZ.second});
+    }
+  } catch (const std::exception& ex) {
+    error() << "Can't load the fieldmap: " << ex.what() << endmsg;
+    error() << "    " << m_mapFilePath.value() << endmsg;
+    return StatusCode::FAILURE;
+  }
 
   return StatusCode::SUCCESS;
 }
+
+
+void SimG4MagneticFieldFromMapTool::validateMapPrecision(const G4MagneticField& field,
+                                                         const G4MagneticField& reference,
+                                                         const std::array<double, 3>& boxMin,
+                                                         const std::array<double, 3>& boxMax) const {
+  const size_t nBins = m_validationBins.value();
+  const sim::FieldDifference difference = sim::compareFieldsOnGrid(field, reference, boxMin, boxMax,
+                                                                   {nBins, nBins, nBins});
+
+  info() << "Fieldmap stored as '" << m_mapPrecision.value() << "' compared to double precision map in "
+         << difference.nPoints << " points:" << endmsg;
+  const char* components[] = {"Bx", "By", "Bz"};
+  for (size_t c = 0; c < 3; ++c) {
+    info() << "    " << components[c] << ": max. difference = " << difference.maxDiff[c] / tesla
+           << " T, RMS difference = " << difference.rmsDiff[c] / tesla << " T" << endmsg;
+  }
+  info() << "    |B|: max. difference = " << difference.maxDiffMag / tesla
+         << " T, RMS difference = " << difference.rmsDiffMag / tesla << " T" << endmsg;
+}
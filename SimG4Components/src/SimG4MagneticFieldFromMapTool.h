@@ -11,16 +11,25 @@
 #include "G4SystemOfUnits.hh"
 #include "G4MagneticField.hh"
 
+// k4SimGeant4
+#include "SimG4Common/FieldStorage.h"
+
+// ROOT
+#include "ROOT/RDataFrame.hxx"
+
+// STD
+#include <array>
+#include <memory>
+
 // Forward declarations:
 // Geant 4 classes
-class G4MagIntegratorStepper;
 
 // FCCSW
-/*
 namespace sim {
-  class MapField;
+  template <typename StorageT> class MapField3DRegular;
+  class CountingField;
+  class SharedFieldMap;
 }
-*/
 
 /** @class SimG4MagneticFieldFromMapTool SimG4Components/src/SimG4MagneticFieldFromMapTool.h
 * SimG4MagneticFieldFromMapTool.h
@@ -49,9 +58,6 @@ public:
   /// @returns pointer to G4MagneticField
   virtual const G4MagneticField* field() const final;
 
-  /// Get the stepper
-  /// @returns pointer to G4MagIntegratorStepper (ownership is transferred to the caller)
-  G4MagIntegratorStepper* stepper(const std::string&, G4MagneticField*) const;
 
 private:
   /// Pointer to the actual Geant4 magnetic field
@@ -73,8 +79,10 @@ private:
   Gaudi::Property<double> m_maxStep{this, "MaximumStep", 1. * m, "Maximum step length in field (see G4 documentation)"};
   /// Lower limit of the step size, see G4 doc for more details. Set with property MinimumStep
   Gaudi::Property<double> m_minStep{this, "MinimumStep", 0.01 * mm, "Minimum step length in field (see G4 documentation)"};
-  /// Name of the integration stepper, defaults to NystromRK4.
+  /// Name of the integration stepper, defaults to NystromRK4, see SimG4Common/FieldSetup.h
   Gaudi::Property<std::string> m_integratorStepper{this, "IntegratorStepper", "NystromRK4", "Integrator stepper name"};
+  /// Name of the integration driver, defaults to MagIntDriver (G4MagInt_Driver), see SimG4Common/FieldSetup.h
+  Gaudi::Property<std::string> m_integrationDriver{this, "IntegrationDriver", "MagIntDriver", "Integration driver name"};
   /// Path to the input file containing fieldmap
   Gaudi::Property<std::string> m_mapFilePath{this, "MapFile", "", "Path to file containing fieldmap"};
   /// Additional constant field, z component (spans whole z range of the map)
@@ -87,11 +95,115 @@ private:
   Gaudi::Property<double> m_fieldMaxR{this, "FieldMaxR", -1., "Field maximum radius (default: no limit)"};
   /// Maximum field z coordinate (default: no limit)
   Gaudi::Property<double> m_fieldMaxZ{this, "FieldMaxZ", -1., "Field maximum z coordinate (default: no limit)"};
+  /// Storage type of the map values
+  Gaudi::Property<std::string> m_mapPrecision{this, "MapPrecision", "double", "Storage type of the fieldmap values: 'double', 'float' or 'int16' (default: double)"};
+  /// Number of bins per axis of the grid used to validate reduced precision map
+  Gaudi::Property<size_t> m_validationBins{this, "ValidationBins", 0, "Number of bins per axis of the grid on which reduced precision map is compared to the double precision one (default: 0, no validation)"};
+  /// Grid of the 3D map nodes
+  Gaudi::Property<std::string> m_gridType{this, "GridType", "regular", "Grid of the 3D fieldmap nodes: 'regular' or 'rectilinear' (non-uniform spacing along every axis, default: regular)"};
+  /// Path to the file with the fine map used inside its own box, MapFile is used outside
+  Gaudi::Property<std::string> m_innerMapFilePath{this, "InnerMapFile", "", "Path to file containing fine 3D fieldmap used inside its box, MapFile is used elsewhere (default: none)"};
+  /// Number of threads used to load the regular 3D map
+  Gaudi::Property<unsigned> m_loadingThreads{this, "LoadingThreads", 0, "Number of threads reading the regular 3D fieldmap with ROOT implicit multithreading (default: 0, single thread)"};
+  /// Accept regular 3D map with missing nodes, which get zero field
+  Gaudi::Property<bool> m_allowMissingNodes{this, "AllowMissingNodes", false, "Accept regular 3D fieldmap with missing nodes, zero field is used in them (default: false)"};
+  /// Interpolation between the map nodes
+  Gaudi::Property<std::string> m_interpolationMode{this, "InterpolationMode", "linear", "Interpolation between the nodes: 'linear' or 'tricubic' (3D maps only, not with the shared map, default: linear)"};
+  /// Count the field evaluations and report them in finalize
+  Gaudi::Property<bool> m_countFieldCalls{this, "CountFieldCalls", false, "Count the number of field evaluations (default: false)"};
+  /// Mirror symmetry of the field in x, only x >= 0 part of the map is kept
+  Gaudi::Property<bool> m_mirrorX{this, "MirrorX", false, "Field is mirror symmetric in x, only x >= 0 part of the map is used (default: false)"};
+  /// Mirror symmetry of the field in y, only y >= 0 part of the map is kept
+  Gaudi::Property<bool> m_mirrorY{this, "MirrorY", false, "Field is mirror symmetric in y, only y >= 0 part of the map is used (default: false)"};
+  /// Mirror symmetry of the field in z, only z >= 0 part of the map is kept
+  Gaudi::Property<bool> m_mirrorZ{this, "MirrorZ", false, "Field is mirror symmetric in z, only z >= 0 part of the map is used (default: false)"};
+  /// Parity of the (Bx, By, Bz) under the x mirror
+  Gaudi::Property<std::vector<double>> m_mirrorXParity{this, "MirrorXParity", {-1., 1., 1.}, "Parity of (Bx, By, Bz) under the x mirror (default: solenoid)"};
+  /// Parity of the (Bx, By, Bz) under the y mirror
+  Gaudi::Property<std::vector<double>> m_mirrorYParity{this, "MirrorYParity", {1., -1., 1.}, "Parity of (Bx, By, Bz) under the y mirror (default: solenoid)"};
+  /// Parity of the (Bx, By, Bz) under the z mirror
+  Gaudi::Property<std::vector<double>> m_mirrorZParity{this, "MirrorZParity", {-1., -1., 1.}, "Parity of (Bx, By, Bz) under the z mirror (default: solenoid)"};
+  /// Order of the rotational symmetry around z axis, the map has to cover the 0 <= phi < 2pi/N sector
+  Gaudi::Property<unsigned> m_phiSymmetryOrder{this, "PhiSymmetryOrder", 1, "N-fold rotational symmetry around z axis, the map has to cover the 0 <= phi < 2pi/N sector (default: 1, no symmetry)"};
+  /// Name of the POSIX shared memory segment holding the 3D map shared between the processes on the node
+  Gaudi::Property<std::string> m_sharedMapName{this, "SharedMapName", "", "Name of the shared memory segment with the 3D fieldmap, e.g. '/fieldMap' (default: not shared)"};
+  /// Path to the memory mapped file holding the 3D map shared between the processes on the node
+  Gaudi::Property<std::string> m_sharedMapFile{this, "SharedMapFile", "", "Path to the memory mapped file with the 3D fieldmap (default: not shared)"};
+  /// Maximum time to wait for another process to publish the shared map
+  Gaudi::Property<double> m_sharedMapTimeout{this, "SharedMapTimeout", 600., "Maximum time in seconds to wait for the shared fieldmap (default: 600 s)"};
+
+  /// Fieldmap loaded from a file
+  struct LoadedMap {
+    /// The field
+    G4MagneticField* field = nullptr;
+    /// Position of the first node
+    std::array<double, 3> lowerCorner = {0., 0., 0.};
+    /// Position of the last node
+    std::array<double, 3> upperCorner = {0., 0., 0.};
+  };
+  /// Regular grid of the 3D map
+  struct RegularGrid {
+    /// Number of nodes along x, y, z
+    std::array<size_t, 3> shape;
+    /// Position of the first node
+    std::array<double, 3> lowerCorner;
+    /// Position of the last node
+    std::array<double, 3> upperCorner;
+    /// Distance between the nodes
+    std::array<double, 3> step;
+    /// Maximal absolute values of Bx, By, Bz
+    std::array<double, 3> maxAbsValue;
+  };
+  /// Field evaluation counter, if requested
+  sim::CountingField* m_countingField = nullptr;
+  /// Storage type of the map values
+  sim::FieldStorageType m_storageType = sim::FieldStorageType::Double;
+  /// Shared memory segment holding the 3D map
+  std::shared_ptr<sim::SharedFieldMap> m_sharedMap;
 
-  /// Load map from the ROOT file
-  StatusCode loadRootMap();
+  /// Load 3D map from the ROOT file, rectilinear maps are read serially
+  /// @param[in] mapFilePath path to the file
+  /// @param[in] shareMap place the map into the shared segment, if configured
+  /// @param[out] loadedMap the loaded map
+  StatusCode loadRootMap(const std::string& mapFilePath, bool shareMap, LoadedMap& loadedMap);
   /// Load map from the COMSOL export file
   StatusCode loadComsolMap();
+  /// Load regular 3D map from the ROOT file, directly into the grid
+  StatusCode loadRegularRootMap(const std::string& mapFilePath, bool shareMap, LoadedMap& loadedMap);
+  /// Fill the regular 3D map with the requested storage type, check the completeness of the grid
+  template <typename StorageT>
+  StatusCode fillRegularMap(ROOT::RDF::RNode nodes, const RegularGrid& grid, bool shareMap, LoadedMap& loadedMap);
+  /// Additional constant field at the radius and z
+  double additionalFieldBz(double r, double z) const;
+  /// Create rectilinear 3D map with the requested storage type
+  template <typename StorageT>
+  void createRectilinearMap(const std::vector<double>& bX, const std::vector<double>& bY, const std::vector<double>& bZ,
+                            const std::vector<double>& posX, const std::vector<double>& posY,
+                            const std::vector<double>& posZ, LoadedMap& loadedMap);
+  /// Remove nodes outside of the fundamental domain of the mirror symmetries
+  /// @param[in] positions node positions along x, y, z (nullptr if the axis is not present in the map)
+  /// @param[in, out] columns all node quantities (positions and field components), cropped in place
+  void cropToFundamentalDomain(const std::array<const std::vector<double>*, 3>& positions,
+                               const std::vector<std::vector<double>*>& columns) const;
+  /// Replace the regular 3D map by its tricubic interpolation, if requested
+  StatusCode interpolateMap3D(LoadedMap& loadedMap) const;
+  /// Replace the regular 3D map by its tricubic interpolation
+  /// @returns nullptr if the field is not regular 3D map with the given storage type
+  template <typename StorageT>
+  G4MagneticField* toTricubic(G4MagneticField* field) const;
+  /// Wrap the loaded map with the configured symmetries
+  void applySymmetry();
+  /// Attach to the shared map, if it was already loaded by another process
+  StatusCode attachSharedMap(LoadedMap& loadedMap);
+  /// Place freshly loaded map into the shared memory segment
+  /// @returns map using the shared segment, or the original map if it could not be shared
+  template <typename StorageT>
+  G4MagneticField* publishSharedMap(sim::MapField3DRegular<StorageT>* fieldMap);
+  /// Compare the reduced precision map with the double precision one
+  void validateMapPrecision(const G4MagneticField& field,
+                            const G4MagneticField& reference,
+                            const std::array<double, 3>& boxMin,
+                            const std::array<double, 3>& boxMax) const;
 };
 
 #endif
@@ -1,32 +1,97 @@
 #include "SimG4MagneticFieldTool.h"
 
 // k4SimGeant4
+#include "SimG4Common/BatchMagneticField.h"
 #include "SimG4Common/DD4hepField.h"
+#include "SimG4Common/FieldComparison.h"
+#include "SimG4Common/FieldSetup.h"
+#include "SimG4Common/FieldStorage.h"
+#include "SimG4Common/MapField3DRegular.h"
 
 // DD4hep
 #include "DD4hep/Detector.h"
+#include "DD4hep/Shapes.h"
+
+// STD
+#include <array>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
 
 // Geant4
-#include "G4ChordFinder.hh"
 #include "G4FieldManager.hh"
 #include "G4MagneticField.hh"
 #include "G4TransportationManager.hh"
-#include "G4MagIntegratorDriver.hh"
 #include "G4VUserPrimaryGeneratorAction.hh"
 
-#include "G4ClassicalRK4.hh"
-#include "G4HelixExplicitEuler.hh"
-#include "G4ExactHelixStepper.hh"
-#include "G4HelixImplicitEuler.hh"
-#include "G4HelixSimpleRunge.hh"
-#include "G4MagIntegratorStepper.hh"
-#include "G4Mag_UsualEqRhs.hh"
-#include "G4NystromRK4.hh"
 #include "G4PropagatorInField.hh"
 
 // Declaration of the Tool
 DECLARE_COMPONENT(SimG4MagneticFieldTool)
 
+namespace {
+  /// Evaluate the field in the nodes of the regular grid, one row along z at a time
+  /// The function is called with the indices i, j of the row and the field components in its nodes
+  template <typename RowFunction>
+  void evaluateRows(const G4MagneticField& field, const std::array<size_t, 3>& shape,
+                    const std::array<double, 3>& lowerCorner, const std::array<double, 3>& upperCorner,
+                    RowFunction&& function) {
+    std::array<double, 3> step;
+    for (size_t a = 0; a < 3; ++a) {
+      step[a] = (upperCorner[a] - lowerCorner[a]) / (shape[a] - 1);
+    }
+
+    const size_t nRow = shape[2];
+    std::vector<double> x(nRow), y(nRow), z(nRow);
+    std::vector<double> bX(nRow), bY(nRow), bZ(nRow);
+    for (size_t k = 0; k < nRow; ++k) {
+      z[k] = lowerCorner[2] + k * step[2];
+    }
+    for (size_t i = 0; i < shape[0]; ++i) {
+      for (size_t j = 0; j < shape[1]; ++j) {
+        std::fill(x.begin(), x.end(), lowerCorner[0] + i * step[0]);
+        std::fill(y.begin(), y.end(), lowerCorner[1] + j * step[1]);
+        sim::getFieldValues(field, nRow, x.data(), y.data(), z.data(), bX.data(), bY.data(), bZ.data());
+        function(i, j, bX.data(), bY.data(), bZ.data());
+      }
+    }
+  }
+
+  /// Sample the field in the nodes of the regular grid
+  template <typename StorageT>
+  std::unique_ptr<sim::MapField3DRegular<StorageT>> sampleField(const G4MagneticField& field,
+                                                                const std::array<size_t, 3>& shape,
+                                                                const std::array<double, 3>& lowerCorner,
+                                                                const std::array<double, 3>& upperCorner,
+                                                                const std::array<double, 3>& maxAbsValues) {
+    auto fieldMap = std::make_unique<sim::MapField3DRegular<StorageT>>(shape, lowerCorner, upperCorner, maxAbsValues);
+    evaluateRows(field, shape, lowerCorner, upperCorner,
+                 [&](size_t i, size_t j, const double* bX, const double* bY, const double* bZ) {
+                   for (size_t k = 0; k < shape[2]; ++k) {
+                     const double bField[3] = {bX[k], bY[k], bZ[k]};
+                     fieldMap->setNode(i, j, k, bField);
+                   }
+                 });
+    return fieldMap;
+  }
+
+  /// Maximal absolute values of the field components in the nodes of the regular grid
+  std::array<double, 3> maxAbsField(const G4MagneticField& field, const std::array<size_t, 3>& shape,
+                                    const std::array<double, 3>& lowerCorner,
+                                    const std::array<double, 3>& upperCorner) {
+    std::array<double, 3> maxAbsValues = {0., 0., 0.};
+    evaluateRows(field, shape, lowerCorner, upperCorner,
+                 [&](size_t, size_t, const double* bX, const double* bY, const double* bZ) {
+                   for (size_t k = 0; k < shape[2]; ++k) {
+                     maxAbsValues[0] = std::max(maxAbsValues[0], std::fabs(bX[k]));
+                     maxAbsValues[1] = std::max(maxAbsValues[1], std::fabs(bY[k]));
+                     maxAbsValues[2] = std::max(maxAbsValues[2], std::fabs(bZ[k]));
+                   }
+                 });
+    return maxAbsValues;
+  }
+}
+
 SimG4MagneticFieldTool::SimG4MagneticFieldTool(const std::string& type,
                                                const std::string& name,
                                                const IInterface* parent)
@@ -66,22 +131,125 @@ StatusCode SimG4MagneticFieldTool::initialize() {
   G4FieldManager* fieldManager = transpManager->GetFieldManager();
   G4PropagatorInField* propagator = transpManager->GetPropagatorInField();
 
-  m_field = new k4simgeant4::DD4hepField(detDescription->field());
-  fieldManager->SetDetectorField(m_field);
+  auto dd4hepField = std::make_unique<k4simgeant4::DD4hepField>(detDescription->field());
+  if (m_cacheField) {
+    if (cacheField(*dd4hepField).isFailure()) {
+      return StatusCode::FAILURE;
+    }
+  } else {
+    m_field = dd4hepField.release();
+  }
   fieldManager->SetFieldChangesEnergy(detDescription->field().changesEnergy());
 
-  G4ChordFinder* chordFinder = new G4ChordFinder(m_field,
-                                                 m_minStep,
-                                                 stepper(m_integratorStepper,
-                                                         m_field));
-  fieldManager->SetChordFinder(chordFinder);
+  sim::FieldPropagationParameters parameters;
+  parameters.stepper = m_integratorStepper;
+  parameters.driver = m_integrationDriver;
+  parameters.minStep = m_minStep;
+  parameters.deltaChord = m_deltaChord;
+  parameters.deltaOneStep = m_deltaOneStep;
+  parameters.minEpsilon = m_minEps;
+  parameters.maxEpsilon = m_maxEps;
+  try {
+    sim::setupFieldManager(*fieldManager, m_field, parameters);
+  } catch (const std::invalid_argument& e) {
+    error() << e.what() << endmsg;
+    return StatusCode::FAILURE;
+  }
 
   propagator->SetLargestAcceptableStep(m_maxStep);
 
-  if (m_deltaChord > 0) fieldManager->GetChordFinder()->SetDeltaChord(m_deltaChord);
-  if (m_deltaOneStep > 0) fieldManager->SetDeltaOneStep(m_deltaOneStep);
-  if (m_minEps > 0) fieldManager->SetMinimumEpsilonStep(m_minEps);
-  if (m_maxEps > 0) fieldManager->SetMaximumEpsilonStep(m_maxEps);
+  return StatusCode::SUCCESS;
+}
+
+
+StatusCode SimG4MagneticFieldTool::cacheField(const G4MagneticField& dd4hepField) {
+  sim::FieldStorageType storageType;
+  if (!sim::parseFieldStorageType(m_cachePrecision, storageType)) {
+    error() << "Unknown storage type of the cached field: " << m_cachePrecision.value() << endmsg;
+    error() << "Supported storage types: double, float, int16" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  if (m_cacheGridStep <= 0.) {
+    error() << "Spacing of the cached field nodes has to be positive!" << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  std::array<double, 3> lowerCorner;
+  std::array<double, 3> upperCorner;
+  if (m_cacheBox.value().empty()) {
+    // Every ROOT shape provides its bounding box
+    const dd4hep::Box worldBox(m_geoSvc->getDetector()->worldVolume().solid());
+    const double halfLengths[3] = {worldBox.x(), worldBox.y(), worldBox.z()};
+    for (size_t a = 0; a < 3; ++a) {
+      upperCorner[a] = halfLengths[a] / dd4hep::mm * CLHEP::mm;
+      lowerCorner[a] = -upperCorner[a];
+    }
+  } else if (m_cacheBox.value().size() == 6) {
+    for (size_t a = 0; a < 3; ++a) {
+      lowerCorner[a] = m_cacheBox.value().at(2 * a);
+      upperCorner[a] = m_cacheBox.value().at(2 * a + 1);
+    }
+  } else {
+    error() << "Box of the cached field has to be defined by xMin, xMax, yMin, yMax, zMin and zMax!" << endmsg;
+    return StatusCode::FAILURE;
+  }
+
+  // The grid starts in the lower corner and covers the whole box
+  // The size is checked before anything is allocated, in double to avoid overflows of the node count
+  std::array<double, 3> nNodes;
+  for (size_t a = 0; a < 3; ++a) {
+    if (upperCorner[a] <= lowerCorner[a]) {
+      error() << "Box of the cached field has empty extent!" << endmsg;
+      return StatusCode::FAILURE;
+    }
+    nNodes[a] = std::ceil((upperCorner[a] - lowerCorner[a]) / m_cacheGridStep - 1e-6) + 1;
+  }
+  const double memory = nNodes[0] * nNodes[1] * nNodes[2] * 3 * sim::fieldStorageSize(storageType) / 1024. / 1024.;
+  if (memory > m_cacheMaxMemory) {
+    error() << "Cached field with " << nNodes[0] << " x " << nNodes[1] << " x " << nNodes[2] << " nodes needs "
+            << memory << " MB, more than CacheMaxMemory = " << m_cacheMaxMemory.value() << " MB." << endmsg;
+    error() << "Restrict CacheBox to the extent of the field or increase CacheGridStep." << endmsg;
+    return StatusCode::FAILURE;
+  }
+  std::array<size_t, 3> shape;
+  for (size_t a = 0; a < 3; ++a) {
+    shape[a] = nNodes[a];
+    upperCorner[a] = lowerCorner[a] + (shape[a] - 1) * m_cacheGridStep;
+  }
+  info() << "Caching the field in " << shape[0] << " x " << shape[1] << " x " << shape[2]
+         << " nodes with step " << m_cacheGridStep.value() << " mm, from (" << lowerCorner[0] << ", "
+         << lowerCorner[1] << ", " << lowerCorner[2] << ") mm to (" << upperCorner[0] << ", "
+         << upperCorner[1] << ", " << upperCorner[2] << ") mm" << endmsg;
+
+  // The quantized storage needs the maximal values, the field is evaluated twice instead of keeping
+  // a double precision copy of the grid
+  switch (storageType) {
+    case sim::FieldStorageType::Float:
+      m_field = sampleField<float>(dd4hepField, shape, lowerCorner, upperCorner, {0., 0., 0.}).release();
+      break;
+    case sim::FieldStorageType::Int16:
+      m_field = sampleField<int16_t>(dd4hepField, shape, lowerCorner, upperCorner,
+                                     maxAbsField(dd4hepField, shape, lowerCorner, upperCorner)).release();
+      break;
+    default:
+      m_field = sampleField<double>(dd4hepField, shape, lowerCorner, upperCorner, {0., 0., 0.}).release();
+  }
+
+  if (m_cacheValidationBins > 0) {
+    const size_t nBins = m_cacheValidationBins.value();
+    const sim::FieldDifference difference = sim::compareFieldsOnGrid(*m_field, dd4hepField,
+                                                                     lowerCorner, upperCorner,
+                                                                     {nBins, nBins, nBins});
+
+    info() << "Cached field compared to the DD4hep field in " << difference.nPoints << " points:" << endmsg;
+    const char* components[] = {"Bx", "By", "Bz"};
+    for (size_t c = 0; c < 3; ++c) {
+      info() << "    " << components[c] << ": max. difference = " << difference.maxDiff[c] / tesla
+             << " T, RMS difference = " << difference.rmsDiff[c] / tesla << " T" << endmsg;
+    }
+    info() << "    |B|: max. difference = " << difference.maxDiffMag / tesla
+           << " T, RMS difference = " << difference.rmsDiffMag / tesla << " T" << endmsg;
+  }
 
   return StatusCode::SUCCESS;
 }
@@ -97,25 +265,3 @@ StatusCode SimG4MagneticFieldTool::finalize() {
 const G4MagneticField* SimG4MagneticFieldTool::field() const {
   return m_field;
 }
-
-
-G4MagIntegratorStepper* SimG4MagneticFieldTool::stepper(const std::string& name,
-                                                        G4MagneticField* field) const {
-  G4Mag_UsualEqRhs* fEquation = new G4Mag_UsualEqRhs(field);
-  if (name == "HelixImplicitEuler")
-    return new G4HelixImplicitEuler(fEquation);
-  else if (name == "HelixSimpleRunge")
-    return new G4HelixSimpleRunge(fEquation);
-  else if (name == "HelixExplicitEuler")
-    return new G4HelixExplicitEuler(fEquation);
-  else if (name == "NystromRK4")
-    return new G4NystromRK4(fEquation);
-  else if (name == "ClassicalRK4")
-    return new G4ClassicalRK4(fEquation);
-  else if (name == "ExactHelix")
-    return new G4ExactHelixStepper(fEquation);
-  else {
-    error() << "Stepper " << name << " not available! Returning NystromRK4!" << endmsg;
-    return new G4NystromRK4(fEquation);
-  }
-}
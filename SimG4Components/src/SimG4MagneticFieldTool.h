@@ -12,9 +12,12 @@
 #include "G4SystemOfUnits.hh"
 #include "G4MagneticField.hh"
 
+// STD
+#include <string>
+#include <vector>
+
 // Forward declarations:
 // Geant4 classes
-class G4MagIntegratorStepper;
 
 
 /** @class SimG4MagneticFieldTool SimG4Components/src/SimG4MagneticFieldTool.h
@@ -23,6 +26,15 @@ class G4MagIntegratorStepper;
 *  Implementation of ISimG4MagneticFieldTool that propagates magnetic field
 *  defined in the DD4hep compact file.
 *
+*  Every evaluation of the DD4hep field loops over all overlaid field components.
+*  With CacheField the field is sampled once at initialization into a regular 3D
+*  grid (CacheGridStep apart, spanning CacheBox or the bounding box of the world
+*  volume) and tracking interpolates the grid linearly. Grids needing more than
+*  CacheMaxMemory MB are rejected, so CacheBox should be restricted to the extent
+*  of the field for large worlds. The cached field is
+*  compared to the DD4hep field in the centres of CacheValidationBins^3 bins and
+*  the differences are reported. Outside of the grid the cached field is zero.
+*
 *  @author Juraj Smiesko
 *  @date   2023-06-21
 */
@@ -47,9 +59,6 @@ public:
   /// @returns pointer to G4MagneticField
   virtual const G4MagneticField* field() const final;
 
-  /// Get the stepper
-  /// @returns pointer to G4MagIntegratorStepper (ownership is transferred to the caller)
-  G4MagIntegratorStepper* stepper(const std::string&, G4MagneticField*) const;
 
 private:
   /// Pointer to the geometry service
@@ -82,8 +91,27 @@ private:
   /// Lower limit of the step size, see G4 doc for more details. Set with property MinimumStep
   Gaudi::Property<double> m_minStep{this, "MinimumStep", 0.01 * mm, "Minimum step length in field (see G4 documentation)"};
 
-  /// Name of the integration stepper, defaults to NystromRK4.
+  /// Name of the integration stepper, defaults to NystromRK4, see SimG4Common/FieldSetup.h
   Gaudi::Property<std::string> m_integratorStepper{this, "IntegratorStepper", "NystromRK4", "Integrator stepper name"};
+  /// Name of the integration driver, defaults to MagIntDriver (G4MagInt_Driver), see SimG4Common/FieldSetup.h
+  Gaudi::Property<std::string> m_integrationDriver{this, "IntegrationDriver", "MagIntDriver", "Integration driver name"};
+
+  /// Switch to sample the field into the regular grid at initialization. Set with property CacheField
+  Gaudi::Property<bool> m_cacheField{this, "CacheField", false, "Sample the field into a regular 3D grid used in tracking (default: false)"};
+  /// Spacing of the grid nodes. Set with property CacheGridStep
+  Gaudi::Property<double> m_cacheGridStep{this, "CacheGridStep", 50. * mm, "Spacing of the nodes of the cached field (default: 50 mm)"};
+  /// Box covered by the grid. Set with property CacheBox
+  Gaudi::Property<std::vector<double>> m_cacheBox{this, "CacheBox", {}, "Box covered by the cached field: xMin, xMax, yMin, yMax, zMin, zMax (default: bounding box of the world volume)"};
+  /// Storage type of the grid nodes. Set with property CachePrecision
+  Gaudi::Property<std::string> m_cachePrecision{this, "CachePrecision", "double", "Storage type of the cached field values: 'double', 'float' or 'int16' (default: double)"};
+  /// Upper limit of the memory of the grid in MB. Set with property CacheMaxMemory
+  Gaudi::Property<double> m_cacheMaxMemory{this, "CacheMaxMemory", 1024., "Maximum memory of the cached field in MB, larger grids are rejected at initialization (default: 1024)"};
+  /// Number of bins per axis of the validation grid. Set with property CacheValidationBins
+  Gaudi::Property<size_t> m_cacheValidationBins{this, "CacheValidationBins", 20, "Number of bins per axis of the grid on which the cached field is compared to the DD4hep field (default: 20, 0 disables the comparison)"};
+
+  /// Sample the field into the regular grid, the grid becomes the propagated field
+  /// @param[in] dd4hepField the sampled DD4hep field
+  StatusCode cacheField(const G4MagneticField& dd4hepField);
 };
 
 #endif /* SIMG4COMPONENTS_G4MAGNETICFIELDTOOL_H */
@@ -0,0 +1,36 @@
+from fieldMapUtils import idea_geometry, write_regular_map
+
+# Small regular 3D fieldmap with three nodes missing, one of them in the corner of the grid
+write_regular_map("testfield3d_incomplete.root",
+                  skip=[(500., 1000., 3000.), (-1000., 0., -5000.), (2000., 2000., 6000.)])
+
+
+from Gaudi.Configuration import INFO, DEBUG
+
+from Configurables import ApplicationMgr
+ApplicationMgr().EvtSel = 'NONE'
+ApplicationMgr().EvtMax = 2
+ApplicationMgr().OutputLevel = INFO
+
+
+geoservice = idea_geometry()
+ApplicationMgr().ExtSvc += [geoservice]
+
+
+# Map is read by several threads, the missing nodes have to be counted and reported in the order of the grid
+# with zero field in them
+from Configurables import SimG4MagneticFieldFromMapTool
+field = SimG4MagneticFieldFromMapTool("SimG4MagneticFieldFromMapTool")
+field.MapFile = "testfield3d_incomplete.root"
+field.LoadingThreads = 4
+field.AllowMissingNodes = True
+field.FieldOn = True
+field.IntegratorStepper = "ClassicalRK4"
+field.OutputLevel = DEBUG
+
+
+from Configurables import SimG4Svc
+geantservice = SimG4Svc("SimG4Svc")
+geantservice.magneticField = field
+geantservice.OutputLevel = DEBUG
+ApplicationMgr().ExtSvc += [geantservice]
@@ -0,0 +1,34 @@
+from fieldMapUtils import idea_geometry, regular_xs, regular_ys, write_map
+
+# Rectilinear map of the z < 0 half only, that does not match the mirror symmetry in z:
+# the fundamental domain keeps only the layer closest to z = 0, the job has to fail with an error
+write_map("testfield3d_negativez.root", regular_xs, regular_ys, [i * 1000. for i in range(-6, 0)])
+
+
+from Gaudi.Configuration import INFO, DEBUG
+
+from Configurables import ApplicationMgr
+ApplicationMgr().EvtSel = 'NONE'
+ApplicationMgr().EvtMax = 1
+ApplicationMgr().OutputLevel = INFO
+
+
+geoservice = idea_geometry()
+ApplicationMgr().ExtSvc += [geoservice]
+
+
+from Configurables import SimG4MagneticFieldFromMapTool
+field = SimG4MagneticFieldFromMapTool("SimG4MagneticFieldFromMapTool")
+field.MapFile = "testfield3d_negativez.root"
+field.GridType = "rectilinear"
+field.MirrorZ = True
+field.FieldOn = True
+field.IntegratorStepper = "ClassicalRK4"
+field.OutputLevel = DEBUG
+
+
+from Configurables import SimG4Svc
+geantservice = SimG4Svc("SimG4Svc")
+geantservice.magneticField = field
+geantservice.OutputLevel = DEBUG
+ApplicationMgr().ExtSvc += [geantservice]
@@ -0,0 +1,39 @@
+from fieldMapUtils import idea_geometry, regular_xs, regular_ys, regular_zs, write_map
+
+
+# Coarse regular map of the whole detector
+write_map("testfield3d_outer.root", regular_xs, regular_ys, regular_zs)
+# Fine map around the coil edge, denser near x, y = +-1500 mm
+coil = [-2000., -1750., -1600., -1550., -1500., -1450., -1400., -1250., -1000., -500.,
+        0., 500., 1000., 1250., 1400., 1450., 1500., 1550., 1600., 1750., 2000.]
+write_map("testfield3d_inner.root", coil, coil, [i * 250. for i in range(-8, 9)])
+
+
+from Gaudi.Configuration import INFO, DEBUG
+
+from Configurables import ApplicationMgr
+ApplicationMgr().EvtSel = 'NONE'
+ApplicationMgr().EvtMax = 2
+ApplicationMgr().OutputLevel = INFO
+
+
+geoservice = idea_geometry()
+ApplicationMgr().ExtSvc += [geoservice]
+
+
+# Fine rectilinear map inside the coarse regular one
+from Configurables import SimG4MagneticFieldFromMapTool
+field = SimG4MagneticFieldFromMapTool("SimG4MagneticFieldFromMapTool")
+field.MapFile = "testfield3d_outer.root"
+field.InnerMapFile = "testfield3d_inner.root"
+field.GridType = "rectilinear"
+field.FieldOn = True
+field.IntegratorStepper = "ClassicalRK4"
+field.OutputLevel = DEBUG
+
+
+from Configurables import SimG4Svc
+geantservice = SimG4Svc("SimG4Svc")
+geantservice.magneticField = field
+geantservice.OutputLevel = DEBUG
+ApplicationMgr().ExtSvc += [geantservice]
@@ -0,0 +1,72 @@
+import math
+
+from fieldMapUtils import idea_geometry, regular_xs, regular_ys, regular_zs, write_map
+
+
+# Small regular 3D fieldmap of a smooth field, so that the nodes are not multiples of the quantization step
+def smooth_field(x, y, z):
+    return 0.1 * math.sin(z / 4000.), 0., 2. * math.cos(x / 3000.) * math.cos(y / 3000.) * math.cos(z / 8000.)
+
+
+write_map("testfield3d_precision.root", regular_xs, regular_ys, regular_zs, field=smooth_field)
+
+
+from Gaudi.Configuration import INFO, DEBUG
+
+from Configurables import ApplicationMgr
+ApplicationMgr().EvtSel = 'NONE'
+ApplicationMgr().EvtMax = 2
+ApplicationMgr().OutputLevel = INFO
+
+
+geoservice = idea_geometry()
+ApplicationMgr().ExtSvc += [geoservice]
+
+
+# Map stored as 16-bit integers, compared to the double precision map after loading
+from Configurables import SimG4MagneticFieldFromMapTool
+field = SimG4MagneticFieldFromMapTool("SimG4MagneticFieldFromMapTool")
+field.MapFile = "testfield3d_precision.root"
+field.MapPrecision = "int16"
+field.ValidationBins = 20
+field.FieldOn = True
+field.IntegratorStepper = "ClassicalRK4"
+field.OutputLevel = DEBUG
+
+
+from Configurables import SimG4Svc
+geantservice = SimG4Svc("SimG4Svc")
+geantservice.magneticField = field
+geantservice.OutputLevel = DEBUG
+ApplicationMgr().ExtSvc += [geantservice]
+
+
+# Error of the int16 map with respect to the double precision one: the nodes are rounded to the
+# quantization step of 2 T / 32767 = 6.1e-5 T, so with linear interpolation the field differs
+# by at most half of the step
+from GaudiKernel.SystemOfUnits import tesla, m
+quantizedField = SimG4MagneticFieldFromMapTool("QuantizedField")
+quantizedField.MapFile = "testfield3d_precision.root"
+quantizedField.MapPrecision = "int16"
+quantizedField.FieldOn = True
+
+referenceField = SimG4MagneticFieldFromMapTool("DoublePrecisionField")
+referenceField.MapFile = "testfield3d_precision.root"
+referenceField.MapPrecision = "double"
+referenceField.FieldOn = True
+
+from Configurables import MagFieldComparator
+comparator = MagFieldComparator("MagFieldComparator")
+comparator.field = quantizedField
+comparator.referenceField = referenceField
+comparator.regions = [
+#   rMin,   rMax,   zMin,  zMax
+    [0,     1.4*m,  -6*m,  6*m],
+    [1.4*m, 2*m,    -6*m,  6*m],
+]
+comparator.regionNames = ["inside", "edge"]
+comparator.sampling = "random"
+comparator.nSamples = 100000
+comparator.nRepetitions = 1
+comparator.maxDiffTolerance = 3.1e-5 * tesla
+ApplicationMgr().ExtSvc += [comparator]
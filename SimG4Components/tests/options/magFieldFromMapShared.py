@@ -0,0 +1,37 @@
+import os
+
+from fieldMapUtils import idea_geometry, write_regular_map
+
+# Small regular 3D fieldmap, written only once: the file identity is part of the key of the shared map
+if not os.path.exists("testfield3d.root"):
+    write_regular_map("testfield3d.root")
+
+
+from Gaudi.Configuration import INFO, DEBUG
+
+from Configurables import ApplicationMgr
+ApplicationMgr().EvtSel = 'NONE'
+ApplicationMgr().EvtMax = 2
+ApplicationMgr().OutputLevel = INFO
+
+
+geoservice = idea_geometry()
+ApplicationMgr().ExtSvc += [geoservice]
+
+
+# The first job on the node loads the map into the memory mapped file,
+# the following ones attach to it
+from Configurables import SimG4MagneticFieldFromMapTool
+field = SimG4MagneticFieldFromMapTool("SimG4MagneticFieldFromMapTool")
+field.MapFile = "testfield3d.root"
+field.SharedMapFile = "testfield3d.fieldmap"
+field.FieldOn = True
+field.IntegratorStepper = "ClassicalRK4"
+field.OutputLevel = DEBUG
+
+
+from Configurables import SimG4Svc
+geantservice = SimG4Svc("SimG4Svc")
+geantservice.magneticField = field
+geantservice.OutputLevel = DEBUG
+ApplicationMgr().ExtSvc += [geantservice]
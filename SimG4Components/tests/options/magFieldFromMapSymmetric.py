@@ -0,0 +1,66 @@
+from fieldMapUtils import idea_geometry, write_regular_map
+
+# Small regular 3D fieldmap
+write_regular_map("testfield3d_symmetric.root")
+
+
+from Gaudi.Configuration import INFO, DEBUG
+
+from Configurables import ApplicationMgr
+ApplicationMgr().EvtSel = 'NONE'
+ApplicationMgr().EvtMax = 2
+ApplicationMgr().OutputLevel = INFO
+
+
+geoservice = idea_geometry()
+ApplicationMgr().ExtSvc += [geoservice]
+
+
+# Solenoid-like map, only the x, y, z >= 0 octant is kept in the memory
+# and compared to the full map below
+from Configurables import SimG4MagneticFieldFromMapTool
+field = SimG4MagneticFieldFromMapTool("SimG4MagneticFieldFromMapTool")
+field.MapFile = "testfield3d_symmetric.root"
+field.MirrorX = True
+field.MirrorY = True
+field.MirrorZ = True
+field.FieldOn = True
+field.IntegratorStepper = "ClassicalRK4"
+field.OutputLevel = DEBUG
+
+
+from Configurables import SimG4Svc
+geantservice = SimG4Svc("SimG4Svc")
+geantservice.magneticField = field
+geantservice.OutputLevel = DEBUG
+ApplicationMgr().ExtSvc += [geantservice]
+
+
+# The mirrored map has to reproduce the field of the full map
+from GaudiKernel.SystemOfUnits import tesla, m
+mirroredField = SimG4MagneticFieldFromMapTool("MirroredField")
+mirroredField.MapFile = "testfield3d_symmetric.root"
+mirroredField.MirrorX = True
+mirroredField.MirrorY = True
+mirroredField.MirrorZ = True
+mirroredField.FieldOn = True
+
+fullField = SimG4MagneticFieldFromMapTool("FullField")
+fullField.MapFile = "testfield3d_symmetric.root"
+fullField.FieldOn = True
+
+from Configurables import MagFieldComparator
+comparator = MagFieldComparator("MagFieldComparator")
+comparator.field = mirroredField
+comparator.referenceField = fullField
+comparator.regions = [
+#   rMin,   rMax,   zMin,  zMax
+    [0,     1.4*m,  -6*m,  6*m],
+    [1.4*m, 2*m,    -6*m,  6*m],
+]
+comparator.regionNames = ["inside", "edge"]
+comparator.sampling = "random"
+comparator.nSamples = 100000
+comparator.nRepetitions = 1
+comparator.maxDiffTolerance = 1e-9 * tesla
+ApplicationMgr().ExtSvc += [comparator]
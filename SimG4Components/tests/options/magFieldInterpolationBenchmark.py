@@ -0,0 +1,83 @@
+# Benchmark of the fieldmap interpolation modes and of the field integration steppers
+# Muons are propagated through the IDEA detector in a solenoid-like field given by the 3D fieldmap.
+# The number of field evaluations (SimG4MagneticFieldFromMapTool) and the number of steps per track
+# (SimG4FullSimActions) are printed at the end of the job. Run it with
+#   FIELD_INTERPOLATION=linear k4run magFieldInterpolationBenchmark.py
+#   FIELD_INTERPOLATION=tricubic k4run magFieldInterpolationBenchmark.py
+# and optionally tune the propagation accuracy with FIELD_DELTA_ONE_STEP and FIELD_DELTA_CHORD (in mm).
+# The stepper and the integration driver are chosen with FIELD_STEPPER and FIELD_DRIVER, e.g.
+#   FIELD_STEPPER=DormandPrince745 FIELD_DRIVER=InterpolationDriver k4run magFieldInterpolationBenchmark.py
+
+import os
+import math
+
+from GaudiKernel.SystemOfUnits import GeV, mm
+
+from fieldMapUtils import idea_geometry, write_map
+
+interpolation = os.environ.get("FIELD_INTERPOLATION", "tricubic")
+delta_one_step = float(os.environ.get("FIELD_DELTA_ONE_STEP", "0"))
+delta_chord = float(os.environ.get("FIELD_DELTA_CHORD", "0"))
+stepper = os.environ.get("FIELD_STEPPER", "NystromRK4")
+driver = os.environ.get("FIELD_DRIVER", "MagIntDriver")
+
+
+# Solenoid-like field: 2 T inside the coil (R < 2.5 m), smooth fringe field at the coil ends
+def solenoid_field(x, y, z):
+    r = math.hypot(x, y)
+    radial = 0.5 * (1. - math.tanh((r - 2500.) / 300.))
+    longitudinal = 0.5 * (1. - math.tanh((abs(z) - 3000.) / 400.))
+    dlong = -0.5 / 400. / math.cosh((abs(z) - 3000.) / 400.)**2 * math.copysign(1., z)
+    br = -0.5 * r * 2. * radial * dlong
+    return (br * x / r if r > 0 else 0.), (br * y / r if r > 0 else 0.), 2. * radial * longitudinal
+
+
+mapfile_name = "testfield3d_solenoid.root"
+if not os.path.exists(mapfile_name):
+    write_map(mapfile_name, [i * 250. for i in range(-12, 13)], [i * 250. for i in range(-12, 13)],
+              [i * 250. for i in range(-16, 17)], field=solenoid_field)
+
+
+from Gaudi.Configuration import INFO
+
+from Configurables import FCCDataSvc
+podioevent = FCCDataSvc("EventDataSvc")
+
+geoservice = idea_geometry()
+
+from Configurables import SimG4MagneticFieldFromMapTool
+field = SimG4MagneticFieldFromMapTool("SimG4MagneticFieldFromMapTool")
+field.MapFile = mapfile_name
+field.FieldOn = True
+field.InterpolationMode = interpolation
+field.CountFieldCalls = True
+field.IntegratorStepper = stepper
+field.IntegrationDriver = driver
+if delta_one_step > 0:
+    field.DeltaOneStep = delta_one_step * mm
+if delta_chord > 0:
+    field.DeltaChord = delta_chord * mm
+
+from Configurables import SimG4FullSimActions
+actions = SimG4FullSimActions()
+actions.countSteps = True
+
+from Configurables import SimG4Svc
+geantservice = SimG4Svc("SimG4Svc", detector='SimG4DD4hepDetector', physicslist="SimG4FtfpBert", actions=actions)
+geantservice.magneticField = field
+# Fixed seed, so that the interpolation modes and the steppers see the same events
+geantservice.randomNumbersFromGaudi = False
+geantservice.seedValue = 4242
+
+from Configurables import SimG4Alg, SimG4SingleParticleGeneratorTool
+pgun = SimG4SingleParticleGeneratorTool("SimG4SingleParticleGeneratorTool",
+                                        particleName="mu-", energyMin=1 * GeV, energyMax=10 * GeV,
+                                        etaMin=-2., etaMax=2.)
+geantsim = SimG4Alg("SimG4Alg", eventProvider=pgun)
+
+from Configurables import ApplicationMgr
+ApplicationMgr(TopAlg=[geantsim],
+               EvtSel='NONE',
+               EvtMax=20,
+               ExtSvc=[podioevent, geoservice, geantservice],
+               OutputLevel=INFO)
@@ -0,0 +1,54 @@
+# Calorimeter with its own field manager: cheaper stepper and looser accuracy than in the tracker
+import os
+
+from Gaudi.Configuration import INFO
+from GaudiKernel.SystemOfUnits import GeV, mm, tesla, m
+
+from Configurables import FCCDataSvc
+podioevent = FCCDataSvc("EventDataSvc")
+
+from Configurables import GeoSvc
+geoservice = GeoSvc("GeoSvc")
+path_to_detectors = os.environ.get("FCCDETECTORS", "")
+detectors_to_use = [
+    'Detector/DetFCCeeIDEA-LAr/compact/FCCee_DectMaster.xml',
+]
+geoservice.detectors = [os.path.join(path_to_detectors, _det) for _det in detectors_to_use]
+geoservice.OutputLevel = INFO
+
+from Configurables import SimG4ConstantMagneticFieldTool
+field = SimG4ConstantMagneticFieldTool("SimG4ConstantMagneticFieldTool")
+field.FieldComponentZ = -2 * tesla
+field.FieldRMax = 5 * m
+field.FieldZMax = 6 * m
+field.FieldOn = True
+field.IntegratorStepper = "ClassicalRK4"
+
+from Configurables import SimG4FieldRegion
+calofield = SimG4FieldRegion("CaloField")
+calofield.volumeNames = ["ECalBarrel"]
+calofield.IntegratorStepper = "HelixSimpleRunge"
+calofield.DeltaOneStep = 1 * mm
+calofield.DeltaChord = 1 * mm
+
+from Configurables import SimG4FullSimActions
+actions = SimG4FullSimActions()
+actions.countSteps = True
+
+from Configurables import SimG4Svc
+geantservice = SimG4Svc("SimG4Svc", detector='SimG4DD4hepDetector', physicslist="SimG4FtfpBert", actions=actions)
+geantservice.magneticField = field
+geantservice.regions = ["SimG4FieldRegion/CaloField"]
+
+from Configurables import SimG4Alg, SimG4SingleParticleGeneratorTool
+pgun = SimG4SingleParticleGeneratorTool("SimG4SingleParticleGeneratorTool",
+                                        particleName="e-", energyMin=5 * GeV, energyMax=5 * GeV,
+                                        etaMin=-0.5, etaMax=0.5)
+geantsim = SimG4Alg("SimG4Alg", eventProvider=pgun)
+
+from Configurables import ApplicationMgr
+ApplicationMgr(TopAlg=[geantsim],
+               EvtSel='NONE',
+               EvtMax=5,
+               ExtSvc=[podioevent, geoservice, geantservice],
+               OutputLevel=INFO)
@@ -1,6 +1,12 @@
 import os
 
-testcompact = open('testdet.xml', 'w')
+# FIELD_CACHE=1 samples the field into the regular grid covering the quadrupole
+# The cached job writes its own files, so that both jobs can run at the same time
+cache_field = os.environ.get("FIELD_CACHE", "0") == "1"
+file_suffix = "_cached" if cache_field else ""
+compact_name = "testdet{}.xml".format(file_suffix)
+
+testcompact = open(compact_name, 'w')
 testcompact.write('<?xml version="1.0" encoding="UTF-8"?>\n')
 testcompact.write('<lccdd xmlns:compact="http://www.lcsim.org/schemas/compact/1.0"\n')
 testcompact.write('       xmlns:xs="http://www.w3.org/2001/XMLSchema"\n')
@@ -55,7 +61,7 @@ testcompact.close()
 
 from Gaudi.Configuration import INFO, DEBUG
 from GaudiKernel.PhysicalConstants import pi
-from GaudiKernel.SystemOfUnits import GeV
+from GaudiKernel.SystemOfUnits import GeV, mm, m
 
 from Configurables import ApplicationMgr
 ApplicationMgr().EvtSel = 'NONE'
@@ -71,7 +77,7 @@ ApplicationMgr().ExtSvc += [podioevent]
 # Detector geometry
 from Configurables import GeoSvc
 geoservice = GeoSvc("GeoSvc")
-geoservice.detectors = ['testdet.xml']
+geoservice.detectors = [compact_name]
 geoservice.OutputLevel = INFO
 ApplicationMgr().ExtSvc += [geoservice]
 
@@ -81,6 +87,10 @@ field = SimG4MagneticFieldTool("MagneticFieldTool")
 field.FieldOn = True
 field.IntegratorStepper = "ClassicalRK4"
 field.OutputLevel = DEBUG
+if cache_field:
+    field.CacheField = True
+    field.CacheGridStep = 100 * mm
+    field.CacheBox = [-1.6 * m, 1.6 * m, -1.6 * m, 1.6 * m, -20 * m, 20 * m]
 
 # Geant4 service
 from Configurables import SimG4Svc
@@ -117,6 +127,6 @@ ApplicationMgr().TopAlg += [hepmc_converter]
 
 from Configurables import PodioOutput
 output = PodioOutput("output")
-output.filename = "output_magFieldTool.root"
+output.filename = "output_magFieldTool{}.root".format(file_suffix)
 output.outputCommands = ["keep *"]
 ApplicationMgr().TopAlg += [output]
@@ -0,0 +1,59 @@
+# Helpers shared by the job options of the fieldmap tests
+# The options import it with the directory of this file in PYTHONPATH, see SimG4Components/CMakeLists.txt
+import os
+from array import array
+
+import ROOT
+
+
+def step_field(x, y, z):
+    """2 T along z inside |x|, |y| < 1500 mm, no field outside"""
+    return 0., 0., 2. if abs(x) < 1500. and abs(y) < 1500. else 0.
+
+
+def write_map(filename, xs, ys, zs, field=step_field, skip=()):
+    """Write the fieldmap with the nodes in all combinations of the given positions (in mm) into the ntuple
+    of the ROOT file. The field (in T) is given by the function of the position, the nodes in skip are left out.
+    """
+    mapfile = ROOT.TFile.Open(filename, "RECREATE")
+    ntuple = ROOT.TTree("ntuple", "Test fieldmap")
+    branches = {name: array("f", [0.]) for name in ["X", "Y", "Z", "Bx", "By", "Bz"]}
+    for name, value in branches.items():
+        ntuple.Branch(name, value, name + "/F")
+    for x in xs:
+        for y in ys:
+            for z in zs:
+                if (x, y, z) in skip:
+                    continue
+                branches["X"][0] = x
+                branches["Y"][0] = y
+                branches["Z"][0] = z
+                branches["Bx"][0], branches["By"][0], branches["Bz"][0] = field(x, y, z)
+                ntuple.Fill()
+    ntuple.Write()
+    mapfile.Close()
+
+
+# Nodes of the small regular map, 500 mm apart in x and y, 1000 mm in z
+regular_xs = [i * 500. for i in range(-4, 5)]
+regular_ys = [i * 500. for i in range(-4, 5)]
+regular_zs = [i * 1000. for i in range(-6, 7)]
+
+
+def write_regular_map(filename, skip=()):
+    """Small regular 3D fieldmap of the step field, 9 x 9 x 13 nodes"""
+    write_map(filename, regular_xs, regular_ys, regular_zs, skip=skip)
+
+
+def idea_geometry():
+    """Geometry service with the IDEA detector"""
+    from Gaudi.Configuration import INFO
+    from Configurables import GeoSvc
+    geoservice = GeoSvc("GeoSvc")
+    path_to_detectors = os.environ.get("FCCDETECTORS", "")
+    detectors_to_use = [
+        'Detector/DetFCCeeIDEA-LAr/compact/FCCee_DectMaster.xml',
+    ]
+    geoservice.detectors = [os.path.join(path_to_detectors, _det) for _det in detectors_to_use]
+    geoservice.OutputLevel = INFO
+    return geoservice
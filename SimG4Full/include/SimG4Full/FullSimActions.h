@@ -12,9 +12,12 @@
  */
 
 namespace sim {
+struct StepStatistics;
+
 class FullSimActions : public G4VUserActionInitialization {
 public:
-  FullSimActions(bool enableHistory, double aEnergyCut);
+  /// @param[in] stepStatistics if given, steps and tracks are counted there
+  FullSimActions(bool enableHistory, double aEnergyCut, StepStatistics* stepStatistics = nullptr);
   virtual ~FullSimActions();
   /// Create all user actions.
   virtual void Build() const final;
@@ -24,6 +27,8 @@ private:
   bool m_enableHistory;
   /// energy threshold for secondaries to be saved
   double m_energyCut;
+  /// counters of steps and tracks (not owned), nullptr if not counted
+  StepStatistics* m_stepStatistics;
 };
 }
 
@@ -0,0 +1,42 @@
+#ifndef SIMG4FULL_STEPCOUNTINGACTION_H
+#define SIMG4FULL_STEPCOUNTINGACTION_H
+
+#include "G4UserSteppingAction.hh"
+
+#include <atomic>
+#include <cstdint>
+
+/** @class StepCountingAction SimG4Full/SimG4Full/StepCountingAction.h StepCountingAction.h
+ *
+ *  User stepping action that counts the steps and tracks, used to benchmark
+ *  the field propagation settings.
+ */
+
+namespace sim {
+/// Number of steps and tracks simulated so far
+struct StepStatistics {
+  /// Number of steps of all tracks
+  std::atomic<uint64_t> steps{0};
+  /// Number of steps of the charged tracks
+  std::atomic<uint64_t> chargedSteps{0};
+  /// Number of tracks
+  std::atomic<uint64_t> tracks{0};
+  /// Number of charged tracks
+  std::atomic<uint64_t> chargedTracks{0};
+};
+
+class StepCountingAction : public G4UserSteppingAction {
+public:
+  explicit StepCountingAction(StepStatistics& statistics);
+  virtual ~StepCountingAction() = default;
+
+  /// Count the step, and the track on its first step
+  virtual void UserSteppingAction(const G4Step* aStep) final;
+
+private:
+  /// Counters shared with the owner of the action
+  StepStatistics& m_statistics;
+};
+}
+
+#endif /* SIMG4FULL_STEPCOUNTINGACTION_H */
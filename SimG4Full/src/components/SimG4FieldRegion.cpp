@@ -0,0 +1,123 @@
+#include "SimG4FieldRegion.h"
+
+// k4SimGeant4
+#include "SimG4Common/FieldSetup.h"
+
+// Geant4
+#include "G4ChordFinder.hh"
+#include "G4FieldManager.hh"
+#include "G4LogicalVolume.hh"
+#include "G4MagneticField.hh"
+#include "G4TransportationManager.hh"
+#include "G4UniformMagField.hh"
+
+// STD
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+DECLARE_COMPONENT(SimG4FieldRegion)
+
+SimG4FieldRegion::SimG4FieldRegion(const std::string& type, const std::string& name, const IInterface* parent)
+    : AlgTool(type, name, parent) {
+  declareInterface<ISimG4RegionTool>(this);
+}
+
+SimG4FieldRegion::~SimG4FieldRegion() {}
+
+StatusCode SimG4FieldRegion::initialize() {
+  if (AlgTool::initialize().isFailure()) {
+    return StatusCode::FAILURE;
+  }
+  if (m_volumeNames.size() == 0) {
+    error() << "No volume name is specified for the field manager" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  if (m_fieldOff && m_confineGlobalField) {
+    error() << "FieldOff and ConfineGlobalField can't be used together" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  return StatusCode::SUCCESS;
+}
+
+StatusCode SimG4FieldRegion::finalize() { return AlgTool::finalize(); }
+
+StatusCode SimG4FieldRegion::create() {
+  G4TransportationManager* transpManager = G4TransportationManager::GetTransportationManager();
+  G4LogicalVolume* world = (*transpManager->GetWorldsIterator())->GetLogicalVolume();
+
+  // The global field is propagated with different parameters, G4 steppers need non-const field
+  G4FieldManager* globalFieldManager = transpManager->GetFieldManager();
+  G4MagneticField* field = nullptr;
+  if (!m_fieldOff) {
+    field = dynamic_cast<G4MagneticField*>(const_cast<G4Field*>(globalFieldManager->GetDetectorField()));
+    if (!field) {
+      error() << "No global magnetic field found, set the magnetic field tool of SimG4Svc or use FieldOff" << endmsg;
+      return StatusCode::FAILURE;
+    }
+  }
+  // The exact helix is the solution in the uniform field, as in SimG4ConstantMagneticFieldTool.
+  // A stepper other than the default one was requested explicitly and is overridden.
+  std::string stepper = m_integratorStepper;
+  if (dynamic_cast<G4UniformMagField*>(field)) {
+    if (stepper != "ClassicalRK4" && stepper != "ExactHelix") {
+      warning() << "IntegratorStepper " << stepper
+                << " is ignored, the uniform field is propagated with the ExactHelix stepper" << endmsg;
+    }
+    stepper = "ExactHelix";
+  }
+
+  size_t nAttached = 0;
+  std::vector<std::string> missingNames;
+  for (const auto& volumeName : m_volumeNames) {
+    size_t nMatched = 0;
+    for (size_t iDaughter = 0; iDaughter < world->GetNoDaughters(); ++iDaughter) {
+      if (world->GetDaughter(iDaughter)->GetName().find(volumeName) == std::string::npos) {
+        continue;
+      }
+      G4LogicalVolume* volume = world->GetDaughter(iDaughter)->GetLogicalVolume();
+      if (m_fieldOff) {
+        m_fieldManagers.emplace_back(new G4FieldManager());
+        info() << "Turning off the magnetic field in the volume " << volume->GetName() << endmsg;
+      } else {
+        sim::FieldPropagationParameters parameters;
+        parameters.stepper = stepper;
+        parameters.driver = m_integrationDriver;
+        parameters.minStep = m_minStep;
+        parameters.deltaChord = m_deltaChord;
+        parameters.deltaOneStep = m_deltaOneStep;
+        parameters.deltaIntersection = m_deltaIntersection;
+        parameters.minEpsilon = m_minEps;
+        parameters.maxEpsilon = m_maxEps;
+        m_fieldManagers.emplace_back(new G4FieldManager());
+        try {
+          m_chordFinders.emplace_back(sim::setupFieldManager(*m_fieldManagers.back(), field, parameters));
+        } catch (const std::invalid_argument& e) {
+          error() << e.what() << endmsg;
+          return StatusCode::FAILURE;
+        }
+        info() << "Creating field manager with stepper " << stepper << " and driver "
+               << m_integrationDriver.value() << " in the volume " << volume->GetName() << endmsg;
+      }
+      // Daughters with their own field manager keep it
+      volume->SetFieldManager(m_fieldManagers.back().get(), false);
+      nMatched++;
+    }
+    if (nMatched == 0) {
+      missingNames.push_back(volumeName);
+    }
+    nAttached += nMatched;
+  }
+  if (!missingNames.empty()) {
+    for (const auto& volumeName : missingNames) {
+      error() << "No daughter of the world volume matches the name " << volumeName << endmsg;
+    }
+    error() << "Field managers were not attached to all the volumes" << endmsg;
+    return StatusCode::FAILURE;
+  }
+  if (m_confineGlobalField) {
+    globalFieldManager->SetDetectorField(nullptr);
+    info() << "Magnetic field confined to " << nAttached << " volumes, no field outside of them" << endmsg;
+  }
+  return StatusCode::SUCCESS;
+}
@@ -0,0 +1,85 @@
+#ifndef SIMG4FULL_SIMG4FIELDREGION_H
+#define SIMG4FULL_SIMG4FIELDREGION_H
+
+// Gaudi
+#include "GaudiKernel/AlgTool.h"
+#include "GaudiKernel/SystemOfUnits.h"
+
+// FCCSW
+#include "SimG4Interface/ISimG4RegionTool.h"
+
+// STD
+#include <memory>
+#include <vector>
+
+// Geant
+class G4ChordFinder;
+class G4FieldManager;
+
+/** @class SimG4FieldRegion SimG4Full/src/components/SimG4FieldRegion.h SimG4FieldRegion.h
+ *
+ *  Tool attaching a dedicated field manager to the volumes specified in the job
+ *  options (\b'volumeNames'), e.g. calorimeters which don't need the precision
+ *  of the tracker.
+ *  The field manager propagates the global magnetic field (set by the magnetic
+ *  field tool of SimG4Svc) with its own stepper and accuracy parameters, or with
+ *  \b'FieldOff' the volumes are treated as field free and tracks go straight.
+ *  The field manager is applied to all daughters of the volumes which do not
+ *  have their own.
+ *  With \b'ConfineGlobalField' the global field is removed from the world after
+ *  the field managers are attached, so outside of the volumes there is no field
+ *  and Geant4 does not propagate in field at all (e.g. uniform field of the
+ *  SimG4ConstantMagneticFieldTool kept inside the solenoid).
+ *  A uniform global field is always propagated with the ExactHelix stepper.
+ *  Every name has to match at least one daughter of the world volume, the names
+ *  without a match are reported and the initialization fails.
+ */
+
+class SimG4FieldRegion : public AlgTool, virtual public ISimG4RegionTool {
+public:
+  explicit SimG4FieldRegion(const std::string& type, const std::string& name, const IInterface* parent);
+  virtual ~SimG4FieldRegion();
+  /**  Initialize.
+   *   @return status code
+   */
+  virtual StatusCode initialize() final;
+  /**  Finalize.
+   *   @return status code
+   */
+  virtual StatusCode finalize() final;
+  /**  Attach the field managers to the volumes
+   *   @return status code
+   */
+  virtual StatusCode create() final;
+
+private:
+  /// Field managers attached to the volumes
+  std::vector<std::unique_ptr<G4FieldManager>> m_fieldManagers;
+  /// Chord finders of the field managers
+  std::vector<std::unique_ptr<G4ChordFinder>> m_chordFinders;
+  /// Names of the volumes where the field manager should be attached (set by job options)
+  Gaudi::Property<std::vector<std::string>> m_volumeNames{this, "volumeNames", {}, "Names of the volumes"};
+  /// Switch to propagate without field in the volumes
+  Gaudi::Property<bool> m_fieldOff{this, "FieldOff", false, "Switch to turn the field off in the volumes"};
+  /// Switch to keep the global field only in the volumes
+  Gaudi::Property<bool> m_confineGlobalField{this, "ConfineGlobalField", false,
+                                             "Switch to remove the global field outside of the volumes"};
+  /// Minimum epsilon (relative error of position / momentum, see G4 doc for more details)
+  Gaudi::Property<double> m_minEps{this, "MinimumEpsilon", 0, "Minimum epsilon (see G4 documentation)"};
+  /// Maximum epsilon (relative error of position / momentum, see G4 doc for more details)
+  Gaudi::Property<double> m_maxEps{this, "MaximumEpsilon", 0, "Maximum epsilon (see G4 documentation)"};
+  /// This parameter governs accuracy of volume intersection, see G4 doc for more details
+  Gaudi::Property<double> m_deltaChord{this, "DeltaChord", 0, "Missing distance for the chord finder"};
+  /// This parameter is roughly the position error which is acceptable in an integration step
+  Gaudi::Property<double> m_deltaOneStep{this, "DeltaOneStep", 0, "Delta(one-step)"};
+  /// Accuracy of the boundary intersection, see G4 doc for more details
+  Gaudi::Property<double> m_deltaIntersection{this, "DeltaIntersection", 0, "Accuracy of the boundary intersection"};
+  /// Lower limit of the step size, see G4 doc for more details
+  Gaudi::Property<double> m_minStep{this, "MinimumStep", 0.01 * Gaudi::Units::mm, "Minimum step length in field (see G4 documentation)"};
+  /// Name of the integration stepper, see SimG4Common/FieldSetup.h
+  Gaudi::Property<std::string> m_integratorStepper{this, "IntegratorStepper", "ClassicalRK4", "Integrator stepper name"};
+  /// Name of the integration driver
+  Gaudi::Property<std::string> m_integrationDriver{this, "IntegrationDriver", "MagIntDriver", "Integration driver name"};
+};
+
+#endif /* SIMG4FULL_SIMG4FIELDREGION_H */
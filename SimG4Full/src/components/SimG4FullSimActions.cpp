@@ -2,6 +2,7 @@
 
 // FCCSW
 #include "SimG4Full/FullSimActions.h"
+#include "SimG4Full/StepCountingAction.h"
 
 DECLARE_COMPONENT(SimG4FullSimActions)
 
@@ -16,11 +17,26 @@ StatusCode SimG4FullSimActions::initialize() {
   if (AlgTool::initialize().isFailure()) {
     return StatusCode::FAILURE;
   }
+  if (m_countSteps) {
+    m_stepStatistics = std::make_unique<sim::StepStatistics>();
+  }
   return StatusCode::SUCCESS;
 }
 
-StatusCode SimG4FullSimActions::finalize() { return AlgTool::finalize(); }
+StatusCode SimG4FullSimActions::finalize() {
+  if (m_stepStatistics) {
+    const uint64_t steps = m_stepStatistics->steps;
+    const uint64_t tracks = m_stepStatistics->tracks;
+    const uint64_t chargedSteps = m_stepStatistics->chargedSteps;
+    const uint64_t chargedTracks = m_stepStatistics->chargedTracks;
+    info() << "Steps: " << steps << " in " << tracks << " tracks ("
+           << (tracks > 0 ? double(steps) / tracks : 0.) << " steps per track)" << endmsg;
+    info() << "Steps of charged tracks: " << chargedSteps << " in " << chargedTracks << " tracks ("
+           << (chargedTracks > 0 ? double(chargedSteps) / chargedTracks : 0.) << " steps per track)" << endmsg;
+  }
+  return AlgTool::finalize();
+}
 
 G4VUserActionInitialization* SimG4FullSimActions::userActionInitialization() {
-  return new sim::FullSimActions(m_enableHistory, m_energyCut);
+  return new sim::FullSimActions(m_enableHistory, m_energyCut, m_stepStatistics.get());
 }
@@ -9,6 +9,12 @@
 // FCCSW
 #include "SimG4Interface/ISimG4ActionTool.h"
 
+#include <memory>
+
+namespace sim {
+struct StepStatistics;
+}
+
 /** @class SimG4FullSimActions SimG4Full/src/components/SimG4FullSimActions.h SimG4FullSimActions.h
  *
  *  Tool for loading full simulation user action initialization (list of user actions)
@@ -38,6 +44,10 @@ private:
   /// Set to true to save secondary particle info
   Gaudi::Property<bool> m_enableHistory{this, "enableHistory", false, "Set to true to save secondary particle info"};
   Gaudi::Property<double> m_energyCut{this, "energyCut", 0.0 * Gaudi::Units::GeV, "minimum energy for secondaries to be saved"};
+  /// Set to true to count steps and tracks, reported in finalize
+  Gaudi::Property<bool> m_countSteps{this, "countSteps", false, "Set to true to count steps and tracks"};
+  /// Counters of steps and tracks
+  std::unique_ptr<sim::StepStatistics> m_stepStatistics;
 };
 
 #endif /* SIMG4FULL_G4FULLSIMACTIONS_H */
@@ -1,11 +1,13 @@
 #include "SimG4Full/FullSimActions.h"
 #include "SimG4Full/ParticleHistoryAction.h"
 #include "SimG4Full/ParticleHistoryEventAction.h"
+#include "SimG4Full/StepCountingAction.h"
 #include <iostream>
 
 namespace sim {
-FullSimActions::FullSimActions(bool enableHistory, double aEnergyCut)
-    : G4VUserActionInitialization(), m_enableHistory(enableHistory), m_energyCut(aEnergyCut) {}
+FullSimActions::FullSimActions(bool enableHistory, double aEnergyCut, StepStatistics* stepStatistics)
+    : G4VUserActionInitialization(), m_enableHistory(enableHistory), m_energyCut(aEnergyCut),
+      m_stepStatistics(stepStatistics) {}
 
 FullSimActions::~FullSimActions() {}
 
@@ -14,5 +16,8 @@ void FullSimActions::Build() const {
     SetUserAction(new ParticleHistoryEventAction());
     SetUserAction(new ParticleHistoryAction(m_energyCut));
   }
+  if (m_stepStatistics) {
+    SetUserAction(new StepCountingAction(*m_stepStatistics));
+  }
 }
 }
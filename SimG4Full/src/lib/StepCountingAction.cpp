@@ -0,0 +1,26 @@
+#include "SimG4Full/StepCountingAction.h"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+
+namespace sim {
+
+StepCountingAction::StepCountingAction(StepStatistics& statistics) : m_statistics(statistics) {}
+
+void StepCountingAction::UserSteppingAction(const G4Step* aStep) {
+  const G4Track* track = aStep->GetTrack();
+  const bool charged = track->GetDynamicParticle()->GetCharge() != 0.;
+  const bool firstStep = track->GetCurrentStepNumber() == 1;
+
+  m_statistics.steps.fetch_add(1, std::memory_order_relaxed);
+  if (firstStep) {
+    m_statistics.tracks.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (charged) {
+    m_statistics.chargedSteps.fetch_add(1, std::memory_order_relaxed);
+    if (firstStep) {
+      m_statistics.chargedTracks.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+}